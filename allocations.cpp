@@ -0,0 +1,56 @@
+//Heap allocation counting for debug builds
+#include "allocations.h"
+#include <stdlib.h>
+#include <new>
+
+#ifndef NDEBUG
+
+//Allocations made by each thread, so workers loading the next hole don't count against the frame loop
+static thread_local size_t gAllocations = 0;
+
+//Every new expression ends up here, the array and nothrow forms included
+void* operator new( size_t size )
+{
+	++gAllocations;
+	void* memory = malloc( size > 0 ? size : 1 );
+	if( memory == NULL )
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+//Every delete form frees what operator new got from malloc
+void operator delete( void* memory ) noexcept
+{
+	free( memory );
+}
+
+void operator delete( void* memory, size_t ) noexcept
+{
+	free( memory );
+}
+
+void operator delete[]( void* memory ) noexcept
+{
+	free( memory );
+}
+
+void operator delete[]( void* memory, size_t ) noexcept
+{
+	free( memory );
+}
+
+size_t getAllocationCount()
+{
+	return gAllocations;
+}
+
+#else
+
+size_t getAllocationCount()
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,10 @@
+//Heap allocation counting for debug builds, usable without SDL
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include <stddef.h>
+
+//Gets the number of operator new calls the calling thread made so far, always 0 when built with NDEBUG
+size_t getAllocationCount();
+
+#endif
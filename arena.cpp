@@ -0,0 +1,108 @@
+//Bump allocated per level memory
+#include "arena.h"
+#include <algorithm>
+
+//Rounds an address up to a power of two alignment
+static uint8_t* alignPointer( uint8_t* pointer, size_t alignment )
+{
+	return (uint8_t*)( ( (uintptr_t)pointer + alignment - 1 ) & ~(uintptr_t)( alignment - 1 ) );
+}
+
+Arena::Arena()
+{
+	//Initialize
+	mBlock = NULL;
+	mBlockSize = 0;
+	mOffset = 0;
+	mOverflowSize = 0;
+	mUsed = 0;
+}
+
+Arena::~Arena()
+{
+	//Deallocate
+	release();
+}
+
+void* Arena::allocate( size_t size, size_t alignment )
+{
+	mUsed += size;
+
+	//Bump through the main block while it has room
+	if( mBlock != NULL )
+	{
+		uint8_t* start = alignPointer( mBlock + mOffset, alignment );
+		if( start + size <= mBlock + mBlockSize )
+		{
+			mOffset = start + size - mBlock;
+			return start;
+		}
+	}
+
+	//The first allocation makes the main block, later ones overflow until the next reset
+	size_t blockSize = std::max( ARENA_MIN_BLOCK, size + alignment );
+	uint8_t* block = new uint8_t[ blockSize ];
+	if( mBlock == NULL )
+	{
+		mBlock = block;
+		mBlockSize = blockSize;
+		uint8_t* start = alignPointer( mBlock, alignment );
+		mOffset = start + size - mBlock;
+		return start;
+	}
+
+	mOverflow.push_back( block );
+	mOverflowSize += blockSize;
+	return alignPointer( block, alignment );
+}
+
+void Arena::reset()
+{
+	//Grow the main block to fit everything the last level needed
+	if( !mOverflow.empty() )
+	{
+		size_t blockSize = mBlockSize + mOverflowSize;
+		release();
+		mBlock = new uint8_t[ blockSize ];
+		mBlockSize = blockSize;
+	}
+
+	mOffset = 0;
+	mUsed = 0;
+}
+
+void Arena::release()
+{
+	delete[] mBlock;
+	for( size_t i = 0; i < mOverflow.size(); ++i )
+	{
+		delete[] mOverflow[ i ];
+	}
+
+	mBlock = NULL;
+	mBlockSize = 0;
+	mOffset = 0;
+	mOverflow.clear();
+	mOverflowSize = 0;
+	mUsed = 0;
+}
+
+void Arena::swap( Arena& other )
+{
+	std::swap( mBlock, other.mBlock );
+	std::swap( mBlockSize, other.mBlockSize );
+	std::swap( mOffset, other.mOffset );
+	mOverflow.swap( other.mOverflow );
+	std::swap( mOverflowSize, other.mOverflowSize );
+	std::swap( mUsed, other.mUsed );
+}
+
+size_t Arena::getUsed() const
+{
+	return mUsed;
+}
+
+size_t Arena::getCapacity() const
+{
+	return mBlockSize + mOverflowSize;
+}
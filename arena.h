@@ -0,0 +1,68 @@
+//Bump allocated per level memory, usable without SDL
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//The smallest block an arena takes from the heap
+const size_t ARENA_MIN_BLOCK = 4096;
+
+//Alignment given to allocations unless asked otherwise, enough for SIMD loads
+const size_t ARENA_ALIGNMENT = 32;
+
+//Memory handed out by bumping an offset and all given back at once on reset
+class Arena
+{
+	public:
+		//Initializes variables
+		Arena();
+
+		//Deallocates memory
+		~Arena();
+
+		//Gets uninitialized memory that lives until the next reset
+		void* allocate( size_t size, size_t alignment = ARENA_ALIGNMENT );
+
+		//Gets uninitialized memory for count objects
+		template<typename T>
+		T* allocate( size_t count )
+		{
+			return (T*)allocate( count * sizeof( T ) );
+		}
+
+		//Gives back everything, keeping one block big enough for all of it so the next level doesn't touch the heap
+		void reset();
+
+		//Deallocates every block
+		void release();
+
+		//Exchanges memory with another arena
+		void swap( Arena& other );
+
+		//Gets the bytes handed out since the last reset
+		size_t getUsed() const;
+
+		//Gets the bytes held from the heap
+		size_t getCapacity() const;
+
+	private:
+		//Arenas can't be copied since they own their blocks
+		Arena( const Arena& );
+		Arena& operator=( const Arena& );
+
+		//The main block allocations are bumped through
+		uint8_t* mBlock;
+		size_t mBlockSize;
+		size_t mOffset;
+
+		//Blocks taken when the main one ran out, folded into it on reset
+		std::vector<uint8_t*> mOverflow;
+		size_t mOverflowSize;
+
+		//The bytes handed out since the last reset
+		size_t mUsed;
+};
+
+#endif
@@ -0,0 +1,327 @@
+//Images packed into one shared texture
+#include "atlas.h"
+#include <SDL_image.h>
+#include <stdio.h>
+
+//The format images are converted to so they can share the texture
+static const Uint32 ATLAS_FORMAT = SDL_PIXELFORMAT_ARGB8888;
+
+//Creates a clear square surface in the atlas format
+static SDL_Surface* createPixels( int size )
+{
+	SDL_Surface* pixels = SDL_CreateRGBSurfaceWithFormat( 0, size, size, 32, ATLAS_FORMAT );
+	if( pixels == NULL )
+	{
+		printf( "Unable to create atlas surface! SDL Error: %s\n", SDL_GetError() );
+		return NULL;
+	}
+
+	//Copy pixels in as they are, alpha included
+	SDL_SetSurfaceBlendMode( pixels, SDL_BLENDMODE_NONE );
+	SDL_FillRect( pixels, NULL, 0 );
+	return pixels;
+}
+
+TextureAtlas::TextureAtlas()
+{
+	//Initialize
+	mRenderer = NULL;
+	mPixels = NULL;
+	mTexture = NULL;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	//Deallocate
+	free();
+}
+
+void TextureAtlas::setRenderer( SDL_Renderer* renderer )
+{
+	mRenderer = renderer;
+}
+
+int TextureAtlas::find( const std::string& path ) const
+{
+	for( size_t i = 0; i < mEntries.size(); ++i )
+	{
+		if( mEntries[ i ].references > 0 && mEntries[ i ].path == path )
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+int TextureAtlas::acquire( const std::string& path )
+{
+	//Share an image that's already loaded
+	int sprite = find( path );
+	if( sprite != -1 )
+	{
+		++mEntries[ sprite ].references;
+		return sprite;
+	}
+
+	//Load image at specified path
+	SDL_Surface* loadedSurface = IMG_Load( path.c_str() );
+	if( loadedSurface == NULL )
+	{
+		printf( "Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError() );
+		return -1;
+	}
+
+	return acquire( path, loadedSurface );
+}
+
+int TextureAtlas::acquire( const std::string& path, SDL_Surface* loadedSurface )
+{
+	//Share an image that's already loaded, the new copy isn't needed
+	int sprite = find( path );
+	if( sprite != -1 )
+	{
+		SDL_FreeSurface( loadedSurface );
+		++mEntries[ sprite ].references;
+		return sprite;
+	}
+
+	//Color key image
+	SDL_SetColorKey( loadedSurface, SDL_TRUE, SDL_MapRGB( loadedSurface->format, 0, 0xFF, 0xFF ) );
+	SDL_SetSurfaceBlendMode( loadedSurface, SDL_BLENDMODE_NONE );
+
+	//Reuse the slot and space of a released image that's big enough
+	SDL_Rect capacity;
+	for( size_t i = 0; i < mEntries.size() && sprite == -1; ++i )
+	{
+		if( mEntries[ i ].references == 0 && mEntries[ i ].capacity.w >= loadedSurface->w && mEntries[ i ].capacity.h >= loadedSurface->h )
+		{
+			sprite = i;
+			capacity = mEntries[ i ].capacity;
+		}
+	}
+
+	if( sprite == -1 && !pack( loadedSurface->w, loadedSurface->h, capacity ) )
+	{
+		printf( "Unable to fit %s into the texture atlas!\n", path.c_str() );
+		SDL_FreeSurface( loadedSurface );
+		return -1;
+	}
+
+	//The image is drawn from the corner of its slot
+	SDL_Rect area = capacity;
+	area.w = loadedSurface->w;
+	area.h = loadedSurface->h;
+
+	//Keyed pixels are skipped so they stay clear, then the whole slot goes up to the texture
+	SDL_FillRect( mPixels, &capacity, 0 );
+	SDL_Rect destination = area;
+	SDL_BlitSurface( loadedSurface, NULL, mPixels, &destination );
+	SDL_FreeSurface( loadedSurface );
+	if( mTexture != NULL )
+	{
+		const Uint8* pixels = (const Uint8*)mPixels->pixels + capacity.y * mPixels->pitch + capacity.x * 4;
+		SDL_UpdateTexture( mTexture, &capacity, pixels, mPixels->pitch );
+	}
+
+	Entry entry = { path, area, capacity, 1 };
+	if( sprite == -1 )
+	{
+		sprite = mEntries.size();
+		mEntries.push_back( entry );
+	}
+	else
+	{
+		mEntries[ sprite ] = entry;
+	}
+
+	return sprite;
+}
+
+void TextureAtlas::release( int sprite )
+{
+	if( sprite >= 0 && sprite < (int)mEntries.size() && mEntries[ sprite ].references > 0 )
+	{
+		--mEntries[ sprite ].references;
+	}
+}
+
+int TextureAtlas::getReferenceCount( int sprite ) const
+{
+	return mEntries[ sprite ].references;
+}
+
+SDL_Rect TextureAtlas::getClip( int sprite, const SDL_Rect* clip ) const
+{
+	SDL_Rect area = mEntries[ sprite ].area;
+
+	//Clips are relative to the image
+	if( clip != NULL )
+	{
+		area.x += clip->x;
+		area.y += clip->y;
+		area.w = clip->w;
+		area.h = clip->h;
+	}
+
+	return area;
+}
+
+int TextureAtlas::getWidth( int sprite ) const
+{
+	return mEntries[ sprite ].area.w;
+}
+
+int TextureAtlas::getHeight( int sprite ) const
+{
+	return mEntries[ sprite ].area.h;
+}
+
+void TextureAtlas::render( int sprite, int x, int y, const SDL_Rect* clip ) const
+{
+	//Set rendering space and render to screen
+	SDL_Rect source = getClip( sprite, clip );
+	SDL_Rect renderQuad = { x, y, source.w, source.h };
+	SDL_RenderCopy( mRenderer, mTexture, &source, &renderQuad );
+}
+
+void TextureAtlas::draw( SpriteBatch& batch, int sprite, int x, int y, const SDL_Rect* clip ) const
+{
+	//Same rectangles as render, drawn later with the rest of the batch
+	SDL_Rect source = getClip( sprite, clip );
+	SDL_Rect renderQuad = { x, y, source.w, source.h };
+	batch.draw( mTexture, source, renderQuad );
+}
+
+SDL_Texture* TextureAtlas::getTexture() const
+{
+	return mTexture;
+}
+
+bool TextureAtlas::restore()
+{
+	if( mPixels == NULL || mRenderer == NULL )
+	{
+		return false;
+	}
+
+	if( mTexture != NULL )
+	{
+		SDL_DestroyTexture( mTexture );
+	}
+
+	mTexture = SDL_CreateTexture( mRenderer, ATLAS_FORMAT, SDL_TEXTUREACCESS_STATIC, mPixels->w, mPixels->h );
+	if( mTexture == NULL )
+	{
+		printf( "Unable to create atlas texture! SDL Error: %s\n", SDL_GetError() );
+		return false;
+	}
+
+	SDL_SetTextureBlendMode( mTexture, SDL_BLENDMODE_BLEND );
+	SDL_UpdateTexture( mTexture, NULL, mPixels->pixels, mPixels->pitch );
+	return true;
+}
+
+void TextureAtlas::free()
+{
+	//Free texture if it exists
+	if( mTexture != NULL )
+	{
+		SDL_DestroyTexture( mTexture );
+		mTexture = NULL;
+	}
+
+	if( mPixels != NULL )
+	{
+		SDL_FreeSurface( mPixels );
+		mPixels = NULL;
+	}
+
+	mEntries.clear();
+	mShelves.clear();
+}
+
+bool TextureAtlas::pack( int w, int h, SDL_Rect& area )
+{
+	//Start small, most sets of sprites fit
+	if( mPixels == NULL )
+	{
+		mPixels = createPixels( ATLAS_START_SIZE );
+		if( mPixels == NULL || !restore() )
+		{
+			return false;
+		}
+	}
+
+	while( !place( w, h, area ) )
+	{
+		if( !grow() )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool TextureAtlas::place( int w, int h, SDL_Rect& area )
+{
+	int paddedW = w + ATLAS_PADDING;
+	int paddedH = h + ATLAS_PADDING;
+
+	//The lowest shelf that's tall enough and has room wastes the least
+	int best = -1;
+	for( size_t i = 0; i < mShelves.size(); ++i )
+	{
+		if( mShelves[ i ].height >= paddedH && mShelves[ i ].used + paddedW <= mPixels->w &&
+			( best == -1 || mShelves[ i ].height < mShelves[ best ].height ) )
+		{
+			best = i;
+		}
+	}
+
+	//Otherwise open a shelf below the others
+	if( best == -1 )
+	{
+		int top = mShelves.empty() ? 0 : mShelves.back().y + mShelves.back().height;
+		if( top + paddedH > mPixels->h || paddedW > mPixels->w )
+		{
+			return false;
+		}
+
+		Shelf shelf = { top, paddedH, 0 };
+		mShelves.push_back( shelf );
+		best = mShelves.size() - 1;
+	}
+
+	area.x = mShelves[ best ].used;
+	area.y = mShelves[ best ].y;
+	area.w = w;
+	area.h = h;
+	mShelves[ best ].used += paddedW;
+	return true;
+}
+
+bool TextureAtlas::grow()
+{
+	//Stay within what the renderer can hold
+	int size = mPixels->w * 2;
+	SDL_RendererInfo info;
+	if( mRenderer != NULL && SDL_GetRendererInfo( mRenderer, &info ) == 0 && info.max_texture_width > 0 &&
+		( size > info.max_texture_width || size > info.max_texture_height ) )
+	{
+		return false;
+	}
+
+	SDL_Surface* pixels = createPixels( size );
+	if( pixels == NULL )
+	{
+		return false;
+	}
+
+	//Everything keeps its place in the corner of the bigger atlas
+	SDL_BlitSurface( mPixels, NULL, pixels, NULL );
+	SDL_FreeSurface( mPixels );
+	mPixels = pixels;
+	return restore();
+}
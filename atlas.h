@@ -0,0 +1,118 @@
+//Images packed into one shared texture
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+#include "spritebatch.h"
+
+//The size the atlas starts at, it doubles when full up to the renderer's limit
+const int ATLAS_START_SIZE = 512;
+
+//Pixels left between packed images so filtering doesn't bleed across them
+const int ATLAS_PADDING = 1;
+
+//Many images sharing one texture, loaded once per path and kept while referenced
+class TextureAtlas
+{
+	public:
+		//Initializes variables
+		TextureAtlas();
+
+		//Deallocates memory
+		~TextureAtlas();
+
+		//Sets the renderer the atlas texture is made for
+		void setRenderer( SDL_Renderer* renderer );
+
+		//Loads an image into the atlas, or takes another reference to it if it's there, -1 on failure
+		int acquire( const std::string& path );
+
+		//Packs an already loaded image under a path, taking ownership of the surface
+		int acquire( const std::string& path, SDL_Surface* surface );
+
+		//Gets the image loaded from a path without taking a reference, -1 if it isn't there
+		int find( const std::string& path ) const;
+
+		//Drops a reference, the image's space is reused once nothing refers to it
+		void release( int sprite );
+
+		//Gets the references held on an image
+		int getReferenceCount( int sprite ) const;
+
+		//Gets the part of the atlas an image, or a clip within it, covers
+		SDL_Rect getClip( int sprite, const SDL_Rect* clip = NULL ) const;
+
+		//Gets image dimensions
+		int getWidth( int sprite ) const;
+		int getHeight( int sprite ) const;
+
+		//Renders an image, or a clip within it, at given point
+		void render( int sprite, int x, int y, const SDL_Rect* clip = NULL ) const;
+
+		//Queues an image, or a clip within it, to be drawn at given point when the batch is flushed
+		void draw( SpriteBatch& batch, int sprite, int x, int y, const SDL_Rect* clip = NULL ) const;
+
+		//Gets the shared texture
+		SDL_Texture* getTexture() const;
+
+		//Uploads everything again after the renderer lost its textures
+		bool restore();
+
+		//Deallocates every image and the texture
+		void free();
+
+	private:
+		//Atlases can't be copied since they own the texture
+		TextureAtlas( const TextureAtlas& );
+		TextureAtlas& operator=( const TextureAtlas& );
+
+		//An image and where it was packed
+		struct Entry
+		{
+			std::string path;
+
+			//The part the image is drawn from
+			SDL_Rect area;
+
+			//The space the slot was packed with, kept whole so smaller images reusing it don't shrink it
+			SDL_Rect capacity;
+
+			int references;
+		};
+
+		//A row of images of at most its height
+		struct Shelf
+		{
+			int y;
+			int height;
+			int used;
+		};
+
+		//Finds room for an image, growing the atlas if needed
+		bool pack( int w, int h, SDL_Rect& area );
+
+		//Places an image on the shelves without growing
+		bool place( int w, int h, SDL_Rect& area );
+
+		//Doubles the atlas, keeping what's packed
+		bool grow();
+
+		//The renderer the texture belongs to
+		SDL_Renderer* mRenderer;
+
+		//The packed pixels kept in memory to grow and restore from
+		SDL_Surface* mPixels;
+
+		//The shared hardware texture
+		SDL_Texture* mTexture;
+
+		//The images, in sprite order
+		std::vector<Entry> mEntries;
+
+		//The rows images are packed into
+		std::vector<Shelf> mShelves;
+};
+
+#endif
@@ -0,0 +1,380 @@
+//Many balls stepped together with SIMD
+#include "ballbatch.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define BALLBATCH_X86
+#include <immintrin.h>
+#endif
+
+//Balls per widest register, the arrays are padded to this
+static const int BATCH_LANES = 8;
+
+BallBatch::BallBatch()
+{
+	//Initialize
+	mCount = 0;
+	mBlockedRevision = 0;
+}
+
+void BallBatch::clear()
+{
+	mPosX.clear();
+	mPosY.clear();
+	mVelX.clear();
+	mVelY.clear();
+	mHoled.clear();
+	mCount = 0;
+}
+
+int BallBatch::add( const BallState& ball )
+{
+	//Grow by a whole register, padding balls count as dropped in so they never move
+	if( mCount == (int)mPosX.size() )
+	{
+		int padded = mCount + BATCH_LANES;
+		mPosX.resize( padded, 0 );
+		mPosY.resize( padded, 0 );
+		mVelX.resize( padded, 0 );
+		mVelY.resize( padded, 0 );
+		mHoled.resize( padded, -1 );
+	}
+
+	set( mCount, ball );
+	return mCount++;
+}
+
+int BallBatch::getCount() const
+{
+	return mCount;
+}
+
+int BallBatch::getPaddedCount() const
+{
+	return (int)mPosX.size();
+}
+
+BallState BallBatch::get( int i ) const
+{
+	BallState ball;
+	ball.posX = mPosX[ i ];
+	ball.posY = mPosY[ i ];
+	ball.velX = mVelX[ i ];
+	ball.velY = mVelY[ i ];
+	ball.touchingHole = mHoled[ i ] != 0;
+	return ball;
+}
+
+void BallBatch::set( int i, const BallState& ball )
+{
+	mPosX[ i ] = ball.posX;
+	mPosY[ i ] = ball.posY;
+	mVelX[ i ] = ball.velX;
+	mVelY[ i ] = ball.velY;
+	mHoled[ i ] = ball.touchingHole ? -1 : 0;
+}
+
+bool BallBatch::isDone( int i ) const
+{
+	return mHoled[ i ] != 0 || ( mVelX[ i ] == 0 && mVelY[ i ] == 0 );
+}
+
+int BallBatch::getMovingCount() const
+{
+	int moving = 0;
+	for( int i = 0; i < mCount; ++i )
+	{
+		if( !isDone( i ) )
+		{
+			++moving;
+		}
+	}
+
+	return moving;
+}
+
+void BallBatch::prepare( const Course& course )
+{
+	const TileMap& tiles = course.getTiles();
+	if( mBlockedRevision == tiles.getRevision() )
+	{
+		return;
+	}
+
+	//Walls and holes both need the exact scalar step, one bit per tile
+	int totalTiles = tiles.getTotalTiles();
+	mBlocked.assign( totalTiles / 32 + 1, 0 );
+	for( int i = 0; i < totalTiles; ++i )
+	{
+		if( tiles.isWall( i ) || tiles.isHole( i ) )
+		{
+			mBlocked[ i >> 5 ] |= 1u << ( i & 31 );
+		}
+	}
+
+	mBlockedRevision = tiles.getRevision();
+}
+
+void BallBatch::step( const Course& course, float timeStep )
+{
+	//The kernels only know the swept tile tests, field lookups take the scalar step
+	if( course.getCollisionMode() != COLLISION_SWEPT )
+	{
+		stepPortable( course, timeStep );
+		return;
+	}
+
+	prepare( course );
+
+	#ifdef BALLBATCH_X86
+	#if defined(__GNUC__)
+	static const bool hasAVX2 = __builtin_cpu_supports( "avx2" );
+	#else
+	static const bool hasAVX2 = false;
+	#endif
+	if( hasAVX2 )
+	{
+		stepAVX2( course, timeStep );
+	}
+	else
+	{
+		stepSSE2( course, timeStep );
+	}
+	#else
+	stepPortable( course, timeStep );
+	#endif
+}
+
+void BallBatch::stepBlocked( const Course& course, float timeStep, int first, int lanes, int freeMask )
+{
+	for( int lane = 0; lane < lanes; ++lane )
+	{
+		int i = first + lane;
+		if( ( freeMask >> lane ) & 1 || isDone( i ) )
+		{
+			continue;
+		}
+
+		BallState ball = get( i );
+		::step( ball, course, timeStep );
+		set( i, ball );
+	}
+}
+
+void BallBatch::stepPortable( const Course& course, float timeStep )
+{
+	//Every ball takes the scalar step
+	stepBlocked( course, timeStep, 0, mCount, 0 );
+}
+
+#ifdef BALLBATCH_X86
+void BallBatch::stepSSE2( const Course& course, float timeStep )
+{
+	const TileMap& tiles = course.getTiles();
+	float radius = BALL_WIDTH / 2;
+
+	__m128 dt = _mm_set1_ps( timeStep );
+	__m128 damping = _mm_set1_ps( (float)getDamping( timeStep ) );
+	__m128 rest = _mm_set1_ps( BALL_REST_VEL );
+	__m128 negRest = _mm_set1_ps( -BALL_REST_VEL );
+	__m128 r = _mm_set1_ps( radius );
+	__m128 zero = _mm_setzero_ps();
+	__m128 right = _mm_set1_ps( tiles.getWidth() - radius );
+	__m128 bottom = _mm_set1_ps( tiles.getHeight() - radius );
+	__m128 tileWidth = _mm_set1_ps( TILE_WIDTH );
+	__m128 tileHeight = _mm_set1_ps( TILE_HEIGHT );
+	__m128i columns = _mm_set1_epi32( tiles.getColumns() );
+	__m128i rows = _mm_set1_epi32( tiles.getRows() );
+	__m128i one = _mm_set1_epi32( 1 );
+
+	for( int first = 0; first < getPaddedCount(); first += 4 )
+	{
+		__m128 posX = _mm_loadu_ps( &mPosX[ first ] );
+		__m128 posY = _mm_loadu_ps( &mPosY[ first ] );
+		__m128 velX = _mm_loadu_ps( &mVelX[ first ] );
+		__m128 velY = _mm_loadu_ps( &mVelY[ first ] );
+		__m128 holed = _mm_castsi128_ps( _mm_loadu_si128( (const __m128i*)&mHoled[ first ] ) );
+
+		//Skip registers where nothing rolls
+		__m128 resting = _mm_and_ps( _mm_cmpeq_ps( velX, zero ), _mm_cmpeq_ps( velY, zero ) );
+		__m128 active = _mm_andnot_ps( _mm_or_ps( holed, resting ), _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) );
+		int activeMask = _mm_movemask_ps( active );
+		if( activeMask == 0 )
+		{
+			continue;
+		}
+
+		//Move in a straight line
+		__m128 nextX = _mm_add_ps( posX, _mm_mul_ps( velX, dt ) );
+		__m128 nextY = _mm_add_ps( posY, _mm_mul_ps( velY, dt ) );
+
+		//The box swept by the ball has to stay inside the level
+		__m128 minX = _mm_sub_ps( _mm_min_ps( posX, nextX ), r );
+		__m128 maxX = _mm_add_ps( _mm_max_ps( posX, nextX ), r );
+		__m128 minY = _mm_sub_ps( _mm_min_ps( posY, nextY ), r );
+		__m128 maxY = _mm_add_ps( _mm_max_ps( posY, nextY ), r );
+		__m128 inside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( nextX, r ), _mm_cmple_ps( nextX, right ) ),
+			_mm_and_ps( _mm_cmpge_ps( nextY, r ), _mm_cmple_ps( nextY, bottom ) ) );
+		inside = _mm_and_ps( inside, _mm_and_ps( _mm_cmpge_ps( minX, zero ), _mm_cmpge_ps( minY, zero ) ) );
+
+		//And cover at most two by two cells, so its corners name every cell
+		__m128i firstColumn = _mm_cvttps_epi32( _mm_div_ps( minX, tileWidth ) );
+		__m128i lastColumn = _mm_cvttps_epi32( _mm_div_ps( maxX, tileWidth ) );
+		__m128i firstRow = _mm_cvttps_epi32( _mm_div_ps( minY, tileHeight ) );
+		__m128i lastRow = _mm_cvttps_epi32( _mm_div_ps( maxY, tileHeight ) );
+		__m128i fits = _mm_and_si128( _mm_cmplt_epi32( lastColumn, columns ), _mm_cmplt_epi32( lastRow, rows ) );
+		fits = _mm_andnot_si128( _mm_cmpgt_epi32( _mm_sub_epi32( lastColumn, firstColumn ), one ), fits );
+		fits = _mm_andnot_si128( _mm_cmpgt_epi32( _mm_sub_epi32( lastRow, firstRow ), one ), fits );
+		inside = _mm_and_ps( inside, _mm_castsi128_ps( fits ) );
+		int insideMask = _mm_movemask_ps( inside ) & activeMask;
+
+		//Look the corner cells up in the blocked mask
+		int32_t cells[ 4 ][ 4 ];
+		_mm_storeu_si128( (__m128i*)cells[ 0 ], firstColumn );
+		_mm_storeu_si128( (__m128i*)cells[ 1 ], lastColumn );
+		_mm_storeu_si128( (__m128i*)cells[ 2 ], firstRow );
+		_mm_storeu_si128( (__m128i*)cells[ 3 ], lastRow );
+		int freeMask = 0;
+		for( int lane = 0; lane < 4; ++lane )
+		{
+			if( !( ( insideMask >> lane ) & 1 ) )
+			{
+				continue;
+			}
+
+			int topLeft = cells[ 2 ][ lane ] * tiles.getColumns() + cells[ 0 ][ lane ];
+			int topRight = cells[ 2 ][ lane ] * tiles.getColumns() + cells[ 1 ][ lane ];
+			int bottomLeft = cells[ 3 ][ lane ] * tiles.getColumns() + cells[ 0 ][ lane ];
+			int bottomRight = cells[ 3 ][ lane ] * tiles.getColumns() + cells[ 1 ][ lane ];
+			uint32_t blocked = ( mBlocked[ topLeft >> 5 ] >> ( topLeft & 31 ) ) | ( mBlocked[ topRight >> 5 ] >> ( topRight & 31 ) ) |
+				( mBlocked[ bottomLeft >> 5 ] >> ( bottomLeft & 31 ) ) | ( mBlocked[ bottomRight >> 5 ] >> ( bottomRight & 31 ) );
+			if( !( blocked & 1 ) )
+			{
+				freeMask |= 1 << lane;
+			}
+		}
+
+		if( freeMask != 0 )
+		{
+			//Damp and stop slow balls
+			__m128 free = _mm_castsi128_ps( _mm_set_epi32( ( freeMask & 8 ) ? -1 : 0, ( freeMask & 4 ) ? -1 : 0, ( freeMask & 2 ) ? -1 : 0, ( freeMask & 1 ) ? -1 : 0 ) );
+			__m128 dampedX = _mm_mul_ps( velX, damping );
+			__m128 dampedY = _mm_mul_ps( velY, damping );
+			__m128 slow = _mm_and_ps( _mm_and_ps( _mm_cmplt_ps( dampedX, rest ), _mm_cmpgt_ps( dampedX, negRest ) ),
+				_mm_and_ps( _mm_cmplt_ps( dampedY, rest ), _mm_cmpgt_ps( dampedY, negRest ) ) );
+			dampedX = _mm_andnot_ps( slow, dampedX );
+			dampedY = _mm_andnot_ps( slow, dampedY );
+
+			//Keep the blocked balls for the scalar step
+			_mm_storeu_ps( &mPosX[ first ], _mm_or_ps( _mm_and_ps( free, nextX ), _mm_andnot_ps( free, posX ) ) );
+			_mm_storeu_ps( &mPosY[ first ], _mm_or_ps( _mm_and_ps( free, nextY ), _mm_andnot_ps( free, posY ) ) );
+			_mm_storeu_ps( &mVelX[ first ], _mm_or_ps( _mm_and_ps( free, dampedX ), _mm_andnot_ps( free, velX ) ) );
+			_mm_storeu_ps( &mVelY[ first ], _mm_or_ps( _mm_and_ps( free, dampedY ), _mm_andnot_ps( free, velY ) ) );
+		}
+
+		if( ( activeMask & ~freeMask ) != 0 )
+		{
+			stepBlocked( course, timeStep, first, 4, freeMask );
+		}
+	}
+}
+
+__attribute__((target("avx2")))
+void BallBatch::stepAVX2( const Course& course, float timeStep )
+{
+	const TileMap& tiles = course.getTiles();
+	float radius = BALL_WIDTH / 2;
+
+	__m256 dt = _mm256_set1_ps( timeStep );
+	__m256 damping = _mm256_set1_ps( (float)getDamping( timeStep ) );
+	__m256 rest = _mm256_set1_ps( BALL_REST_VEL );
+	__m256 negRest = _mm256_set1_ps( -BALL_REST_VEL );
+	__m256 r = _mm256_set1_ps( radius );
+	__m256 zero = _mm256_setzero_ps();
+	__m256 right = _mm256_set1_ps( tiles.getWidth() - radius );
+	__m256 bottom = _mm256_set1_ps( tiles.getHeight() - radius );
+	__m256 tileWidth = _mm256_set1_ps( TILE_WIDTH );
+	__m256 tileHeight = _mm256_set1_ps( TILE_HEIGHT );
+	__m256i columns = _mm256_set1_epi32( tiles.getColumns() );
+	__m256i rows = _mm256_set1_epi32( tiles.getRows() );
+	__m256i one = _mm256_set1_epi32( 1 );
+	__m256i bitIndex = _mm256_set1_epi32( 31 );
+	__m256i allSet = _mm256_set1_epi32( -1 );
+	const int* blocked = (const int*)&mBlocked[ 0 ];
+
+	for( int first = 0; first < getPaddedCount(); first += 8 )
+	{
+		__m256 posX = _mm256_loadu_ps( &mPosX[ first ] );
+		__m256 posY = _mm256_loadu_ps( &mPosY[ first ] );
+		__m256 velX = _mm256_loadu_ps( &mVelX[ first ] );
+		__m256 velY = _mm256_loadu_ps( &mVelY[ first ] );
+		__m256 holed = _mm256_castsi256_ps( _mm256_loadu_si256( (const __m256i*)&mHoled[ first ] ) );
+
+		//Skip registers where nothing rolls
+		__m256 resting = _mm256_and_ps( _mm256_cmp_ps( velX, zero, _CMP_EQ_OQ ), _mm256_cmp_ps( velY, zero, _CMP_EQ_OQ ) );
+		__m256 active = _mm256_andnot_ps( _mm256_or_ps( holed, resting ), _mm256_castsi256_ps( allSet ) );
+		int activeMask = _mm256_movemask_ps( active );
+		if( activeMask == 0 )
+		{
+			continue;
+		}
+
+		//Move in a straight line
+		__m256 nextX = _mm256_add_ps( posX, _mm256_mul_ps( velX, dt ) );
+		__m256 nextY = _mm256_add_ps( posY, _mm256_mul_ps( velY, dt ) );
+
+		//The box swept by the ball has to stay inside the level
+		__m256 minX = _mm256_sub_ps( _mm256_min_ps( posX, nextX ), r );
+		__m256 maxX = _mm256_add_ps( _mm256_max_ps( posX, nextX ), r );
+		__m256 minY = _mm256_sub_ps( _mm256_min_ps( posY, nextY ), r );
+		__m256 maxY = _mm256_add_ps( _mm256_max_ps( posY, nextY ), r );
+		__m256 inside = _mm256_and_ps( _mm256_and_ps( _mm256_cmp_ps( nextX, r, _CMP_GE_OQ ), _mm256_cmp_ps( nextX, right, _CMP_LE_OQ ) ),
+			_mm256_and_ps( _mm256_cmp_ps( nextY, r, _CMP_GE_OQ ), _mm256_cmp_ps( nextY, bottom, _CMP_LE_OQ ) ) );
+		inside = _mm256_and_ps( inside, _mm256_and_ps( _mm256_cmp_ps( minX, zero, _CMP_GE_OQ ), _mm256_cmp_ps( minY, zero, _CMP_GE_OQ ) ) );
+
+		//And cover at most two by two cells, so its corners name every cell
+		__m256i firstColumn = _mm256_cvttps_epi32( _mm256_div_ps( minX, tileWidth ) );
+		__m256i lastColumn = _mm256_cvttps_epi32( _mm256_div_ps( maxX, tileWidth ) );
+		__m256i firstRow = _mm256_cvttps_epi32( _mm256_div_ps( minY, tileHeight ) );
+		__m256i lastRow = _mm256_cvttps_epi32( _mm256_div_ps( maxY, tileHeight ) );
+		__m256i fits = _mm256_and_si256( _mm256_cmpgt_epi32( columns, lastColumn ), _mm256_cmpgt_epi32( rows, lastRow ) );
+		fits = _mm256_andnot_si256( _mm256_cmpgt_epi32( _mm256_sub_epi32( lastColumn, firstColumn ), one ), fits );
+		fits = _mm256_andnot_si256( _mm256_cmpgt_epi32( _mm256_sub_epi32( lastRow, firstRow ), one ), fits );
+		__m256i usable = _mm256_and_si256( _mm256_and_si256( _mm256_castps_si256( inside ), fits ), _mm256_castps_si256( active ) );
+
+		//Gather the corner cells' bits from the blocked mask, off grid lanes look at cell 0
+		__m256i topLeft = _mm256_and_si256( _mm256_add_epi32( _mm256_mullo_epi32( firstRow, columns ), firstColumn ), usable );
+		__m256i topRight = _mm256_and_si256( _mm256_add_epi32( _mm256_mullo_epi32( firstRow, columns ), lastColumn ), usable );
+		__m256i bottomLeft = _mm256_and_si256( _mm256_add_epi32( _mm256_mullo_epi32( lastRow, columns ), firstColumn ), usable );
+		__m256i bottomRight = _mm256_and_si256( _mm256_add_epi32( _mm256_mullo_epi32( lastRow, columns ), lastColumn ), usable );
+		__m256i bits = _mm256_srlv_epi32( _mm256_i32gather_epi32( blocked, _mm256_srli_epi32( topLeft, 5 ), 4 ), _mm256_and_si256( topLeft, bitIndex ) );
+		bits = _mm256_or_si256( bits, _mm256_srlv_epi32( _mm256_i32gather_epi32( blocked, _mm256_srli_epi32( topRight, 5 ), 4 ), _mm256_and_si256( topRight, bitIndex ) ) );
+		bits = _mm256_or_si256( bits, _mm256_srlv_epi32( _mm256_i32gather_epi32( blocked, _mm256_srli_epi32( bottomLeft, 5 ), 4 ), _mm256_and_si256( bottomLeft, bitIndex ) ) );
+		bits = _mm256_or_si256( bits, _mm256_srlv_epi32( _mm256_i32gather_epi32( blocked, _mm256_srli_epi32( bottomRight, 5 ), 4 ), _mm256_and_si256( bottomRight, bitIndex ) ) );
+		__m256i clear = _mm256_cmpeq_epi32( _mm256_and_si256( bits, one ), _mm256_setzero_si256() );
+		__m256 free = _mm256_castsi256_ps( _mm256_and_si256( usable, clear ) );
+		int freeMask = _mm256_movemask_ps( free );
+
+		if( freeMask != 0 )
+		{
+			//Damp and stop slow balls
+			__m256 dampedX = _mm256_mul_ps( velX, damping );
+			__m256 dampedY = _mm256_mul_ps( velY, damping );
+			__m256 slow = _mm256_and_ps( _mm256_and_ps( _mm256_cmp_ps( dampedX, rest, _CMP_LT_OQ ), _mm256_cmp_ps( dampedX, negRest, _CMP_GT_OQ ) ),
+				_mm256_and_ps( _mm256_cmp_ps( dampedY, rest, _CMP_LT_OQ ), _mm256_cmp_ps( dampedY, negRest, _CMP_GT_OQ ) ) );
+			dampedX = _mm256_andnot_ps( slow, dampedX );
+			dampedY = _mm256_andnot_ps( slow, dampedY );
+
+			//Keep the blocked balls for the scalar step
+			_mm256_storeu_ps( &mPosX[ first ], _mm256_blendv_ps( posX, nextX, free ) );
+			_mm256_storeu_ps( &mPosY[ first ], _mm256_blendv_ps( posY, nextY, free ) );
+			_mm256_storeu_ps( &mVelX[ first ], _mm256_blendv_ps( velX, dampedX, free ) );
+			_mm256_storeu_ps( &mVelY[ first ], _mm256_blendv_ps( velY, dampedY, free ) );
+		}
+
+		if( ( activeMask & ~freeMask ) != 0 )
+		{
+			stepBlocked( course, timeStep, first, 8, freeMask );
+		}
+	}
+}
+#endif
@@ -0,0 +1,70 @@
+//Many balls stepped together with SIMD, usable without SDL
+#ifndef BALLBATCH_H
+#define BALLBATCH_H
+
+#include <stdint.h>
+#include <vector>
+#include "physics.h"
+
+//Balls stored as structure of arrays so whole registers of them step at once
+class BallBatch
+{
+	public:
+		//Initializes variables
+		BallBatch();
+
+		//Removes every ball
+		void clear();
+
+		//Adds a ball and gets its index
+		int add( const BallState& ball );
+
+		//Gets the number of balls
+		int getCount() const;
+
+		//Gets or replaces a ball
+		BallState get( int i ) const;
+		void set( int i, const BallState& ball );
+
+		//Checks if a ball has stopped or dropped in
+		bool isDone( int i ) const;
+
+		//Counts the balls still rolling
+		int getMovingCount() const;
+
+		//Advances every rolling ball by one step
+		void step( const Course& course, float timeStep = PHYSICS_TIMESTEP );
+
+	private:
+		//Rebuilds the blocked cell mask when the course's tiles change
+		void prepare( const Course& course );
+
+		//Gets the arrays rounded up to a whole register of balls
+		int getPaddedCount() const;
+
+		//Steps the balls the vector kernels couldn't move on their own
+		void stepBlocked( const Course& course, float timeStep, int first, int lanes, int freeMask );
+
+		//Kernels for the different instruction sets
+		void stepPortable( const Course& course, float timeStep );
+		#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+		void stepSSE2( const Course& course, float timeStep );
+		void stepAVX2( const Course& course, float timeStep );
+		#endif
+
+		//The ball positions and velocities
+		std::vector<float> mPosX, mPosY;
+		std::vector<float> mVelX, mVelY;
+
+		//Balls that dropped in, as 0 or all bits set
+		std::vector<int32_t> mHoled;
+		int mCount;
+
+		//One bit per tile for walls and holes, padded for gathers
+		std::vector<uint32_t> mBlocked;
+
+		//The revision of the tiles the mask was built from
+		uint32_t mBlockedRevision;
+};
+
+#endif
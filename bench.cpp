@@ -0,0 +1,530 @@
+//Microbenchmarks for the physics, map loading and rendering
+#include "game.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include "ballbatch.h"
+#include "broadphase.h"
+#include "fixedcourse.h"
+#include "telemetry.h"
+
+//Shortest time one measurement runs for in seconds
+const double DEFAULT_MIN_TIME = 0.2;
+
+//Measurements per benchmark, the median is reported
+const int BENCH_REPEATS = 5;
+
+//Slowdown in percent allowed against a baseline
+const double DEFAULT_TOLERANCE = 10;
+
+//Different random inputs each benchmark cycles through
+const int BENCH_INPUTS = 1024;
+
+//Balls in the scramble contact benchmark
+const int BENCH_SCRAMBLE = 64;
+
+//Balls drawn in the crowded render benchmark
+const int BENCH_CROWD = 64;
+
+//Where the compiled copy of the map is written for the load benchmark
+const char* BENCH_COMPILED_MAP = "./bench.gmap";
+
+//Where the telemetry benchmark exports to
+const char* BENCH_TELEMETRY = "./bench.prom";
+
+//A benchmark body runs the measured operation a number of times
+typedef std::function<void( long long )> BenchBody;
+
+//One measured benchmark
+struct BenchResult
+{
+	std::string name;
+	long long iterations;
+	double nsPerOp;
+};
+
+//Keeps results alive so the optimizer can't drop the work
+static volatile double gSink = 0;
+
+//Gets the wall time one run of a body takes in seconds
+static double timeBody( const BenchBody& body, long long iterations )
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	body( iterations );
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+}
+
+//Picks an iteration count that runs for minTime and reports the median of several runs
+static BenchResult measure( const std::string& name, const BenchBody& body, double minTime )
+{
+	BenchResult result;
+	result.name = name;
+
+	//Grow the iterations until a run is long enough
+	long long iterations = 1;
+	for( ;; )
+	{
+		double seconds = timeBody( body, iterations );
+		if( seconds >= minTime || iterations >= ( 1LL << 40 ) )
+		{
+			break;
+		}
+
+		//Aim a little past the target once there's a usable reading
+		double scale = seconds > minTime / 100 ? minTime / seconds * 1.2 : 100;
+		iterations = std::max( iterations + 1, (long long)( iterations * std::min( scale, 100.0 ) ) );
+	}
+
+	std::vector<double> samples;
+	for( int repeat = 0; repeat < BENCH_REPEATS; ++repeat )
+	{
+		samples.push_back( timeBody( body, iterations ) * 1e9 / iterations );
+	}
+	std::nth_element( samples.begin(), samples.begin() + BENCH_REPEATS / 2, samples.end() );
+
+	result.iterations = iterations;
+	result.nsPerOp = samples[ BENCH_REPEATS / 2 ];
+	return result;
+}
+
+//Makes a repeatable random float between low and high
+static float randomFloat( unsigned int& seed, float low, float high )
+{
+	seed = seed * 1103515245 + 12345;
+	return low + ( high - low ) * ( ( seed >> 8 ) & 0xFFFF ) / 65535.f;
+}
+
+//Makes circles spread over the course
+static std::vector<Circle> makeCircles( const Course& course )
+{
+	unsigned int seed = 1;
+	std::vector<Circle> circles( BENCH_INPUTS );
+	for( int i = 0; i < BENCH_INPUTS; ++i )
+	{
+		circles[ i ].x = randomFloat( seed, 0, course.getTiles().getWidth() );
+		circles[ i ].y = randomFloat( seed, 0, course.getTiles().getHeight() );
+		circles[ i ].r = BALL_WIDTH / 2;
+	}
+	return circles;
+}
+
+//Makes moving balls spread over the open parts of the course
+static std::vector<BallState> makeBalls( const Course& course )
+{
+	unsigned int seed = 2;
+	std::vector<BallState> balls;
+	while( (int)balls.size() < BENCH_INPUTS )
+	{
+		BallState ball = makeBall( randomFloat( seed, 10, course.getTiles().getWidth() - 10 ), randomFloat( seed, 10, course.getTiles().getHeight() - 10 ) );
+		ball.velX = randomFloat( seed, -1800, 1800 );
+		ball.velY = randomFloat( seed, -1800, 1800 );
+		if( !touchesWall( getCollider( ball ), course ) )
+		{
+			balls.push_back( ball );
+		}
+	}
+	return balls;
+}
+
+//Reads earlier results, false if the file isn't there
+static bool loadBaseline( const char* path, std::vector<BenchResult>& baseline )
+{
+	FILE* file = fopen( path, "r" );
+	if( file == NULL )
+	{
+		fprintf( stderr, "Unable to open baseline %s!\n", path );
+		return false;
+	}
+
+	char line[ 256 ];
+	while( fgets( line, sizeof( line ), file ) != NULL )
+	{
+		char name[ 128 ];
+		BenchResult result;
+		if( sscanf( line, "%127[^,],%lld,%lf", name, &result.iterations, &result.nsPerOp ) == 3 )
+		{
+			result.name = name;
+			baseline.push_back( result );
+		}
+	}
+
+	fclose( file );
+	return true;
+}
+
+//Sets up a software renderer drawing into memory, no window needed
+static SDL_Surface* initOffscreen()
+{
+	if( SDL_Init( 0 ) < 0 )
+	{
+		fprintf( stderr, "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
+		return NULL;
+	}
+
+	SDL_Surface* screen = SDL_CreateRGBSurfaceWithFormat( 0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32 );
+	if( screen == NULL )
+	{
+		fprintf( stderr, "Offscreen surface could not be created! SDL Error: %s\n", SDL_GetError() );
+		return NULL;
+	}
+
+	gRenderer = SDL_CreateSoftwareRenderer( screen );
+	if( gRenderer == NULL )
+	{
+		fprintf( stderr, "Offscreen renderer could not be created! SDL Error: %s\n", SDL_GetError() );
+		SDL_FreeSurface( screen );
+		return NULL;
+	}
+
+	int imgFlags = IMG_INIT_PNG;
+	if( !( IMG_Init( imgFlags ) & imgFlags ) )
+	{
+		fprintf( stderr, "SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError() );
+	}
+
+	return screen;
+}
+
+int main( int argc, char* args[] )
+{
+	//Read the options
+	const char* mapPath = "./golf.map";
+	const char* filter = NULL;
+	const char* baselinePath = NULL;
+	double minTime = DEFAULT_MIN_TIME;
+	double tolerance = DEFAULT_TOLERANCE;
+	for( int i = 1; i + 1 < argc; i += 2 )
+	{
+		if( strcmp( args[ i ], "--map" ) == 0 ) mapPath = args[ i + 1 ];
+		else if( strcmp( args[ i ], "--filter" ) == 0 ) filter = args[ i + 1 ];
+		else if( strcmp( args[ i ], "--baseline" ) == 0 ) baselinePath = args[ i + 1 ];
+		else if( strcmp( args[ i ], "--min-time" ) == 0 ) minTime = atof( args[ i + 1 ] );
+		else if( strcmp( args[ i ], "--tolerance" ) == 0 ) tolerance = atof( args[ i + 1 ] );
+		else
+		{
+			fprintf( stderr, "Usage: %s [--map <map>] [--filter <text>] [--min-time <seconds>] [--baseline <csv> [--tolerance <percent>]]\n", args[ 0 ] );
+			return 1;
+		}
+	}
+
+	//The swept and field courses share one map
+	Course course;
+	Course fieldCourse;
+	if( !course.loadFromFile( mapPath ) || !fieldCourse.loadFromFile( mapPath ) || !fieldCourse.setCollisionMode( COLLISION_FIELD ) )
+	{
+		fprintf( stderr, "Failed to load tile set!\n" );
+		return 1;
+	}
+	TileMap compiled;
+	if( !compiled.loadFromFile( mapPath ) || !compiled.saveCompiled( BENCH_COMPILED_MAP ) )
+	{
+		fprintf( stderr, "Failed to compile map!\n" );
+		return 1;
+	}
+
+	std::vector<Circle> circles = makeCircles( course );
+	std::vector<BallState> balls = makeBalls( course );
+	const TileMap& tiles = course.getTiles();
+
+	//Every benchmark by name, one operation per iteration
+	std::vector< std::pair<std::string, BenchBody> > benchmarks;
+
+	benchmarks.push_back( std::make_pair( std::string( "checkCollision" ), BenchBody( [ & ]( long long iterations )
+	{
+		int hits = 0;
+		for( long long i = 0; i < iterations; ++i )
+		{
+			hits += checkCollision( circles[ i & ( BENCH_INPUTS - 1 ) ], tiles.getBox( i % tiles.getTotalTiles() ) );
+		}
+		gSink = gSink + hits;
+	} ) ) );
+
+	const Course* courses[ 2 ] = { &course, &fieldCourse };
+	const char* backends[ 2 ] = { "swept", "field" };
+	for( int backend = 0; backend < 2; ++backend )
+	{
+		benchmarks.push_back( std::make_pair( std::string( "touchesWall/" ) + backends[ backend ], BenchBody( [ &, backend ]( long long iterations )
+		{
+			int hits = 0;
+			for( long long i = 0; i < iterations; ++i )
+			{
+				hits += touchesWall( circles[ i & ( BENCH_INPUTS - 1 ) ], *courses[ backend ] );
+			}
+			gSink = gSink + hits;
+		} ) ) );
+
+		benchmarks.push_back( std::make_pair( std::string( "touchesHole/" ) + backends[ backend ], BenchBody( [ &, backend ]( long long iterations )
+		{
+			int hits = 0;
+			for( long long i = 0; i < iterations; ++i )
+			{
+				hits += touchesHole( circles[ i & ( BENCH_INPUTS - 1 ) ], *courses[ backend ] );
+			}
+			gSink = gSink + hits;
+		} ) ) );
+
+		//One step of a moving ball
+		benchmarks.push_back( std::make_pair( std::string( "step/" ) + backends[ backend ], BenchBody( [ &, backend ]( long long iterations )
+		{
+			float total = 0;
+			for( long long i = 0; i < iterations; ++i )
+			{
+				BallState ball = balls[ i & ( BENCH_INPUTS - 1 ) ];
+				step( ball, *courses[ backend ] );
+				total += ball.posX;
+			}
+			gSink = gSink + total;
+		} ) ) );
+	}
+
+	//The same tests through the compiled in stock course, next to the swept ones they match
+	if( STOCK_COURSE.matches( tiles ) )
+	{
+		benchmarks.push_back( std::make_pair( std::string( "touchesWall/fixed" ), BenchBody( [ & ]( long long iterations )
+		{
+			int hits = 0;
+			for( long long i = 0; i < iterations; ++i )
+			{
+				hits += STOCK_COURSE.touchesWall( circles[ i & ( BENCH_INPUTS - 1 ) ] );
+			}
+			gSink = gSink + hits;
+		} ) ) );
+
+		benchmarks.push_back( std::make_pair( std::string( "touchesHole/fixed" ), BenchBody( [ & ]( long long iterations )
+		{
+			int hits = 0;
+			for( long long i = 0; i < iterations; ++i )
+			{
+				hits += STOCK_COURSE.touchesHole( circles[ i & ( BENCH_INPUTS - 1 ) ] );
+			}
+			gSink = gSink + hits;
+		} ) ) );
+
+		benchmarks.push_back( std::make_pair( std::string( "step/fixed" ), BenchBody( [ & ]( long long iterations )
+		{
+			float total = 0;
+			for( long long i = 0; i < iterations; ++i )
+			{
+				BallState ball = balls[ i & ( BENCH_INPUTS - 1 ) ];
+				step( ball, STOCK_COURSE );
+				total += ball.posX;
+			}
+			gSink = gSink + total;
+		} ) ) );
+	}
+
+	//One ball stepped through the batch, refilled before the balls run down
+	benchmarks.push_back( std::make_pair( std::string( "BallBatch::step" ), BenchBody( [ & ]( long long iterations )
+	{
+		BallBatch batch;
+		long long steps = ( iterations + BENCH_INPUTS - 1 ) / BENCH_INPUTS;
+		for( long long i = 0; i < steps; ++i )
+		{
+			if( i % 64 == 0 )
+			{
+				batch.clear();
+				for( int ball = 0; ball < BENCH_INPUTS; ++ball )
+				{
+					batch.add( balls[ ball ] );
+				}
+			}
+			batch.step( course );
+		}
+		gSink = gSink + batch.get( 0 ).posX;
+	} ) ) );
+
+	//One tick of contacts between a full scramble match's balls
+	benchmarks.push_back( std::make_pair( std::string( "Broadphase::findPairs" ), BenchBody( [ & ]( long long iterations )
+	{
+		Broadphase broadphase;
+		std::vector<BodyPair> pairs;
+		std::vector<BallState> scramble( balls.begin(), balls.begin() + BENCH_SCRAMBLE );
+		int contacts = 0;
+		for( long long i = 0; i < iterations; ++i )
+		{
+			broadphase.clear();
+			for( int ball = 0; ball < BENCH_SCRAMBLE; ++ball )
+			{
+				broadphase.insert( ball, getCollider( scramble[ ball ] ) );
+			}
+			broadphase.findPairs( pairs );
+			contacts += collideBalls( scramble, pairs );
+		}
+		gSink = gSink + contacts;
+	} ) ) );
+
+	//What a frame records with telemetry on, exporting once a minute so the export thread stays out of the way
+	Telemetry telemetry;
+	if( telemetry.start( BENCH_TELEMETRY, 60000 ) )
+	{
+		benchmarks.push_back( std::make_pair( std::string( "Telemetry::frame" ), BenchBody( [ & ]( long long iterations )
+		{
+			for( long long i = 0; i < iterations; ++i )
+			{
+				telemetry.count( TELEMETRY_FRAMES );
+				telemetry.observe( TELEMETRY_FRAME_TIME, 16000 + ( i & 1023 ) );
+			}
+			gSink = gSink + telemetry.getCount( TELEMETRY_FRAMES );
+		} ) ) );
+	}
+
+	//The dot rolling from the tee, hit again whenever it stops
+	benchmarks.push_back( std::make_pair( std::string( "Dot::move" ), BenchBody( [ & ]( long long iterations )
+	{
+		BallState tee = makeTeeBall( course );
+		Dot dot( tee.posX, tee.posY );
+		SDL_Event e;
+		memset( &e, 0, sizeof( e ) );
+		for( long long i = 0; i < iterations; ++i )
+		{
+			if( dot.isAtRest() || dot.touchingHole )
+			{
+				dot = Dot( tee.posX, tee.posY );
+				e.type = SDL_MOUSEBUTTONDOWN;
+				e.button.x = 300;
+				e.button.y = 300;
+				dot.handleEvent( e );
+				e.type = SDL_MOUSEBUTTONUP;
+				e.button.x = 300 + ( i % 200 ) - 100;
+				e.button.y = 500;
+				dot.handleEvent( e );
+			}
+			dot.move( course, PHYSICS_TIMESTEP );
+		}
+		gSink = gSink + dot.getState().posX;
+	} ) ) );
+
+	//Loading a level the way loadMedia does
+	benchmarks.push_back( std::make_pair( std::string( "setTiles/text" ), BenchBody( [ & ]( long long iterations )
+	{
+		for( long long i = 0; i < iterations; ++i )
+		{
+			Course loaded;
+			gSink = gSink + ( loaded.loadFromFile( mapPath ) && setTiles( loaded.getTiles() ) );
+		}
+	} ) ) );
+
+	benchmarks.push_back( std::make_pair( std::string( "setTiles/compiled" ), BenchBody( [ & ]( long long iterations )
+	{
+		for( long long i = 0; i < iterations; ++i )
+		{
+			Course loaded;
+			gSink = gSink + ( loaded.loadFromFile( BENCH_COMPILED_MAP ) && setTiles( loaded.getTiles() ) );
+		}
+	} ) ) );
+
+	//Whole frames drawn into memory
+	SDL_Surface* screen = initOffscreen();
+	Course mediaCourse;
+	bool rendering = screen != NULL && loadMedia( mediaCourse, mapPath );
+	if( !rendering )
+	{
+		fprintf( stderr, "Skipping render benchmarks!\n" );
+	}
+	else
+	{
+		BallState tee = makeTeeBall( course );
+		Dot renderDot( tee.posX, tee.posY );
+		SDL_Rect camera = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+		renderDot.setCamera( camera, mediaCourse.getTiles() );
+
+		benchmarks.push_back( std::make_pair( std::string( "renderFrame/tiles" ), BenchBody( [ & ]( long long iterations )
+		{
+			for( long long i = 0; i < iterations; ++i )
+			{
+				SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
+				SDL_RenderClear( gRenderer );
+				renderTiles( mediaCourse.getTiles(), camera );
+				renderDot.render( camera );
+				gSprites.flush( gRenderer );
+				SDL_RenderPresent( gRenderer );
+			}
+		} ) ) );
+
+		benchmarks.push_back( std::make_pair( std::string( "renderFrame/layer" ), BenchBody( [ & ]( long long iterations )
+		{
+			for( long long i = 0; i < iterations; ++i )
+			{
+				SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
+				SDL_RenderClear( gRenderer );
+				gTileLayer.render( mediaCourse.getTiles(), camera );
+				renderDot.render( camera );
+				gSprites.flush( gRenderer );
+				SDL_RenderPresent( gRenderer );
+			}
+		} ) ) );
+
+		//A crowded spectator view, every ball going into the one batch
+		std::vector<BallState> crowd;
+		for( int i = 0; i < BENCH_CROWD; ++i )
+		{
+			crowd.push_back( makeBall( camera.x + ( i % 16 ) * camera.w / 16.f + BALL_WIDTH / 2, camera.y + ( i / 16 ) * BALL_HEIGHT * 2.f + BALL_HEIGHT / 2 ) );
+		}
+		benchmarks.push_back( std::make_pair( std::string( "renderFrame/crowd" ), BenchBody( [ & ]( long long iterations )
+		{
+			for( long long i = 0; i < iterations; ++i )
+			{
+				SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
+				SDL_RenderClear( gRenderer );
+				gTileLayer.render( mediaCourse.getTiles(), camera );
+				for( size_t j = 0; j < crowd.size(); ++j )
+				{
+					renderBall( crowd[ j ], camera );
+				}
+				gSprites.flush( gRenderer );
+				SDL_RenderPresent( gRenderer );
+			}
+		} ) ) );
+	}
+
+	//Results go to standard output as CSV, everything else to standard error
+	std::vector<BenchResult> results;
+	printf( "benchmark,iterations,ns_per_op\n" );
+	for( size_t i = 0; i < benchmarks.size(); ++i )
+	{
+		if( filter != NULL && benchmarks[ i ].first.find( filter ) == std::string::npos )
+		{
+			continue;
+		}
+
+		BenchResult result = measure( benchmarks[ i ].first, benchmarks[ i ].second, minTime );
+		printf( "%s,%lld,%.2f\n", result.name.c_str(), result.iterations, result.nsPerOp );
+		fflush( stdout );
+		results.push_back( result );
+	}
+
+	if( screen != NULL )
+	{
+		close();
+		SDL_FreeSurface( screen );
+	}
+	remove( BENCH_COMPILED_MAP );
+	telemetry.stop();
+	remove( BENCH_TELEMETRY );
+
+	//Fail on anything slower than the baseline allows
+	int regressions = 0;
+	std::vector<BenchResult> baseline;
+	if( baselinePath != NULL && !loadBaseline( baselinePath, baseline ) )
+	{
+		return 1;
+	}
+	for( size_t i = 0; i < results.size(); ++i )
+	{
+		for( size_t j = 0; j < baseline.size(); ++j )
+		{
+			if( baseline[ j ].name == results[ i ].name && results[ i ].nsPerOp > baseline[ j ].nsPerOp * ( 1 + tolerance / 100 ) )
+			{
+				fprintf( stderr, "Regression in %s: %.2f ns/op against %.2f ns/op\n", results[ i ].name.c_str(), results[ i ].nsPerOp, baseline[ j ].nsPerOp );
+				++regressions;
+			}
+		}
+	}
+
+	return regressions == 0 ? 0 : 2;
+}
@@ -0,0 +1,139 @@
+//Spatial hashing of moving bodies so only neighbours are tested
+#include "broadphase.h"
+#include <cmath>
+#include <algorithm>
+
+//Cells in the half of the neighbourhood each body looks at, so each pair is found from one side only
+static const int NEIGHBOUR_COUNT = 5;
+static const int NEIGHBOUR_COLUMNS[ NEIGHBOUR_COUNT ] = { 0, 1, -1, 0, 1 };
+static const int NEIGHBOUR_ROWS[ NEIGHBOUR_COUNT ] = { 0, 0, 1, 1, 1 };
+
+//Orders pairs by their ids so both ends of a match resolve contacts alike
+static bool isEarlierPair( const BodyPair& a, const BodyPair& b )
+{
+	return a.a != b.a ? a.a < b.a : a.b < b.b;
+}
+
+Broadphase::Broadphase()
+{
+	//Initialize
+	mMask = BROADPHASE_MIN_BUCKETS - 1;
+}
+
+void Broadphase::clear()
+{
+	mBodies.clear();
+}
+
+void Broadphase::insert( int id, const Circle& circle )
+{
+	Body body = { id, (int)floor( circle.x / TILE_WIDTH ), (int)floor( circle.y / TILE_HEIGHT ) };
+	mBodies.push_back( body );
+}
+
+int Broadphase::getBodyCount() const
+{
+	return mBodies.size();
+}
+
+uint32_t Broadphase::getBucket( int column, int row ) const
+{
+	return ( (uint32_t)column * 73856093u ^ (uint32_t)row * 19349663u ) & mMask;
+}
+
+void Broadphase::findPairs( std::vector<BodyPair>& pairs )
+{
+	pairs.clear();
+	int count = mBodies.size();
+
+	//Twice as many buckets as bodies keeps them short
+	uint32_t buckets = BROADPHASE_MIN_BUCKETS;
+	while( buckets < (uint32_t)count * 2 )
+	{
+		buckets <<= 1;
+	}
+	mMask = buckets - 1;
+
+	//Group the bodies by bucket with a counting sort
+	mStarts.assign( buckets + 1, 0 );
+	for( int i = 0; i < count; ++i )
+	{
+		++mStarts[ getBucket( mBodies[ i ].column, mBodies[ i ].row ) + 1 ];
+	}
+	for( uint32_t bucket = 0; bucket < buckets; ++bucket )
+	{
+		mStarts[ bucket + 1 ] += mStarts[ bucket ];
+	}
+	mFill.assign( mStarts.begin(), mStarts.end() - 1 );
+	mSorted.resize( count );
+	for( int i = 0; i < count; ++i )
+	{
+		mSorted[ mFill[ getBucket( mBodies[ i ].column, mBodies[ i ].row ) ]++ ] = i;
+	}
+
+	//Bodies no wider than a cell can only touch bodies in the cells around them
+	for( int i = 0; i < count; ++i )
+	{
+		const Body& body = mBodies[ i ];
+		for( int neighbour = 0; neighbour < NEIGHBOUR_COUNT; ++neighbour )
+		{
+			int column = body.column + NEIGHBOUR_COLUMNS[ neighbour ];
+			int row = body.row + NEIGHBOUR_ROWS[ neighbour ];
+			uint32_t bucket = getBucket( column, row );
+			for( int entry = mStarts[ bucket ]; entry < mStarts[ bucket + 1 ]; ++entry )
+			{
+				//Other cells can share the bucket, and bodies in the same cell pair up once
+				int j = mSorted[ entry ];
+				const Body& other = mBodies[ j ];
+				if( other.column != column || other.row != row || ( neighbour == 0 && j <= i ) )
+				{
+					continue;
+				}
+
+				BodyPair pair = { std::min( body.id, other.id ), std::max( body.id, other.id ) };
+				pairs.push_back( pair );
+			}
+		}
+	}
+
+	std::sort( pairs.begin(), pairs.end(), isEarlierPair );
+}
+
+int collideBalls( std::vector<BallState>& balls, const std::vector<BodyPair>& pairs )
+{
+	int contacts = 0;
+	for( size_t i = 0; i < pairs.size(); ++i )
+	{
+		BallState& a = balls[ pairs[ i ].a ];
+		BallState& b = balls[ pairs[ i ].b ];
+		Circle colliderA = getCollider( a );
+		Circle colliderB = getCollider( b );
+
+		//Narrowphase circle test, balls sitting on one another have no direction to part in
+		float reach = colliderA.r + colliderB.r;
+		float distance = distanceSquared( colliderA.x, colliderA.y, colliderB.x, colliderB.y );
+		if( distance >= reach * reach || distance == 0 )
+		{
+			continue;
+		}
+		distance = sqrt( distance );
+		float normalX = ( colliderB.x - colliderA.x ) / distance;
+		float normalY = ( colliderB.y - colliderA.y ) / distance;
+
+		//Balls that overlap while parting, like ones teed off from the same spot, pass through
+		float closing = ( b.velX - a.velX ) * normalX + ( b.velY - a.velY ) * normalY;
+		if( closing >= 0 )
+		{
+			continue;
+		}
+
+		//Equally heavy balls swap their speed along the line between them
+		a.velX += closing * normalX;
+		a.velY += closing * normalY;
+		b.velX -= closing * normalX;
+		b.velY -= closing * normalY;
+		++contacts;
+	}
+
+	return contacts;
+}
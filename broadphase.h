@@ -0,0 +1,68 @@
+//Spatial hashing of moving bodies so only neighbours are tested, usable without SDL
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <stdint.h>
+#include <vector>
+#include "physics.h"
+
+//Bodies are bucketed into cells the size of a tile, so none may be wider than one
+const float BROADPHASE_MAX_RADIUS = TILE_WIDTH / 2;
+
+//Fewest buckets the hash is made with
+const int BROADPHASE_MIN_BUCKETS = 16;
+
+//Two bodies near enough that they might touch, the lower id first
+struct BodyPair
+{
+	int a, b;
+};
+
+//Buckets circles by the tile cell their center is in and pairs up bodies in neighbouring cells
+class Broadphase
+{
+	public:
+		//Initializes variables
+		Broadphase();
+
+		//Empties the hash for the next tick
+		void clear();
+
+		//Adds a body, its circle may be no bigger than BROADPHASE_MAX_RADIUS
+		void insert( int id, const Circle& circle );
+
+		//Gets the bodies added since the last clear
+		int getBodyCount() const;
+
+		//Lists every pair of bodies in the same or neighbouring cells once, in id order
+		void findPairs( std::vector<BodyPair>& pairs );
+
+	private:
+		//A body and the cell it's in
+		struct Body
+		{
+			int id;
+			int column, row;
+		};
+
+		//Gets the bucket a cell hashes to
+		uint32_t getBucket( int column, int row ) const;
+
+		//The bodies in the order they were added
+		std::vector<Body> mBodies;
+
+		//Where each bucket starts in the sorted bodies, with one past the end
+		std::vector<int> mStarts;
+		std::vector<int> mFill;
+
+		//Body indices grouped by bucket
+		std::vector<int> mSorted;
+
+		//The bucket count less one, buckets come in powers of two
+		uint32_t mMask;
+};
+
+//Bounces apart the balls of each pair that touch while closing in, returns how many did
+int collideBalls( std::vector<BallState>& balls, const std::vector<BodyPair>& pairs );
+
+#endif
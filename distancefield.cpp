@@ -0,0 +1,167 @@
+//Signed distance fields baked from tile masks
+#include "distancefield.h"
+#include <stdio.h>
+#include <cmath>
+#include <algorithm>
+
+//Gets the distance from a point to a box, zero inside it
+static float getBoxDistance( const Rect& box, float x, float y )
+{
+	float deltaX = std::max( std::max( box.x - x, x - ( box.x + box.w ) ), 0.f );
+	float deltaY = std::max( std::max( box.y - y, y - ( box.y + box.h ) ), 0.f );
+	return sqrt( deltaX * deltaX + deltaY * deltaY );
+}
+
+DistanceField::DistanceField()
+{
+	//Initialize
+	mSamples = NULL;
+	mColumns = 0;
+	mRows = 0;
+}
+
+bool DistanceField::build( const TileMap& tiles, const uint8_t* mask )
+{
+	free();
+	if( tiles.getTotalTiles() == 0 )
+	{
+		printf( "Unable to bake distance field: The map is empty!\n" );
+		return false;
+	}
+
+	//Sample on the tile corners and every cell in between
+	int columns = tiles.getWidth() / FIELD_CELL_SIZE + 1;
+	int rows = tiles.getHeight() / FIELD_CELL_SIZE + 1;
+	if( (long long)columns * rows > MAX_FIELD_SAMPLES )
+	{
+		printf( "Unable to bake distance field: %dx%d samples is too many!\n", columns, rows );
+		return false;
+	}
+
+	mSamples = mStorage.allocate<float>( (size_t)columns * rows );
+	mColumns = columns;
+	mRows = rows;
+
+	sample( tiles, mask, 0, 0, columns - 1, rows - 1 );
+
+	return true;
+}
+
+void DistanceField::free()
+{
+	mStorage.reset();
+	mSamples = NULL;
+	mColumns = 0;
+	mRows = 0;
+}
+
+bool DistanceField::isBuilt() const
+{
+	return mSamples != NULL;
+}
+
+void DistanceField::swap( DistanceField& other )
+{
+	mStorage.swap( other.mStorage );
+	std::swap( mSamples, other.mSamples );
+	std::swap( mColumns, other.mColumns );
+	std::swap( mRows, other.mRows );
+}
+
+bool DistanceField::update( const TileMap& tiles, const uint8_t* mask, const Rect& area )
+{
+	if( !isBuilt() || mColumns != tiles.getWidth() / FIELD_CELL_SIZE + 1 || mRows != tiles.getHeight() / FIELD_CELL_SIZE + 1 )
+	{
+		return false;
+	}
+
+	//Samples further than the clamp distance from the area can't see the change
+	int firstColumn = std::max( (int)floor( ( area.x - FIELD_MAX_DISTANCE ) / FIELD_CELL_SIZE ), 0 );
+	int lastColumn = std::min( (int)ceil( ( area.x + area.w + FIELD_MAX_DISTANCE ) / FIELD_CELL_SIZE ), mColumns - 1 );
+	int firstRow = std::max( (int)floor( ( area.y - FIELD_MAX_DISTANCE ) / FIELD_CELL_SIZE ), 0 );
+	int lastRow = std::min( (int)ceil( ( area.y + area.h + FIELD_MAX_DISTANCE ) / FIELD_CELL_SIZE ), mRows - 1 );
+	sample( tiles, mask, firstColumn, firstRow, lastColumn, lastRow );
+
+	return true;
+}
+
+void DistanceField::sample( const TileMap& tiles, const uint8_t* mask, int firstColumn, int firstRow, int lastColumn, int lastRow )
+{
+	for( int row = firstRow; row <= lastRow; ++row )
+	{
+		for( int column = firstColumn; column <= lastColumn; ++column )
+		{
+			float x = column * FIELD_CELL_SIZE;
+			float y = row * FIELD_CELL_SIZE;
+
+			//Only tiles within the clamp distance matter
+			int firstTileColumn = std::max( (int)floor( ( x - FIELD_MAX_DISTANCE ) / TILE_WIDTH ), 0 );
+			int lastTileColumn = std::min( (int)floor( ( x + FIELD_MAX_DISTANCE ) / TILE_WIDTH ), tiles.getColumns() - 1 );
+			int firstTileRow = std::max( (int)floor( ( y - FIELD_MAX_DISTANCE ) / TILE_HEIGHT ), 0 );
+			int lastTileRow = std::min( (int)floor( ( y + FIELD_MAX_DISTANCE ) / TILE_HEIGHT ), tiles.getRows() - 1 );
+
+			//Distance out to the masked tiles and in to the rest, off the grid counts as unmasked
+			float outside = FIELD_MAX_DISTANCE;
+			float inside = std::min( std::min( x, tiles.getWidth() - x ), std::min( y, tiles.getHeight() - y ) );
+			inside = std::min( inside, FIELD_MAX_DISTANCE );
+			for( int tileRow = firstTileRow; tileRow <= lastTileRow; ++tileRow )
+			{
+				for( int tileColumn = firstTileColumn; tileColumn <= lastTileColumn; ++tileColumn )
+				{
+					int i = tileRow * tiles.getColumns() + tileColumn;
+					float distance = getBoxDistance( tiles.getBox( i ), x, y );
+					if( ( mask[ i >> 3 ] >> ( i & 7 ) ) & 1 )
+					{
+						outside = std::min( outside, distance );
+					}
+					else
+					{
+						inside = std::min( inside, distance );
+					}
+				}
+			}
+
+			mSamples[ (size_t)row * mColumns + column ] = outside > 0 ? outside : -inside;
+		}
+	}
+}
+
+float DistanceField::getSample( int column, int row ) const
+{
+	return mSamples[ (size_t)row * mColumns + column ];
+}
+
+float DistanceField::getDistance( float x, float y ) const
+{
+	//Find the sample cell, points off the field use its edge
+	float fx = std::min( std::max( x / FIELD_CELL_SIZE, 0.f ), (float)( mColumns - 1 ) );
+	float fy = std::min( std::max( y / FIELD_CELL_SIZE, 0.f ), (float)( mRows - 1 ) );
+	int column = std::min( (int)fx, mColumns - 2 );
+	int row = std::min( (int)fy, mRows - 2 );
+	float u = fx - column;
+	float v = fy - row;
+
+	//Blend the four corner samples
+	float top = getSample( column, row ) + ( getSample( column + 1, row ) - getSample( column, row ) ) * u;
+	float bottom = getSample( column, row + 1 ) + ( getSample( column + 1, row + 1 ) - getSample( column, row + 1 ) ) * u;
+	return top + ( bottom - top ) * v;
+}
+
+void DistanceField::getNormal( float x, float y, float& normalX, float& normalY ) const
+{
+	//Central differences across half a cell
+	float h = FIELD_CELL_SIZE / 2.f;
+	float gradientX = getDistance( x + h, y ) - getDistance( x - h, y );
+	float gradientY = getDistance( x, y + h ) - getDistance( x, y - h );
+	float length = sqrt( gradientX * gradientX + gradientY * gradientY );
+	if( length > 0 )
+	{
+		normalX = gradientX / length;
+		normalY = gradientY / length;
+	}
+	else
+	{
+		normalX = 0;
+		normalY = 0;
+	}
+}
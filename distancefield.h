@@ -0,0 +1,62 @@
+//Signed distance fields baked from tile masks, usable without SDL
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include <stdint.h>
+#include <vector>
+#include "tilemap.h"
+
+//Pixels between distance samples
+const int FIELD_CELL_SIZE = 4;
+
+//Distances are clamped to this many pixels either side of a surface
+const float FIELD_MAX_DISTANCE = TILE_WIDTH;
+
+//Largest number of samples a field may bake
+const int MAX_FIELD_SAMPLES = 1 << 24;
+
+//Distance to the nearest masked tile sampled on a regular grid, negative inside
+class DistanceField
+{
+	public:
+		//Initializes variables
+		DistanceField();
+
+		//Samples the distance to the tiles set in a one bit per tile mask
+		bool build( const TileMap& tiles, const uint8_t* mask );
+
+		//Samples again only where tiles changed within a pixel area can reach, false if the size changed
+		bool update( const TileMap& tiles, const uint8_t* mask, const Rect& area );
+
+		//Deallocates samples
+		void free();
+
+		//Checks if the field was built
+		bool isBuilt() const;
+
+		//Exchanges samples with another field
+		void swap( DistanceField& other );
+
+		//Gets the interpolated distance at a point
+		float getDistance( float x, float y ) const;
+
+		//Gets the direction the distance grows fastest at a point
+		void getNormal( float x, float y, float& normalX, float& normalY ) const;
+
+	private:
+		//Gets the distance stored at a sample
+		float getSample( int column, int row ) const;
+
+		//Samples the distances in a block of the grid, the last column and row included
+		void sample( const TileMap& tiles, const uint8_t* mask, int firstColumn, int firstRow, int lastColumn, int lastRow );
+
+		//The distances in row major order, in storage reset rather than freed between levels
+		Arena mStorage;
+		float* mSamples;
+
+		//The sample grid dimensions
+		int mColumns;
+		int mRows;
+};
+
+#endif
@@ -0,0 +1,253 @@
+//Change notifications for a single file
+#include "filewatcher.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#elif defined( __linux__ )
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <sys/stat.h>
+#endif
+
+//Splits a path into its directory and file name
+static void splitPath( const std::string& path, std::string& directory, std::string& name )
+{
+	size_t slash = path.find_last_of( "/\\" );
+	if( slash == std::string::npos )
+	{
+		directory = ".";
+		name = path;
+	}
+	else
+	{
+		directory = slash == 0 ? path.substr( 0, 1 ) : path.substr( 0, slash );
+		name = path.substr( slash + 1 );
+	}
+}
+
+#if !defined( _WIN32 ) && !defined( __linux__ )
+//Gets when a file was last written, -1 if it can't be read
+static long long getModifiedTime( const std::string& path )
+{
+	struct stat info;
+	if( stat( path.c_str(), &info ) != 0 )
+	{
+		return -1;
+	}
+	return (long long)info.st_mtime;
+}
+#endif
+
+FileWatcher::FileWatcher()
+{
+	//Initialize
+	#if defined( _WIN32 )
+	mDirectory = INVALID_HANDLE_VALUE;
+	mOverlapped = NULL;
+	#elif defined( __linux__ )
+	mHandle = -1;
+	#else
+	mModified = -1;
+	mWatching = false;
+	#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+	//Deallocate
+	close();
+}
+
+bool FileWatcher::watch( const std::string& path )
+{
+	//Get rid of preexisting watch
+	close();
+
+	std::string directory;
+	splitPath( path, directory, mName );
+	if( mName.empty() )
+	{
+		printf( "Unable to watch %s: It isn't a file!\n", path.c_str() );
+		return false;
+	}
+
+	#if defined( _WIN32 )
+	//Editors often save by replacing the file, so the directory is what gets watched
+	mDirectory = CreateFileA( directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL );
+	if( mDirectory == INVALID_HANDLE_VALUE )
+	{
+		printf( "Unable to watch %s!\n", directory.c_str() );
+		return false;
+	}
+
+	OVERLAPPED* overlapped = new OVERLAPPED;
+	memset( overlapped, 0, sizeof( OVERLAPPED ) );
+	overlapped->hEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+	mOverlapped = overlapped;
+	if( overlapped->hEvent == NULL || !readChanges() )
+	{
+		printf( "Unable to watch %s!\n", directory.c_str() );
+		close();
+		return false;
+	}
+	#elif defined( __linux__ )
+	//Editors often save by replacing the file, so the directory is what gets watched
+	mHandle = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if( mHandle < 0 || inotify_add_watch( mHandle, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO ) < 0 )
+	{
+		printf( "Unable to watch %s! %s\n", directory.c_str(), strerror( errno ) );
+		close();
+		return false;
+	}
+	#else
+	//Without change notifications the modification time is checked on every poll
+	mModified = getModifiedTime( path );
+	mWatching = true;
+	#endif
+
+	mPath = path;
+	return true;
+}
+
+void FileWatcher::close()
+{
+	#if defined( _WIN32 )
+	OVERLAPPED* overlapped = (OVERLAPPED*)mOverlapped;
+	if( mDirectory != INVALID_HANDLE_VALUE )
+	{
+		//The read has to finish before its buffer can go
+		CancelIo( mDirectory );
+		if( overlapped != NULL && overlapped->hEvent != NULL )
+		{
+			DWORD bytes;
+			GetOverlappedResult( mDirectory, overlapped, &bytes, TRUE );
+		}
+		CloseHandle( mDirectory );
+		mDirectory = INVALID_HANDLE_VALUE;
+	}
+	if( overlapped != NULL )
+	{
+		if( overlapped->hEvent != NULL )
+		{
+			CloseHandle( overlapped->hEvent );
+		}
+		delete overlapped;
+		mOverlapped = NULL;
+	}
+	#elif defined( __linux__ )
+	if( mHandle >= 0 )
+	{
+		::close( mHandle );
+		mHandle = -1;
+	}
+	#else
+	mModified = -1;
+	mWatching = false;
+	#endif
+
+	mPath.clear();
+	mName.clear();
+}
+
+bool FileWatcher::isWatching() const
+{
+	#if defined( _WIN32 )
+	return mDirectory != INVALID_HANDLE_VALUE;
+	#elif defined( __linux__ )
+	return mHandle >= 0;
+	#else
+	return mWatching;
+	#endif
+}
+
+const std::string& FileWatcher::getPath() const
+{
+	return mPath;
+}
+
+bool FileWatcher::poll()
+{
+	if( !isWatching() )
+	{
+		return false;
+	}
+
+	bool changed = false;
+
+	#if defined( _WIN32 )
+	//Go through every finished read, each one lists the names that changed
+	OVERLAPPED* overlapped = (OVERLAPPED*)mOverlapped;
+	DWORD bytes;
+	while( GetOverlappedResult( mDirectory, overlapped, &bytes, FALSE ) )
+	{
+		//No bytes means the records overflowed, so anything may have changed
+		if( bytes == 0 )
+		{
+			changed = true;
+		}
+
+		const uint8_t* record = (const uint8_t*)mBuffer;
+		while( bytes > 0 )
+		{
+			const FILE_NOTIFY_INFORMATION* information = (const FILE_NOTIFY_INFORMATION*)record;
+			char name[ MAX_PATH ];
+			int length = WideCharToMultiByte( CP_ACP, 0, information->FileName, information->FileNameLength / sizeof( WCHAR ), name, sizeof( name ), NULL, NULL );
+			if( length == (int)mName.size() && _strnicmp( name, mName.c_str(), length ) == 0 )
+			{
+				changed = true;
+			}
+
+			if( information->NextEntryOffset == 0 )
+			{
+				break;
+			}
+			record += information->NextEntryOffset;
+		}
+
+		if( !readChanges() )
+		{
+			printf( "Stopped watching %s!\n", mPath.c_str() );
+			close();
+			break;
+		}
+	}
+	#elif defined( __linux__ )
+	//Drain every waiting event, each one names the file that changed
+	alignas( struct inotify_event ) char buffer[ FILE_WATCH_BUFFER ];
+	ssize_t size;
+	while( ( size = read( mHandle, buffer, sizeof( buffer ) ) ) > 0 )
+	{
+		for( ssize_t offset = 0; offset < size; )
+		{
+			const struct inotify_event* event = (const struct inotify_event*)( buffer + offset );
+			if( event->len > 0 && mName == event->name )
+			{
+				changed = true;
+			}
+			offset += sizeof( struct inotify_event ) + event->len;
+		}
+	}
+	#else
+	long long modified = getModifiedTime( mPath );
+	if( modified != mModified )
+	{
+		mModified = modified;
+		changed = modified != -1;
+	}
+	#endif
+
+	return changed;
+}
+
+#if defined( _WIN32 )
+bool FileWatcher::readChanges()
+{
+	OVERLAPPED* overlapped = (OVERLAPPED*)mOverlapped;
+	ResetEvent( overlapped->hEvent );
+	return ReadDirectoryChangesW( mDirectory, mBuffer, sizeof( mBuffer ), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, NULL, overlapped, NULL ) != 0;
+}
+#endif
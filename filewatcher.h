@@ -0,0 +1,65 @@
+//Change notifications for a single file, usable without SDL
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <stdint.h>
+#include <string>
+
+//Bytes of change records read from the system at once
+const int FILE_WATCH_BUFFER = 4096;
+
+//Watches the directory holding a file and reports when that file is written or replaced
+class FileWatcher
+{
+	public:
+		//Initializes variables
+		FileWatcher();
+
+		//Stops watching
+		~FileWatcher();
+
+		//Starts watching a file, which may not exist yet
+		bool watch( const std::string& path );
+
+		//Stops watching
+		void close();
+
+		//Checks if a file is being watched
+		bool isWatching() const;
+
+		//Gets the watched file
+		const std::string& getPath() const;
+
+		//Checks without blocking if the file changed since the last poll
+		bool poll();
+
+	private:
+		//Watchers can't be copied since they own the system handles
+		FileWatcher( const FileWatcher& );
+		FileWatcher& operator=( const FileWatcher& );
+
+		//The watched file, and its name within its directory
+		std::string mPath;
+		std::string mName;
+
+		#if defined( _WIN32 )
+		//Queues the next overlapped read of directory changes
+		bool readChanges();
+
+		//The directory handle and the overlapped read on it
+		void* mDirectory;
+		void* mOverlapped;
+
+		//Change records land here, aligned the way the system wants
+		uint32_t mBuffer[ FILE_WATCH_BUFFER / 4 ];
+		#elif defined( __linux__ )
+		//The inotify instance
+		int mHandle;
+		#else
+		//The modification time last seen when polling the file
+		long long mModified;
+		bool mWatching;
+		#endif
+};
+
+#endif
@@ -0,0 +1,230 @@
+//Collision and physics specialized at compile time for courses of a fixed size, usable without SDL
+#ifndef FIXEDCOURSE_H
+#define FIXEDCOURSE_H
+
+#include <stdint.h>
+#include "stepping.h"
+
+//The stock course's dimensions in tiles
+const int STOCK_COLUMNS = 7;
+const int STOCK_ROWS = 11;
+
+//The stock golf.map built in, row major
+//Nothing generates this from the map, so any edit to golf.map has to be copied here by hand
+//A stale copy only costs speed, the dot, --simulate and the benchmarks check matches() and fall back to the loaded course
+constexpr uint8_t STOCK_TILES[ STOCK_COLUMNS * STOCK_ROWS ] =
+{
+	1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 2, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1,
+	1, 1, 0, 0, 0, 1, 1,
+	1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1
+};
+
+//A list of row numbers, so every row's mask can be worked out in one constant expression
+template<int... Rows> struct TileRows {};
+template<int Count, int... Rows> struct MakeTileRows : MakeTileRows<Count - 1, Count - 1, Rows...> {};
+template<int... Rows> struct MakeTileRows<0, Rows...> { typedef TileRows<Rows...> Type; };
+
+//Gets one bit per column of a row that holds the tile type, from the column on
+constexpr uint32_t getRowMask( const uint8_t* types, int columns, int row, int type, int column = 0 )
+{
+	return column == columns ? 0 : ( ( types[ row * columns + column ] == type ? 1u : 0u ) << column ) | getRowMask( types, columns, row, type, column + 1 );
+}
+
+//Gets the bits of the columns first to last
+constexpr uint32_t getColumnSpan( int first, int last )
+{
+	return ( last >= 31 ? 0xFFFFFFFFu : ( 2u << last ) - 1 ) & ~( ( 1u << first ) - 1 );
+}
+
+//A course whose size and tiles are known when it's compiled, so the collision tests with it work on row masks
+//The touch tests are branch free, the sweeps skip empty rows in one test but still branch over each wall bit and call sweepCircle
+//Only the swept collision is specialized, loaded maps keep using Course
+template<int Columns, int Rows>
+class FixedCourse
+{
+	static_assert( Columns > 0 && Columns <= 32, "A fixed course row has to fit in a 32 bit mask" );
+	static_assert( Rows > 0, "A fixed course needs a row" );
+	static_assert( BALL_WIDTH < TILE_WIDTH && BALL_HEIGHT < TILE_HEIGHT, "A ball has to cover at most two tiles each way" );
+
+	public:
+		//The map dimensions in pixels
+		static const int WIDTH = Columns * TILE_WIDTH;
+		static const int HEIGHT = Rows * TILE_HEIGHT;
+
+		//Works out the masks from tile types laid out row major, at compile time for constant tiles
+		constexpr FixedCourse( const uint8_t* types ) : FixedCourse( types, typename MakeTileRows<Rows>::Type() ) {}
+
+		//Gets one bit per column of a row's walls or hole tiles
+		constexpr uint32_t getWallRow( int row ) const { return mWallRows[ row ]; }
+		constexpr uint32_t getHoleRow( int row ) const { return mHoleRows[ row ]; }
+
+		//Checks if a loaded map has exactly these tiles, so it can be played through this course
+		bool matches( const TileMap& tiles ) const
+		{
+			if( tiles.getColumns() != Columns || tiles.getRows() != Rows )
+			{
+				return false;
+			}
+
+			for( int i = 0; i < Columns * Rows; ++i )
+			{
+				int bit = i % Columns;
+				if( tiles.isWall( i ) != ( ( mWallRows[ i / Columns ] >> bit ) & 1 ) || tiles.isHole( i ) != ( ( mHoleRows[ i / Columns ] >> bit ) & 1 ) )
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//Checks a collision circle against the walls or the hole, without a branch on the tiles
+		bool touchesWall( const Circle& circle ) const { return touchesMasked( circle, mWallRows ); }
+		bool touchesHole( const Circle& circle ) const { return touchesMasked( circle, mHoleRows ); }
+
+		//Finds the first wall or edge a circle moving by dx, dy hits, in the same order as sweepWalls
+		bool sweepWalls( const Circle& circle, float dx, float dy, SweepHit& hit ) const
+		{
+			bool found = false;
+
+			//The level bounds keep the whole ball inside
+			sweepBounds( circle, dx, dy, WIDTH, HEIGHT, hit, found );
+
+			//Rows without walls on the path are skipped in one test, the others only visit their wall bits
+			int firstColumn, lastColumn, firstRow, lastRow;
+			getSweptCells( circle, dx, dy, firstColumn, lastColumn, firstRow, lastRow );
+			uint32_t span = getColumnSpan( firstColumn, lastColumn );
+			for( int row = firstRow; row <= lastRow; ++row )
+			{
+				for( uint32_t walls = mWallRows[ row ] & span; walls != 0; walls &= walls - 1 )
+				{
+					SweepHit tileHit;
+					if( sweepCircle( circle, dx, dy, getBox( row, __builtin_ctz( walls ) ), tileHit ) )
+					{
+						takeEarlier( hit, found, tileHit.time, tileHit.normalX, tileHit.normalY );
+					}
+				}
+			}
+
+			return found;
+		}
+
+		//Checks if a circle moving by dx, dy starts over or crosses into the hole
+		bool sweepsHole( const Circle& circle, float dx, float dy ) const
+		{
+			int firstColumn, lastColumn, firstRow, lastRow;
+			getSweptCells( circle, dx, dy, firstColumn, lastColumn, firstRow, lastRow );
+			uint32_t span = getColumnSpan( firstColumn, lastColumn );
+			for( int row = firstRow; row <= lastRow; ++row )
+			{
+				for( uint32_t holes = mHoleRows[ row ] & span; holes != 0; holes &= holes - 1 )
+				{
+					SweepHit hit;
+					Rect box = getBox( row, __builtin_ctz( holes ) );
+					if( checkCollision( circle, box ) || sweepCircle( circle, dx, dy, box, hit ) )
+					{
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		//Fills the masks of every listed row
+		template<int... Row>
+		constexpr FixedCourse( const uint8_t* types, TileRows<Row...> ) :
+			mWallRows{ getRowMask( types, Columns, Row, TILE_BLACK )... },
+			mHoleRows{ getRowMask( types, Columns, Row, TILE_YELLOW )... } {}
+
+		//Gets a tile's collision box
+		static Rect getBox( int row, int column )
+		{
+			Rect box = { column * TILE_WIDTH, row * TILE_HEIGHT, TILE_WIDTH, TILE_HEIGHT };
+			return box;
+		}
+
+		//Keeps a grid coordinate on the map
+		static int clampCell( int cell, int cells )
+		{
+			return cell < 0 ? 0 : ( cell >= cells ? cells - 1 : cell );
+		}
+
+		//Gets the cells a circle moving by dx, dy passes over, clamped to the map
+		static void getSweptCells( const Circle& circle, float dx, float dy, int& firstColumn, int& lastColumn, int& firstRow, int& lastRow )
+		{
+			float minX = ( dx < 0 ? circle.x + dx : circle.x ) - circle.r;
+			float maxX = ( dx < 0 ? circle.x : circle.x + dx ) + circle.r;
+			float minY = ( dy < 0 ? circle.y + dy : circle.y ) - circle.r;
+			float maxY = ( dy < 0 ? circle.y : circle.y + dy ) + circle.r;
+
+			//Truncating is flooring here since anything left of or above the map is clamped to the first cell
+			firstColumn = clampCell( (int)( minX / TILE_WIDTH ), Columns );
+			lastColumn = clampCell( (int)( maxX / TILE_WIDTH ), Columns );
+			firstRow = clampCell( (int)( minY / TILE_HEIGHT ), Rows );
+			lastRow = clampCell( (int)( maxY / TILE_HEIGHT ), Rows );
+		}
+
+		//Tests the at most four tiles a circle covers, masking each distance test with the tile's bit
+		static bool touchesMasked( const Circle& circle, const uint32_t* rows )
+		{
+			//The covered cells, found the same way as the swept ones
+			int columns[ 2 ] = { clampCell( (int)( ( circle.x - circle.r ) / TILE_WIDTH ), Columns ), clampCell( (int)( ( circle.x + circle.r ) / TILE_WIDTH ), Columns ) };
+			int cells[ 2 ] = { clampCell( (int)( ( circle.y - circle.r ) / TILE_HEIGHT ), Rows ), clampCell( (int)( ( circle.y + circle.r ) / TILE_HEIGHT ), Rows ) };
+
+			//Most circles cover no masked tile at all, which two row masks tell at once
+			uint32_t span = ( 1u << columns[ 0 ] ) | ( 1u << columns[ 1 ] );
+			if( ( ( rows[ cells[ 0 ] ] | rows[ cells[ 1 ] ] ) & span ) == 0 )
+			{
+				return false;
+			}
+
+			bool touched = false;
+			for( int r = 0; r < 2; ++r )
+			{
+				for( int c = 0; c < 2; ++c )
+				{
+					//The closest point on the tile, clamped with selects rather than branches
+					float left = (float)( columns[ c ] * TILE_WIDTH ), top = (float)( cells[ r ] * TILE_HEIGHT );
+					float closestX = circle.x < left ? left : ( circle.x > left + TILE_WIDTH ? left + TILE_WIDTH : circle.x );
+					float closestY = circle.y < top ? top : ( circle.y > top + TILE_HEIGHT ? top + TILE_HEIGHT : circle.y );
+					float deltaX = circle.x - closestX, deltaY = circle.y - closestY;
+					bool masked = ( rows[ cells[ r ] ] >> columns[ c ] ) & 1;
+					touched |= masked & ( deltaX * deltaX + deltaY * deltaY < circle.r * circle.r );
+				}
+			}
+			return touched;
+		}
+
+		//One bit per column for every row's walls and hole tiles
+		uint32_t mWallRows[ Rows ];
+		uint32_t mHoleRows[ Rows ];
+};
+
+//The stock course, worked out while compiling
+constexpr FixedCourse<STOCK_COLUMNS, STOCK_ROWS> STOCK_COURSE( STOCK_TILES );
+static_assert( STOCK_COURSE.getHoleRow( 1 ) == 1u << 3 && STOCK_COURSE.getWallRow( 4 ) == 7u << 2, "The stock course masks are worked out at compile time" );
+
+//Moves the ball through a fixed course, bouncing the same as step does on the equal loaded course
+template<int Columns, int Rows>
+int step( BallState& ball, const FixedCourse<Columns, Rows>& course, float timeStep = PHYSICS_TIMESTEP )
+{
+	return stepThrough( ball, course, timeStep );
+}
+
+//Hits the ball from start and steps through a fixed course until it rests or drops in
+template<int Columns, int Rows>
+ShotResult simulateShot( const FixedCourse<Columns, Rows>& course, const BallState& start, float velX, float velY, int maxSteps = MAX_SHOT_STEPS )
+{
+	return simulateShotThrough( course, start, velX, velY, maxSteps );
+}
+
+#endif
@@ -0,0 +1,965 @@
+//The SDL side of the game: textures, the dot and the screen
+#include "game.h"
+#include "fixedcourse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+//The window we'll be rendering to
+SDL_Window* gWindow = NULL;
+
+//The window renderer
+SDL_Renderer* gRenderer = NULL;
+
+//Scene textures, packed together so drawing the scene never switches texture
+TextureAtlas gAtlas;
+int gDotSprite = -1;
+int gTileSprite = -1;
+SDL_Rect gTileClips[ TOTAL_TILE_SPRITES ];
+
+//The frame's sprite batch
+SpriteBatch gSprites;
+
+//The cached level render
+TileLayer gTileLayer;
+
+//The low power mode repaint tracking
+DirtyRegions gDirtyRegions;
+
+LTexture::LTexture()
+{
+	//Initialize
+	mTexture = NULL;
+	mWidth = 0;
+	mHeight = 0;
+}
+
+LTexture::~LTexture()
+{
+	//Deallocate
+	free();
+}
+
+bool LTexture::loadFromFile( const std::string& path )
+{
+	//Get rid of preexisting texture
+	free();
+
+	//The final texture
+	SDL_Texture* newTexture = NULL;
+
+	//Load image at specified path
+	SDL_Surface* loadedSurface = IMG_Load( path.c_str() );
+	if( loadedSurface == NULL )
+	{
+		printf( "Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError() );
+	}
+	else
+	{
+		//Color key image
+		SDL_SetColorKey( loadedSurface, SDL_TRUE, SDL_MapRGB( loadedSurface->format, 0, 0xFF, 0xFF ) );
+
+		//Create texture from surface pixels
+        newTexture = SDL_CreateTextureFromSurface( gRenderer, loadedSurface );
+		if( newTexture == NULL )
+		{
+			printf( "Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError() );
+		}
+		else
+		{
+			//Get image dimensions
+			mWidth = loadedSurface->w;
+			mHeight = loadedSurface->h;
+		}
+
+		//Get rid of old loaded surface
+		SDL_FreeSurface( loadedSurface );
+	}
+
+	//Return success
+	mTexture = newTexture;
+	return mTexture != NULL;
+}
+
+#if defined(SDL_TTF_MAJOR_VERSION)
+bool LTexture::loadFromRenderedText( const std::string& textureText, SDL_Color textColor )
+{
+	//Get rid of preexisting texture
+	free();
+
+	//Render text surface
+	SDL_Surface* textSurface = TTF_RenderText_Solid( gFont, textureText.c_str(), textColor );
+	if( textSurface != NULL )
+	{
+		//Create texture from surface pixels
+        mTexture = SDL_CreateTextureFromSurface( gRenderer, textSurface );
+		if( mTexture == NULL )
+		{
+			printf( "Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError() );
+		}
+		else
+		{
+			//Get image dimensions
+			mWidth = textSurface->w;
+			mHeight = textSurface->h;
+		}
+
+		//Get rid of old surface
+		SDL_FreeSurface( textSurface );
+	}
+	else
+	{
+		printf( "Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError() );
+	}
+
+
+	//Return success
+	return mTexture != NULL;
+}
+#endif
+
+void LTexture::free()
+{
+	//Free texture if it exists
+	if( mTexture != NULL )
+	{
+		SDL_DestroyTexture( mTexture );
+		mTexture = NULL;
+		mWidth = 0;
+		mHeight = 0;
+	}
+}
+
+void LTexture::setColor( Uint8 red, Uint8 green, Uint8 blue )
+{
+	//Modulate texture rgb
+	SDL_SetTextureColorMod( mTexture, red, green, blue );
+}
+
+void LTexture::setBlendMode( SDL_BlendMode blending )
+{
+	//Set blending function
+	SDL_SetTextureBlendMode( mTexture, blending );
+}
+
+void LTexture::setAlpha( Uint8 alpha )
+{
+	//Modulate texture alpha
+	SDL_SetTextureAlphaMod( mTexture, alpha );
+}
+
+void LTexture::render( int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip )
+{
+	//Set rendering space and render to screen
+	SDL_Rect renderQuad = { x, y, mWidth, mHeight };
+
+	//Set clip rendering dimensions
+	if( clip != NULL )
+	{
+		renderQuad.w = clip->w;
+		renderQuad.h = clip->h;
+	}
+
+	//Render to screen, only paying for the rotation when there is one
+	if( angle == 0.0 && center == NULL && flip == SDL_FLIP_NONE )
+	{
+		SDL_RenderCopy( gRenderer, mTexture, clip, &renderQuad );
+	}
+	else
+	{
+		SDL_RenderCopyEx( gRenderer, mTexture, clip, &renderQuad, angle, center, flip );
+	}
+}
+
+int LTexture::getWidth()
+{
+	return mWidth;
+}
+
+int LTexture::getHeight()
+{
+	return mHeight;
+}
+
+TileLayer::TileLayer()
+{
+	//Initialize
+	mTexture = NULL;
+	mWidth = 0;
+	mHeight = 0;
+	mDirty = true;
+	mFallback = false;
+}
+
+TileLayer::~TileLayer()
+{
+	//Deallocate
+	free();
+}
+
+void TileLayer::invalidate()
+{
+	mDirty = true;
+}
+
+void TileLayer::update( const TileMap& tiles, const std::vector<int>& changed )
+{
+	//A layer waiting to be built or drawn tile by tile picks the changes up anyway
+	if( mDirty || mFallback || mTexture == NULL || mWidth != tiles.getWidth() || mHeight != tiles.getHeight() )
+	{
+		mDirty = true;
+		return;
+	}
+
+	if( SDL_SetRenderTarget( gRenderer, mTexture ) < 0 )
+	{
+		mDirty = true;
+		return;
+	}
+
+	//Clear behind each changed tile then draw it again
+	SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
+	for( size_t i = 0; i < changed.size(); ++i )
+	{
+		Rect box = tiles.getBox( changed[ i ] );
+		SDL_Rect cell = { box.x, box.y, box.w, box.h };
+		SDL_RenderFillRect( gRenderer, &cell );
+		gAtlas.draw( gSprites, gTileSprite, box.x, box.y, &gTileClips[ tiles.getType( changed[ i ] ) ] );
+	}
+	gSprites.flush( gRenderer );
+	SDL_SetRenderTarget( gRenderer, NULL );
+}
+
+void TileLayer::free()
+{
+	//Free texture if it exists
+	if( mTexture != NULL )
+	{
+		SDL_DestroyTexture( mTexture );
+		mTexture = NULL;
+		mWidth = 0;
+		mHeight = 0;
+	}
+
+	mDirty = true;
+}
+
+bool TileLayer::build( const TileMap& tiles )
+{
+	//The renderer has to be able to draw into textures
+	if( !SDL_RenderTargetSupported( gRenderer ) )
+	{
+		return false;
+	}
+
+	//The whole level has to fit into one texture
+	SDL_RendererInfo info;
+	if( SDL_GetRendererInfo( gRenderer, &info ) < 0 ||
+		( info.max_texture_width > 0 && tiles.getWidth() > info.max_texture_width ) ||
+		( info.max_texture_height > 0 && tiles.getHeight() > info.max_texture_height ) )
+	{
+		return false;
+	}
+
+	//Reuse the texture unless the level size changed
+	if( mTexture == NULL || mWidth != tiles.getWidth() || mHeight != tiles.getHeight() )
+	{
+		free();
+
+		mTexture = SDL_CreateTexture( gRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, tiles.getWidth(), tiles.getHeight() );
+		if( mTexture == NULL )
+		{
+			printf( "Unable to create tile layer! SDL Error: %s\n", SDL_GetError() );
+			return false;
+		}
+
+		mWidth = tiles.getWidth();
+		mHeight = tiles.getHeight();
+	}
+
+	//Draw the tiles into the layer
+	if( SDL_SetRenderTarget( gRenderer, mTexture ) < 0 )
+	{
+		return false;
+	}
+	SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
+	SDL_RenderClear( gRenderer );
+	SDL_Rect level = { 0, 0, tiles.getWidth(), tiles.getHeight() };
+	renderTiles( tiles, level );
+	gSprites.flush( gRenderer );
+	SDL_SetRenderTarget( gRenderer, NULL );
+
+	return true;
+}
+
+void TileLayer::render( const TileMap& tiles, const SDL_Rect& camera )
+{
+	//Redraw the layer if the tiles changed
+	if( mDirty )
+	{
+		mFallback = !build( tiles );
+		mDirty = false;
+	}
+
+	//Draw each tile if the layer couldn't be built
+	if( mFallback )
+	{
+		renderTiles( tiles, camera );
+		return;
+	}
+
+	//Show the part of the level in view in one copy
+	SDL_Rect level = { 0, 0, mWidth, mHeight };
+	SDL_Rect visible;
+	if( SDL_IntersectRect( &level, &camera, &visible ) )
+	{
+		SDL_Rect renderQuad = { visible.x - camera.x, visible.y - camera.y, visible.w, visible.h };
+		SDL_RenderCopy( gRenderer, mTexture, &visible, &renderQuad );
+	}
+}
+
+DirtyRegions::DirtyRegions()
+{
+	//Initialize
+	mFrame = NULL;
+	mCount = 0;
+	mFull = true;
+}
+
+DirtyRegions::~DirtyRegions()
+{
+	//Deallocate
+	free();
+}
+
+void DirtyRegions::add( const SDL_Rect& region )
+{
+	//Nothing to repaint for an empty region
+	if( region.w <= 0 || region.h <= 0 )
+	{
+		return;
+	}
+
+	//Track the region unless everything gets repainted anyway
+	if( mCount < MAX_REGIONS )
+	{
+		mRegions[ mCount++ ] = region;
+	}
+	else
+	{
+		mFull = true;
+	}
+}
+
+void DirtyRegions::invalidate()
+{
+	mFull = true;
+}
+
+bool DirtyRegions::isDirty()
+{
+	return mFull || mCount > 0;
+}
+
+void DirtyRegions::free()
+{
+	//Free texture if it exists
+	if( mFrame != NULL )
+	{
+		SDL_DestroyTexture( mFrame );
+		mFrame = NULL;
+	}
+
+	mFull = true;
+}
+
+void DirtyRegions::repaint( const TileMap& tiles, Dot& dot, const SDL_Rect& camera, const SDL_Rect* region )
+{
+	//Only touch pixels inside the region
+	SDL_RenderSetClipRect( gRenderer, region );
+
+	//Clear behind the level
+	SDL_Rect screen = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+	SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
+	SDL_RenderFillRect( gRenderer, region != NULL ? region : &screen );
+
+	//Render level
+	gTileLayer.render( tiles, camera );
+
+	//Render dot
+	dot.render( camera );
+	gSprites.flush( gRenderer );
+	dot.renderAim( camera );
+
+	SDL_RenderSetClipRect( gRenderer, NULL );
+}
+
+void DirtyRegions::present( const TileMap& tiles, Dot& dot, const SDL_Rect& camera )
+{
+	//Nothing changed so the last frame is still on screen
+	if( !isDirty() )
+	{
+		return;
+	}
+
+	//Keep a copy of the screen to repaint into
+	if( mFrame == NULL && SDL_RenderTargetSupported( gRenderer ) )
+	{
+		mFrame = SDL_CreateTexture( gRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT );
+		mFull = true;
+	}
+
+	if( mFrame != NULL && SDL_SetRenderTarget( gRenderer, mFrame ) == 0 )
+	{
+		//Repaint what changed
+		if( mFull )
+		{
+			repaint( tiles, dot, camera, NULL );
+		}
+		else
+		{
+			for( int i = 0; i < mCount; ++i )
+			{
+				repaint( tiles, dot, camera, &mRegions[ i ] );
+			}
+		}
+
+		//Show the frame
+		SDL_SetRenderTarget( gRenderer, NULL );
+		SDL_RenderCopy( gRenderer, mFrame, NULL, NULL );
+	}
+	else
+	{
+		//Without a frame copy the whole screen is redrawn
+		repaint( tiles, dot, camera, NULL );
+	}
+
+	//Update screen
+	SDL_RenderPresent( gRenderer );
+
+	mCount = 0;
+	mFull = false;
+}
+
+Dot::Dot( float x, float y )
+{
+    //Initialize the offsets and velocity
+    mBall = makeBall( x, y );
+    mStroke = makeStrokeInput();
+    mAiming = false;
+    mAimX = mAimY = 0;
+    mPath = NULL;
+    mStockRevision = 0;
+    mStock = false;
+    mPrevX = mRenderX = mBall.posX;
+    mPrevY = mRenderY = mBall.posY;
+
+		//Move collider relative to the circle
+		shiftColliders();
+}
+
+void Dot::handleEvent( SDL_Event& e )
+{
+		//Strokes are played by dragging away from where the mouse went down
+		if( e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP )
+		{
+			handleMouseButton( e.type == SDL_MOUSEBUTTONDOWN, e.button.x, e.button.y );
+		}
+}
+
+void Dot::handleMouseButton( bool down, int x, int y )
+{
+		//Presses only count while the dot is at rest, like the stroke itself
+		if( applyMouseButton( mBall, mStroke, down, x, y ) )
+		{
+			numStrokes++;
+		}
+		mAiming = down && isAtRest();
+		mAimX = x;
+		mAimY = y;
+}
+
+int Dot::move( const Course& course, float timeStep )
+{
+		//Remember where the dot came from for interpolation
+		mPrevX = mBall.posX;
+		mPrevY = mBall.posY;
+
+		//The stock map steps through the course specialized for it, checked again only when the tiles change
+		if( mStockRevision != course.getTiles().getRevision() )
+		{
+			mStockRevision = course.getTiles().getRevision();
+			mStock = STOCK_COURSE.matches( course.getTiles() );
+		}
+
+		//Step the ball through the course
+		int bounces = mStock && course.getCollisionMode() == COLLISION_SWEPT ? step( mBall, STOCK_COURSE, timeStep ) : step( mBall, course, timeStep );
+
+		//Move the collision circle along with the ball
+		shiftColliders();
+
+		if (mBall.touchingHole) {
+			touchingHole = true;
+		}
+
+		return bounces;
+}
+
+void Dot::interpolate( float alpha )
+{
+	mRenderX = mPrevX + ( mBall.posX - mPrevX ) * alpha;
+	mRenderY = mPrevY + ( mBall.posY - mPrevY ) * alpha;
+}
+
+void Dot::render( const SDL_Rect& camera )
+{
+    //Show the dot relative to the camera
+	gAtlas.draw( gSprites, gDotSprite, int(mRenderX - mCollider.r) - camera.x, int(mRenderY - mCollider.r) - camera.y );
+}
+
+void Dot::setAim( int x, int y )
+{
+	mAimX = x;
+	mAimY = y;
+}
+
+void Dot::getAimVelocity( float& velX, float& velY )
+{
+	//Same as the stroke a release here would play
+	velX = ( mStroke.downX - mAimX ) * DRAG_VELOCITY;
+	velY = ( mStroke.downY - mAimY ) * DRAG_VELOCITY;
+}
+
+void Dot::setPath( const PredictedPath* path )
+{
+	mPath = path;
+}
+
+void Dot::renderAim( const SDL_Rect& camera )
+{
+	if( !mAiming )
+	{
+		return;
+	}
+
+	//The ball goes the way the drag points away from the press
+	int centerX = int(mRenderX) - camera.x;
+	int centerY = int(mRenderY) - camera.y;
+	SDL_SetRenderDrawColor( gRenderer, 0x40, 0x40, 0x40, 0xFF );
+	if( mPath == NULL || mPath->count < 2 )
+	{
+		SDL_RenderDrawLine( gRenderer, centerX, centerY, centerX + mStroke.downX - mAimX, centerY + mStroke.downY - mAimY );
+		return;
+	}
+
+	//Follow the predicted path through its bounces
+	SDL_Point points[ PREDICT_MAX_POINTS ];
+	for( int i = 0; i < mPath->count; ++i )
+	{
+		points[ i ].x = int(mPath->points[ i ].x) - camera.x;
+		points[ i ].y = int(mPath->points[ i ].y) - camera.y;
+	}
+	SDL_RenderDrawLines( gRenderer, points, mPath->count );
+}
+
+SDL_Rect Dot::getAimBox( const SDL_Rect& camera )
+{
+	SDL_Rect box = { 0, 0, 0, 0 };
+	if( mAiming )
+	{
+		int centerX = int(mRenderX) - camera.x;
+		int centerY = int(mRenderY) - camera.y;
+		int minX = centerX, maxX = centerX + mStroke.downX - mAimX;
+		int minY = centerY, maxY = centerY + mStroke.downY - mAimY;
+		if( minX > maxX )
+		{
+			std::swap( minX, maxX );
+		}
+		if( minY > maxY )
+		{
+			std::swap( minY, maxY );
+		}
+
+		//A predicted path can wander anywhere past the drag line
+		if( mPath != NULL )
+		{
+			for( int i = 0; i < mPath->count; ++i )
+			{
+				int x = int(mPath->points[ i ].x) - camera.x;
+				int y = int(mPath->points[ i ].y) - camera.y;
+				minX = std::min( minX, x );
+				maxX = std::max( maxX, x );
+				minY = std::min( minY, y );
+				maxY = std::max( maxY, y );
+			}
+		}
+
+		box.x = minX;
+		box.y = minY;
+		box.w = maxX - minX + 1;
+		box.h = maxY - minY + 1;
+	}
+	return box;
+}
+
+bool Dot::isAiming()
+{
+	return mAiming;
+}
+
+void Dot::setCamera( SDL_Rect& camera, const TileMap& tiles )
+{
+	centerCamera( camera, mRenderX, mRenderY, tiles );
+}
+
+Circle& Dot::getCollider()
+{
+	return mCollider;
+}
+
+SDL_Rect Dot::getBox( const SDL_Rect& camera )
+{
+	SDL_Rect box = { int(mRenderX - mCollider.r) - camera.x, int(mRenderY - mCollider.r) - camera.y, DOT_WIDTH, DOT_HEIGHT };
+	return box;
+}
+
+bool Dot::isAtRest()
+{
+	return ::isAtRest( mBall );
+}
+
+const BallState& Dot::getState() const
+{
+	return mBall;
+}
+
+void Dot::shiftColliders()
+{
+	//Align collider to center of dot
+	mCollider = ::getCollider( mBall );
+	//std::cout << "collsion point at: " << (mCollider.x) << (mCollider.y) << std::endl;
+}
+
+LTimer::LTimer()
+{
+    //Initialize the variables
+    mStartTicks = 0;
+    mPausedTicks = 0;
+
+    mPaused = false;
+    mStarted = false;
+}
+
+void LTimer::start()
+{
+    //Start the timer
+    mStarted = true;
+
+    //Unpause the timer
+    mPaused = false;
+
+    //Get the current clock time
+    mStartTicks = SDL_GetTicks();
+	mPausedTicks = 0;
+}
+
+void LTimer::stop()
+{
+    //Stop the timer
+    mStarted = false;
+
+    //Unpause the timer
+    mPaused = false;
+
+	//Clear tick variables
+	mStartTicks = 0;
+	mPausedTicks = 0;
+}
+
+void LTimer::pause()
+{
+    //If the timer is running and isn't already paused
+    if( mStarted && !mPaused )
+    {
+        //Pause the timer
+        mPaused = true;
+
+        //Calculate the paused ticks
+        mPausedTicks = SDL_GetTicks() - mStartTicks;
+		mStartTicks = 0;
+    }
+}
+
+void LTimer::unpause()
+{
+    //If the timer is running and paused
+    if( mStarted && mPaused )
+    {
+        //Unpause the timer
+        mPaused = false;
+
+        //Reset the starting ticks
+        mStartTicks = SDL_GetTicks() - mPausedTicks;
+
+        //Reset the paused ticks
+        mPausedTicks = 0;
+    }
+}
+
+Uint32 LTimer::getTicks()
+{
+	//The actual timer time
+	Uint32 time = 0;
+
+    //If the timer is running
+    if( mStarted )
+    {
+        //If the timer is paused
+        if( mPaused )
+        {
+            //Return the number of ticks when the timer was paused
+            time = mPausedTicks;
+        }
+        else
+        {
+            //Return the current time minus the start time
+            time = SDL_GetTicks() - mStartTicks;
+        }
+    }
+
+    return time;
+}
+
+bool LTimer::isStarted()
+{
+	//Timer is running and paused or unpaused
+    return mStarted;
+}
+
+bool LTimer::isPaused()
+{
+	//Timer is running and paused
+    return mPaused && mStarted;
+}
+
+bool init()
+{
+	//Initialization flag
+	bool success = true;
+
+	//Initialize SDL
+	if( SDL_Init( SDL_INIT_VIDEO ) < 0 )
+	{
+		printf( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
+		success = false;
+	}
+	else
+	{
+		//Set texture filtering to linear
+		if( !SDL_SetHint( SDL_HINT_RENDER_SCALE_QUALITY, "1" ) )
+		{
+			printf( "Warning: Linear texture filtering not enabled!" );
+		}
+
+		//Create window
+		gWindow = SDL_CreateWindow( "SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN );
+		if( gWindow == NULL )
+		{
+			printf( "Window could not be created! SDL Error: %s\n", SDL_GetError() );
+			success = false;
+		}
+		else
+		{
+			//Create renderer for window | SDL_RENDERER_PRESENTVSYNC
+			gRenderer = SDL_CreateRenderer( gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+			if( gRenderer == NULL )
+			{
+				printf( "Renderer could not be created! SDL Error: %s\n", SDL_GetError() );
+				success = false;
+			}
+			else
+			{
+				//Initialize renderer color
+				SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
+
+				//Scene textures are packed for this renderer
+				gAtlas.setRenderer( gRenderer );
+
+				//Initialize PNG loading
+				int imgFlags = IMG_INIT_PNG;
+				if( !( IMG_Init( imgFlags ) & imgFlags ) )
+				{
+					printf( "SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError() );
+					success = false;
+				}
+			}
+		}
+	}
+
+	return success;
+}
+
+bool loadMedia( Course& course, const std::string& mapPath )
+{
+	//The first level goes through the same path as later ones, there's just nothing to play meanwhile
+	gAtlas.setRenderer( gRenderer );
+	Preloader preloader;
+	return preloadLevel( preloader, mapPath ) && installLevel( preloader, course );
+}
+
+bool preloadLevel( Preloader& preloader, const std::string& mapPath, CollisionMode mode )
+{
+	//Images already uploaded are shared, not decoded again
+	std::vector<std::string> imagePaths;
+	if( gAtlas.find( DOT_IMAGE_PATH ) == -1 )
+	{
+		imagePaths.push_back( DOT_IMAGE_PATH );
+	}
+	if( gAtlas.find( TILE_IMAGE_PATH ) == -1 )
+	{
+		imagePaths.push_back( TILE_IMAGE_PATH );
+	}
+
+	return preloader.start( mapPath, imagePaths, mode );
+}
+
+bool installLevel( Preloader& preloader, Course& course )
+{
+	std::vector<PreloadedImage> images;
+	if( !preloader.finish( course, images ) )
+	{
+		printf( "Failed to load level %s!\n", preloader.getMapPath().c_str() );
+		return false;
+	}
+
+	//Loading success flag
+	bool success = true;
+
+	//Upload the decoded images, the atlas takes the surfaces
+	for( size_t i = 0; i < images.size(); ++i )
+	{
+		int sprite = gAtlas.acquire( images[ i ].path, images[ i ].surface );
+		if( sprite == -1 )
+		{
+			printf( "Failed to load texture %s!\n", images[ i ].path.c_str() );
+			success = false;
+		}
+		else if( images[ i ].path == DOT_IMAGE_PATH )
+		{
+			gDotSprite = sprite;
+		}
+		else if( images[ i ].path == TILE_IMAGE_PATH )
+		{
+			gTileSprite = sprite;
+		}
+	}
+
+	//Load tile map
+	if( !setTiles( course.getTiles() ) )
+	{
+		printf( "Failed to load tile set!\n" );
+		success = false;
+	}
+
+	//The new level has to be drawn from scratch
+	gTileLayer.invalidate();
+	gDirtyRegions.invalidate();
+
+	return success;
+}
+
+void close()
+{
+	//Free loaded images
+	gDirtyRegions.free();
+	gTileLayer.free();
+	gAtlas.release( gDotSprite );
+	gAtlas.release( gTileSprite );
+	gAtlas.free();
+	gDotSprite = -1;
+	gTileSprite = -1;
+
+	//Destroy window
+	SDL_DestroyRenderer( gRenderer );
+	SDL_DestroyWindow( gWindow );
+	gWindow = NULL;
+	gRenderer = NULL;
+
+	//Quit SDL subsystems
+	IMG_Quit();
+	SDL_Quit();
+}
+
+bool setTiles( const TileMap& tiles )
+{
+	//Success flag
+	bool tilesLoaded = true;
+
+	//If there is no map to draw
+	if( tiles.getTotalTiles() == 0 )
+	{
+		printf( "Error loading map: Map has no tiles!\n" );
+		tilesLoaded = false;
+	}
+	else
+	{
+		//Clip the sprite sheet
+		if( tilesLoaded )
+		{
+			gTileClips[ TILE_BLACK ].x = 0;
+			gTileClips[ TILE_BLACK ].y = 0;
+			gTileClips[ TILE_BLACK ].w = TILE_WIDTH;
+			gTileClips[ TILE_BLACK ].h = TILE_HEIGHT;
+
+			gTileClips[ TILE_GREEN ].x = 0;
+			gTileClips[ TILE_GREEN ].y = 80;
+			gTileClips[ TILE_GREEN ].w = TILE_WIDTH;
+			gTileClips[ TILE_GREEN ].h = TILE_HEIGHT;
+
+			gTileClips[ TILE_YELLOW ].x = 0;
+			gTileClips[ TILE_YELLOW ].y = 160;
+			gTileClips[ TILE_YELLOW ].w = TILE_WIDTH;
+			gTileClips[ TILE_YELLOW ].h = TILE_HEIGHT;
+		}
+	}
+
+    //If the map was loaded fine
+    return tilesLoaded;
+}
+
+void centerCamera( SDL_Rect& camera, float x, float y, const TileMap& tiles )
+{
+	//Center the camera over the point
+	camera.x = int(x) - camera.w / 2;
+	camera.y = int(y) - camera.h / 2;
+
+	//Keep the camera in bounds, levels smaller than the screen stay at the top left
+	camera.x = std::max( 0, std::min( camera.x, tiles.getWidth() - camera.w ) );
+	camera.y = std::max( 0, std::min( camera.y, tiles.getHeight() - camera.h ) );
+}
+
+void renderBall( const BallState& ball, const SDL_Rect& camera )
+{
+	Circle collider = getCollider( ball );
+	gAtlas.draw( gSprites, gDotSprite, int(collider.x - collider.r) - camera.x, int(collider.y - collider.r) - camera.y );
+}
+
+void renderTiles( const TileMap& tiles, const SDL_Rect& camera )
+{
+	//Only the grid cells the camera overlaps are visited
+	int firstColumn = std::max( 0, camera.x / TILE_WIDTH );
+	int firstRow = std::max( 0, camera.y / TILE_HEIGHT );
+	int lastColumn = std::min( tiles.getColumns() - 1, ( camera.x + camera.w - 1 ) / TILE_WIDTH );
+	int lastRow = std::min( tiles.getRows() - 1, ( camera.y + camera.h - 1 ) / TILE_HEIGHT );
+
+	//Render level
+	for( int row = firstRow; row <= lastRow; ++row )
+	{
+		for( int column = firstColumn; column <= lastColumn; ++column )
+		{
+			int i = row * tiles.getColumns() + column;
+			gAtlas.draw( gSprites, gTileSprite, column * TILE_WIDTH - camera.x, row * TILE_HEIGHT - camera.y, &gTileClips[ tiles.getType( i ) ] );
+		}
+	}
+}
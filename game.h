@@ -0,0 +1,330 @@
+//The SDL side of the game: textures, the dot and the screen
+#ifndef GAME_H
+#define GAME_H
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <string>
+#include <vector>
+#include "physics.h"
+#include "atlas.h"
+#include "preloader.h"
+#include "trajectory.h"
+
+//Screen dimension constants
+const int SCREEN_WIDTH = 560;
+const int SCREEN_HEIGHT = 880;
+
+//The scene images
+const char DOT_IMAGE_PATH[] = "./dot.bmp";
+const char TILE_IMAGE_PATH[] = "./tiles.png";
+
+//Texture wrapper class
+class LTexture
+{
+	public:
+		//Initializes variables
+		LTexture();
+
+		//Deallocates memory
+		~LTexture();
+
+		//Loads image at specified path
+		bool loadFromFile( const std::string& path );
+
+		#if defined(SDL_TTF_MAJOR_VERSION)
+		//Creates image from font string
+		bool loadFromRenderedText( const std::string& textureText, SDL_Color textColor );
+		#endif
+
+		//Deallocates texture
+		void free();
+
+		//Set color modulation
+		void setColor( Uint8 red, Uint8 green, Uint8 blue );
+
+		//Set blending
+		void setBlendMode( SDL_BlendMode blending );
+
+		//Set alpha modulation
+		void setAlpha( Uint8 alpha );
+
+		//Renders texture at given point
+		void render( int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE );
+
+		//Gets image dimensions
+		int getWidth();
+		int getHeight();
+
+	private:
+		//The actual hardware texture
+		SDL_Texture* mTexture;
+
+		//Image dimensions
+		int mWidth;
+		int mHeight;
+};
+
+//The level tiles pre-rendered into one texture
+class TileLayer
+{
+	public:
+		//Initializes variables
+		TileLayer();
+
+		//Deallocates memory
+		~TileLayer();
+
+		//Marks the layer for redrawing before next render
+		void invalidate();
+
+		//Redraws only the listed tiles into the layer
+		void update( const TileMap& tiles, const std::vector<int>& changed );
+
+		//Deallocates the layer texture
+		void free();
+
+		//Shows the tiles in view of the camera, redrawing the layer if needed
+		void render( const TileMap& tiles, const SDL_Rect& camera );
+
+	private:
+		//Redraws the tiles into the layer texture
+		bool build( const TileMap& tiles );
+
+		//The layer render target
+		SDL_Texture* mTexture;
+
+		//Layer dimensions
+		int mWidth;
+		int mHeight;
+
+		//Layer status
+		bool mDirty;
+
+		//Set when the renderer can't hold the layer and tiles are drawn directly
+		bool mFallback;
+};
+
+class Dot;
+
+//Repaints only the changed parts of the screen for low power mode
+class DirtyRegions
+{
+	public:
+		//The most regions tracked before repainting everything
+		static const int MAX_REGIONS = 8;
+
+		//Initializes variables
+		DirtyRegions();
+
+		//Deallocates memory
+		~DirtyRegions();
+
+		//Marks a screen region for repainting
+		void add( const SDL_Rect& region );
+
+		//Marks the whole screen for repainting
+		void invalidate();
+
+		//Checks if anything needs repainting
+		bool isDirty();
+
+		//Deallocates the frame texture
+		void free();
+
+		//Repaints the dirty regions and shows the frame
+		void present( const TileMap& tiles, Dot& dot, const SDL_Rect& camera );
+
+	private:
+		//Repaints one region, or everything when region is NULL
+		void repaint( const TileMap& tiles, Dot& dot, const SDL_Rect& camera, const SDL_Rect* region );
+
+		//The persistent copy of the screen
+		SDL_Texture* mFrame;
+
+		//The regions changed since the last present
+		SDL_Rect mRegions[ MAX_REGIONS ];
+		int mCount;
+
+		//Set when everything has to be repainted
+		bool mFull;
+};
+
+//The dot that will move around on the screen
+class Dot
+{
+    public:
+		//The dimensions of the dot
+		static const int DOT_WIDTH = BALL_WIDTH;
+		static const int DOT_HEIGHT = BALL_HEIGHT;
+
+		//Maximum axis velocity of the dot
+		static const int DOT_VEL = 400;
+
+		//win check
+		bool touchingHole = false;
+		int numStrokes = 0;
+
+		//Initializes the variables
+		Dot( float x, float y );
+
+		//Takes key presses and adjusts the dot's velocity
+		void handleEvent( SDL_Event& e );
+
+		//Takes a mouse press or release, strokes are played on the release
+		void handleMouseButton( bool down, int x, int y );
+
+		//Moves the dot and check collision against tiles, gets the number of walls bounced off
+		int move( const Course& course, float timeStep );
+
+		//Places the dot between its last two physics states for rendering
+		void interpolate( float alpha );
+
+		//Queues the dot into the sprite batch relative to the camera
+		void render( const SDL_Rect& camera );
+
+		//Points the drag preview at where the mouse is now
+		void setAim( int x, int y );
+
+		//Gets the velocity the current drag would hit the dot with
+		void getAimVelocity( float& velX, float& velY );
+
+		//Sets the predicted path drawn for the drag, NULL for a straight line
+		void setPath( const PredictedPath* path );
+
+		//Draws the shot the current drag would play, after the sprites are flushed
+		void renderAim( const SDL_Rect& camera );
+
+		//Gets the screen area the drag preview covers relative to the camera, empty when not aiming
+		SDL_Rect getAimBox( const SDL_Rect& camera );
+
+		//Checks if a stroke is being dragged
+		bool isAiming();
+
+		//Centers the camera over the dot, keeping it inside the level
+		void setCamera( SDL_Rect& camera, const TileMap& tiles );
+
+		//Gets collision circle
+		Circle& getCollider();
+
+		//Gets the screen area the dot covers relative to the camera
+		SDL_Rect getBox( const SDL_Rect& camera );
+
+		//Checks if the dot has stopped moving
+		bool isAtRest();
+
+		//Gets the simulated ball
+		const BallState& getState() const;
+
+    private:
+		//The position and velocity of the dot
+		BallState mBall;
+
+		//The dot's position before the last move
+		float mPrevX, mPrevY;
+
+		//The interpolated position the dot is drawn at
+		float mRenderX, mRenderY;
+
+		//The mouse press the next stroke is dragged from
+		StrokeInput mStroke;
+
+		//Whether a press on the resting dot is held and where the mouse is
+		bool mAiming;
+		int mAimX, mAimY;
+
+		//The predicted path of the drag, owned by the predictor
+		const PredictedPath* mPath;
+
+		//Dot's collision circle
+		Circle mCollider;
+
+		//The tile revision last checked against the stock course, and whether it matched
+		uint32_t mStockRevision;
+		bool mStock;
+
+		//Moves the collision circle relative to the dot's offset
+		void shiftColliders();
+};
+
+//The application time based timer
+class LTimer
+{
+    public:
+		//Initializes variables
+		LTimer();
+
+		//The various clock actions
+		void start();
+		void stop();
+		void pause();
+		void unpause();
+
+		//Gets the timer's time
+		Uint32 getTicks();
+
+		//Checks the status of the timer
+		bool isStarted();
+		bool isPaused();
+
+    private:
+		//The clock time when the timer started
+		Uint32 mStartTicks;
+
+		//The ticks stored when the timer was paused
+		Uint32 mPausedTicks;
+
+		//The timer status
+		bool mPaused;
+		bool mStarted;
+};
+
+//Starts up SDL and creates window
+bool init();
+
+//Loads media
+bool loadMedia( Course& course, const std::string& mapPath );
+
+//Starts loading a level and any scene images not in the atlas yet in the background
+bool preloadLevel( Preloader& preloader, const std::string& mapPath, CollisionMode mode = COLLISION_SWEPT );
+
+//Uploads a preloaded level's images and puts it in play
+bool installLevel( Preloader& preloader, Course& course );
+
+//Frees media and shuts down SDL
+void close();
+
+//Sets tile clips for the tile map
+bool setTiles( const TileMap& tiles );
+
+//Queues the tiles in view of the camera into the sprite batch
+void renderTiles( const TileMap& tiles, const SDL_Rect& camera );
+
+//Centers the camera over a point, keeping it inside the level
+void centerCamera( SDL_Rect& camera, float x, float y, const TileMap& tiles );
+
+//Queues a ball that has no dot of its own, like another player's, into the sprite batch
+void renderBall( const BallState& ball, const SDL_Rect& camera );
+
+//The window we'll be rendering to
+extern SDL_Window* gWindow;
+
+//The window renderer
+extern SDL_Renderer* gRenderer;
+
+//Scene textures, packed together so drawing the scene never switches texture
+extern TextureAtlas gAtlas;
+extern int gDotSprite;
+extern int gTileSprite;
+extern SDL_Rect gTileClips[ TOTAL_TILE_SPRITES ];
+
+//Sprites queued over a frame, flushed before anything drawn on top of them and before presenting
+extern SpriteBatch gSprites;
+
+//The cached level render
+extern TileLayer gTileLayer;
+
+//The low power mode repaint tracking
+extern DirtyRegions gDirtyRegions;
+
+#endif
@@ -0,0 +1,294 @@
+//Procedural course generator checked by the shot solver
+#include "generator.h"
+#include <stdlib.h>
+#include <algorithm>
+
+//Chance each step of the fairway heads for the hole rather than wandering
+static const uint32_t FAIRWAY_PULL = 60;
+
+//Largest open area carved off the fairway, in tiles across
+static const int ROOM_MAX_SIZE = 4;
+
+//Scrambles a number into a well mixed seed
+static uint32_t mixSeed( uint32_t value )
+{
+	value ^= value >> 16;
+	value *= 0x7FEB352D;
+	value ^= value >> 15;
+	value *= 0x846CA68B;
+	value ^= value >> 16;
+	return value;
+}
+
+//Gets the next number of a repeatable sequence
+static uint32_t nextRandom( uint32_t& state )
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+//Gets a repeatable number from low to high inclusive
+static int randomInt( uint32_t& state, int low, int high )
+{
+	return low + (int)( nextRandom( state ) % (uint32_t)( high - low + 1 ) );
+}
+
+//Opens every tile of a box that lies on the map
+static void carve( std::vector<uint8_t>& types, int columns, int rows, int left, int top, int width, int height )
+{
+	for( int row = std::max( top, 0 ); row < std::min( top + height, rows ); ++row )
+	{
+		for( int column = std::max( left, 0 ); column < std::min( left + width, columns ); ++column )
+		{
+			types[ row * columns + column ] = TILE_GREEN;
+		}
+	}
+}
+
+GeneratorSettings getDefaultGeneratorSettings()
+{
+	GeneratorSettings settings;
+	settings.columns = 7;
+	settings.rows = 11;
+	settings.fairwayWidth = 2;
+	settings.rooms = 2;
+	settings.wallChance = 0.1f;
+	settings.minPar = 2;
+	settings.maxPar = 4;
+	settings.seed = 1;
+
+	//A tenth of the full solve's shots still separates par 2 from par 3
+	settings.solver = getDefaultSolverSettings();
+	settings.solver.angles = 48;
+	settings.solver.powers = 8;
+	return settings;
+}
+
+CourseGenerator::CourseGenerator( const GeneratorSettings& settings, ThreadPool& pool ) : mSettings( settings ), mPool( pool )
+{
+	//Nothing past the highest accepted par needs searching
+	mSettings.solver.maxStrokes = mSettings.maxPar;
+
+	for( int i = 0; i < pool.getThreadCount(); ++i )
+	{
+		Worker* worker = new Worker;
+		worker->shots = 0;
+		mWorkers.push_back( worker );
+	}
+	mNext = 0;
+	mTried = 0;
+}
+
+CourseGenerator::~CourseGenerator()
+{
+	//Deallocate
+	for( size_t i = 0; i < mWorkers.size(); ++i )
+	{
+		delete mWorkers[ i ];
+	}
+}
+
+int CourseGenerator::generateRound( int candidates )
+{
+	//Tiles from earlier rounds are overwritten rather than freed
+	if( (int)mCandidates.size() < candidates )
+	{
+		mCandidates.resize( candidates );
+		mPassed.resize( candidates );
+	}
+	for( int i = 0; i < candidates; ++i )
+	{
+		mCandidates[ i ].candidate = mNext + i;
+	}
+	mNext += candidates;
+	mTried += candidates;
+
+	//Each candidate is laid out and solved on one worker, which only touches its own buffers
+	mPool.parallelFor( candidates, [ this ]( int candidate, int worker )
+	{
+		mPassed[ candidate ] = validate( *mWorkers[ worker ], mCandidates[ candidate ] );
+	} );
+
+	mAccepted.clear();
+	for( int i = 0; i < candidates; ++i )
+	{
+		if( mPassed[ i ] )
+		{
+			mAccepted.push_back( i );
+		}
+	}
+	return mAccepted.size();
+}
+
+int CourseGenerator::getAcceptedCount() const
+{
+	return mAccepted.size();
+}
+
+const GeneratedCourse& CourseGenerator::getAccepted( int i ) const
+{
+	return mCandidates[ mAccepted[ i ] ];
+}
+
+long long CourseGenerator::getCandidateCount() const
+{
+	return mTried;
+}
+
+long long CourseGenerator::getShotCount() const
+{
+	long long shots = 0;
+	for( size_t i = 0; i < mWorkers.size(); ++i )
+	{
+		shots += mWorkers[ i ]->shots;
+	}
+	return shots;
+}
+
+void CourseGenerator::layout( uint32_t candidate, std::vector<uint8_t>& types ) const
+{
+	int columns = mSettings.columns;
+	int rows = mSettings.rows;
+	uint32_t state = mixSeed( candidate ^ mixSeed( mSettings.seed ) );
+	if( state == 0 )
+	{
+		state = 1;
+	}
+
+	//Everything starts as wall and gets carved open
+	types.assign( columns * rows, TILE_BLACK );
+
+	//The tee sits on the line between the last two rows, between the middle columns on even widths
+	int teeLeft = ( columns - 1 ) / 2;
+	int teeRight = columns / 2;
+	carve( types, columns, rows, teeLeft, rows - 2, teeRight - teeLeft + 1, 2 );
+
+	//The hole goes in the top third
+	int holeColumn = randomInt( state, 0, columns - 1 );
+	int holeRow = randomInt( state, 0, rows / 3 - 1 );
+
+	//Wander up from the tee, mostly towards the hole, carving the fairway
+	int width = std::max( mSettings.fairwayWidth, 1 );
+	int column = teeRight;
+	int row = rows - 2;
+	for( int steps = 0; ( column != holeColumn || row != holeRow ) && steps < columns * rows * 4; ++steps )
+	{
+		carve( types, columns, rows, column - ( width - 1 ) / 2, row - ( width - 1 ) / 2, width, width );
+
+		int moveColumn = 0, moveRow = 0;
+		if( nextRandom( state ) % 100 < FAIRWAY_PULL )
+		{
+			//Close the larger gap more often, so the fairway bends rather than zigzags
+			int gapColumns = holeColumn - column;
+			int gapRows = holeRow - row;
+			if( gapRows != 0 && ( gapColumns == 0 || randomInt( state, 0, abs( gapColumns ) + abs( gapRows ) - 1 ) < abs( gapRows ) ) )
+			{
+				moveRow = gapRows > 0 ? 1 : -1;
+			}
+			else
+			{
+				moveColumn = gapColumns > 0 ? 1 : -1;
+			}
+		}
+		else
+		{
+			int direction = randomInt( state, 0, 3 );
+			moveColumn = direction == 0 ? -1 : direction == 1 ? 1 : 0;
+			moveRow = direction == 2 ? -1 : direction == 3 ? 1 : 0;
+		}
+		column = std::min( std::max( column + moveColumn, 0 ), columns - 1 );
+		row = std::min( std::max( row + moveRow, 0 ), rows - 1 );
+	}
+
+	//A walk that wandered too long goes straight the rest of the way
+	carve( types, columns, rows, std::min( column, holeColumn ), row, abs( holeColumn - column ) + 1, 1 );
+	carve( types, columns, rows, holeColumn, std::min( row, holeRow ), 1, abs( holeRow - row ) + 1 );
+
+	//Open areas off the fairway give shots somewhere to bank
+	for( int room = 0; room < mSettings.rooms; ++room )
+	{
+		int roomWidth = randomInt( state, 2, ROOM_MAX_SIZE );
+		int roomHeight = randomInt( state, 2, ROOM_MAX_SIZE );
+		carve( types, columns, rows, randomInt( state, 0, columns - 1 ), randomInt( state, 0, rows - 1 ), roomWidth, roomHeight );
+	}
+
+	//Scattered walls, keeping clear of the tee and the tiles around the hole
+	uint32_t wallThreshold = (uint32_t)( std::min( std::max( mSettings.wallChance, 0.f ), 1.f ) * 65536 );
+	for( int i = 0; i < columns * rows; ++i )
+	{
+		int tileColumn = i % columns;
+		int tileRow = i / columns;
+		bool nearTee = tileRow >= rows - 2 && tileColumn >= teeLeft && tileColumn <= teeRight;
+		bool nearHole = abs( tileColumn - holeColumn ) <= 1 && abs( tileRow - holeRow ) <= 1;
+		if( types[ i ] == TILE_GREEN && !nearTee && !nearHole && ( nextRandom( state ) & 0xFFFF ) < wallThreshold )
+		{
+			types[ i ] = TILE_BLACK;
+		}
+	}
+
+	types[ holeRow * columns + holeColumn ] = TILE_YELLOW;
+}
+
+bool CourseGenerator::isConnected( const std::vector<uint8_t>& types, std::vector<int>& flood ) const
+{
+	int columns = mSettings.columns;
+	int rows = mSettings.rows;
+
+	//Fill out from the tee's tile across everything that isn't wall
+	std::vector<int>& visited = flood;
+	visited.assign( columns * rows, 0 );
+	int tee = ( rows - 2 ) * columns + columns / 2;
+
+	//The queue lives past the visited marks in the same buffer
+	size_t queueStart = visited.size();
+	visited.push_back( tee );
+	visited[ tee ] = 1;
+	for( size_t next = queueStart; next < visited.size(); ++next )
+	{
+		int i = visited[ next ];
+		if( types[ i ] == TILE_YELLOW )
+		{
+			return true;
+		}
+
+		int column = i % columns;
+		int neighbors[ 4 ] = { column > 0 ? i - 1 : -1, column < columns - 1 ? i + 1 : -1, i - columns, i + columns };
+		for( int n = 0; n < 4; ++n )
+		{
+			int neighbor = neighbors[ n ];
+			if( neighbor >= 0 && neighbor < columns * rows && !visited[ neighbor ] && types[ neighbor ] != TILE_BLACK )
+			{
+				visited[ neighbor ] = 1;
+				visited.push_back( neighbor );
+			}
+		}
+	}
+
+	return false;
+}
+
+bool CourseGenerator::validate( Worker& worker, GeneratedCourse& course )
+{
+	layout( course.candidate, course.types );
+	course.par = -1;
+	course.teeHoleChance = 0;
+
+	//Walls cutting the hole off are cheap to spot before any shot is simulated
+	if( !isConnected( course.types, worker.flood ) )
+	{
+		return false;
+	}
+
+	if( !worker.course.loadFromTypes( mSettings.columns, mSettings.rows, &course.types[ 0 ] ) )
+	{
+		return false;
+	}
+
+	ParResult result = solvePar( worker.course, mSettings.solver, worker.search );
+	worker.shots += result.shots;
+	course.par = result.par;
+	course.teeHoleChance = result.teeHoleChance;
+	return result.par >= mSettings.minPar && result.par <= mSettings.maxPar;
+}
@@ -0,0 +1,122 @@
+//Procedural course generator checked by the shot solver, usable without SDL
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdint.h>
+#include <vector>
+#include "physics.h"
+#include "solver.h"
+#include "threadpool.h"
+
+//Smallest map the tee, a fairway and the hole fit in
+const int GENERATOR_MIN_COLUMNS = 3;
+const int GENERATOR_MIN_ROWS = 4;
+
+//How courses are laid out and what gets them accepted
+struct GeneratorSettings
+{
+	//The map dimensions in tiles
+	int columns;
+	int rows;
+
+	//Tiles across the fairway carved from the tee to the hole
+	int fairwayWidth;
+
+	//Open areas carved off the fairway
+	int rooms;
+
+	//Chance an open tile away from the tee and hole is turned into a wall
+	float wallChance;
+
+	//Par an accepted course has to land in
+	int minPar;
+	int maxPar;
+
+	//Mixed into every candidate's layout, which otherwise only depends on the candidate's number
+	uint32_t seed;
+
+	//The sampling that validates candidates, coarser than a full solve since only par is needed
+	SolverSettings solver;
+};
+
+//A candidate that was accepted
+struct GeneratedCourse
+{
+	//The candidate's number, which with the seed lays it out again
+	uint32_t candidate;
+
+	//What the validating solve found
+	int par;
+	float teeHoleChance;
+
+	//The tile types, row major
+	std::vector<uint8_t> types;
+};
+
+//Gets settings for maps the size of the stock one
+GeneratorSettings getDefaultGeneratorSettings();
+
+//Lays out candidates and validates them across a pool, a round at a time
+class CourseGenerator
+{
+	public:
+		//Initializes variables, one set of buffers per pool worker
+		CourseGenerator( const GeneratorSettings& settings, ThreadPool& pool );
+
+		//Frees the workers' buffers
+		~CourseGenerator();
+
+		//Lays out and validates the next candidates, gets how many were accepted
+		int generateRound( int candidates );
+
+		//Gets the courses accepted in the last round, in candidate order
+		int getAcceptedCount() const;
+		const GeneratedCourse& getAccepted( int i ) const;
+
+		//Gets the candidates tried and the shots simulated so far
+		long long getCandidateCount() const;
+		long long getShotCount() const;
+
+		//Lays out a candidate's tiles without validating them
+		void layout( uint32_t candidate, std::vector<uint8_t>& types ) const;
+
+	private:
+		//Generators can't be copied since they own the workers' buffers
+		CourseGenerator( const CourseGenerator& );
+		CourseGenerator& operator=( const CourseGenerator& );
+
+		//What each worker reuses from candidate to candidate
+		struct Worker
+		{
+			Course course;
+			ParSearch search;
+			std::vector<int> flood;
+			long long shots;
+		};
+
+		//Checks if the hole can be walked to from the tee without crossing walls
+		bool isConnected( const std::vector<uint8_t>& types, std::vector<int>& flood ) const;
+
+		//Lays out and validates one candidate, false if it's rejected
+		bool validate( Worker& worker, GeneratedCourse& course );
+
+		//How courses are laid out and accepted
+		GeneratorSettings mSettings;
+
+		//The pool the candidates are spread across
+		ThreadPool& mPool;
+
+		//One set of buffers per pool worker
+		std::vector<Worker*> mWorkers;
+
+		//Every candidate of a round and whether it was accepted, kept between rounds so their tiles aren't reallocated
+		std::vector<GeneratedCourse> mCandidates;
+		std::vector<uint8_t> mPassed;
+		std::vector<int> mAccepted;
+
+		//The next candidate number and the totals so far
+		uint32_t mNext;
+		long long mTried;
+};
+
+#endif
@@ -0,0 +1,63 @@
+//Mouse input placed on the physics tick it happened during
+#include "input.h"
+
+InputQueue::InputQueue()
+{
+	//Initialize
+	mStart = 0;
+	mTickLength = 0;
+	mRecords.reserve( INPUT_RESERVED_RECORDS );
+}
+
+bool InputQueue::push( const SDL_Event& e )
+{
+	if( e.type != SDL_MOUSEBUTTONDOWN && e.type != SDL_MOUSEBUTTONUP )
+	{
+		return false;
+	}
+
+	//Events nearly always arrive in order so this only walks back past ones stamped later
+	InputRecord record = { e.common.timestamp, e.type == SDL_MOUSEBUTTONDOWN, e.button.x, e.button.y };
+	std::vector<InputRecord>::iterator position = mRecords.end();
+	while( position != mRecords.begin() && ( position - 1 )->timestamp > record.timestamp )
+	{
+		--position;
+	}
+	mRecords.insert( position, record );
+	return true;
+}
+
+void InputQueue::beginTicks( double start, float timeStep )
+{
+	mStart = start;
+	mTickLength = timeStep * 1000.0;
+}
+
+bool InputQueue::pop( int tick, InputRecord& record )
+{
+	if( mRecords.empty() )
+	{
+		return false;
+	}
+
+	//A tick sees everything that happened before it starts, anything later waits for a later tick
+	double tickStart = mStart + tick * mTickLength;
+	if( mRecords.front().timestamp > tickStart )
+	{
+		return false;
+	}
+
+	record = mRecords.front();
+	mRecords.erase( mRecords.begin() );
+	return true;
+}
+
+void InputQueue::clear()
+{
+	mRecords.clear();
+}
+
+int InputQueue::getPendingCount() const
+{
+	return mRecords.size();
+}
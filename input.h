@@ -0,0 +1,50 @@
+//Mouse input placed on the physics tick it happened during
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL.h>
+#include <vector>
+
+//Records room is kept for up front, so queuing doesn't allocate during play
+const int INPUT_RESERVED_RECORDS = 64;
+
+//A mouse press or release and when it happened on the SDL clock
+struct InputRecord
+{
+	Uint32 timestamp;
+	bool down;
+	int x, y;
+};
+
+//Mouse buttons held back until the physics reaches the moment they happened
+class InputQueue
+{
+	public:
+		//Initializes variables
+		InputQueue();
+
+		//Keeps a mouse button event in timestamp order, false for any other event
+		bool push( const SDL_Event& e );
+
+		//Starts a run of physics ticks, the first beginning at start milliseconds on the SDL clock
+		void beginTicks( double start, float timeStep );
+
+		//Takes the next record that happened before the given tick of the run begins, false if none did
+		bool pop( int tick, InputRecord& record );
+
+		//Drops every record
+		void clear();
+
+		//Gets the records still waiting for their tick
+		int getPendingCount() const;
+
+	private:
+		//The records oldest first
+		std::vector<InputRecord> mRecords;
+
+		//When the run of ticks starts and how long each tick lasts in milliseconds
+		double mStart;
+		double mTickLength;
+};
+
+#endif
@@ -2,926 +2,624 @@
 #include <SDL.h>
 #include <SDL_image.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
 #include <string>
 #include <fstream>
 #include <iostream>
 #include <cmath>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include "game.h"
+#include "solver.h"
+#include "generator.h"
+#include "fixedcourse.h"
+#include "replay.h"
+#include "profiler.h"
+#include "session.h"
+#include "allocations.h"
+#include "netclient.h"
+#include "input.h"
+#include "filewatcher.h"
+#include "trajectory.h"
+#include "telemetry.h"
 
-//Screen dimension constants
-const int SCREEN_WIDTH = 560;
-const int SCREEN_HEIGHT = 880;
+//How long the low power mode sleeps waiting for input
+const int IDLE_WAIT_MS = 250;
 
-//Tile constants
-const int TILE_WIDTH = 80;
-const int TILE_HEIGHT = 80;
-const int TOTAL_TILES = 77;
-const int TOTAL_TILE_SPRITES = 3;
+//Longest frame the physics catches up on, so a hitch doesn't snowball
+const double MAX_FRAME_TIME = 0.25;
 
-//The different tile sprite
-const int TILE_BLACK = 0;
-const int TILE_GREEN = 1;
-const int TILE_YELLOW = 2;
+//Candidates each generator thread validates per round, enough to keep every core busy between writes
+const int GENERATE_ROUND_PER_THREAD = 16;
 
-//A circle stucture
-struct Circle
-{
-	float x, y;
-	float r;
-};
-
-//Texture wrapper class
-class LTexture
-{
-	public:
-		//Initializes variables
-		LTexture();
-
-		//Deallocates memory
-		~LTexture();
-
-		//Loads image at specified path
-		bool loadFromFile( std::string path );
-
-		#if defined(SDL_TTF_MAJOR_VERSION)
-		//Creates image from font string
-		bool loadFromRenderedText( std::string textureText, SDL_Color textColor );
-		#endif
-
-		//Deallocates texture
-		void free();
-
-		//Set color modulation
-		void setColor( Uint8 red, Uint8 green, Uint8 blue );
-
-		//Set blending
-		void setBlendMode( SDL_BlendMode blending );
-
-		//Set alpha modulation
-		void setAlpha( Uint8 alpha );
-
-		//Renders texture at given point
-		void render( int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE );
-
-		//Gets image dimensions
-		int getWidth();
-		int getHeight();
+//Rounds in a row without an accepted course before the generator gives up on the settings
+const int GENERATE_MAX_EMPTY_ROUNDS = 100;
 
-	private:
-		//The actual hardware texture
-		SDL_Texture* mTexture;
+//Checks if a flag was passed on the command line
+bool hasFlag( int argc, char* args[], const char* flag );
 
-		//Image dimensions
-		int mWidth;
-		int mHeight;
-};
+//Gets the value following an option on the command line
+const char* getOption( int argc, char* args[], const char* option );
 
-//The tile
-class Tile
-{
-    public:
-		//Initializes position and type
-		Tile( int x, int y, int tileType );
-
-		//Shows the tile
-		void render();
-
-		//Get the tile type
-		int getType();
-
-		//Get the collision box
-		SDL_Rect getBox();
-
-    private:
-		//The attributes of the tile
-		SDL_Rect mBox;
-
-		//The tile type
-		int mType;
-};
+//Gets the map named by --map, or the stock map
+std::string getMapPath( int argc, char* args[] );
 
-//The dot that will move around on the screen
-class Dot
-{
-    public:
-		//The dimensions of the dot
-		static const int DOT_WIDTH = 20;
-		static const int DOT_HEIGHT = 20;
-
-		//Maximum axis velocity of the dot
-		static const int DOT_VEL = 400;
-
-		//win check
-		bool touchingHole = false;
-		int numStrokes = 0;
+//Gets the collision backend named by --collision
+CollisionMode getCollisionMode( int argc, char* args[] );
 
-		//Initializes the variables
-		Dot(int x, int y);
+//Switches the course to the collision backend named by --collision
+void setCollisionMode( Course& course, int argc, char* args[] );
 
-		//Takes key presses and adjusts the dot's velocity
-		void handleEvent( SDL_Event& e );
+//Gets the file a hole's replay is recorded to, numbered when the round has more than one
+std::string getReplayPath( const char* recordPath, int hole, int holeCount );
 
-		//Moves the dot and check collision against tiles
-		void move( Tile *tiles[] , float timeStep);
+//Saves the current hole's replay so it can be checked with --replay
+void saveReplay( Replay& replay, const char* recordPath, const Session& session, uint32_t tick, const Dot& dot );
 
-		//Shows the dot on the screen
-		void render();
+//Runs shots through the headless physics without creating a window
+int runSimulation( int argc, char* args[] );
 
-		//Gets collision circle
-		Circle& getCollider();
+//Converts a text map into a compiled map
+int compileMap( int argc, char* args[] );
 
-    private:
-		//The X and Y offsets of the dot
-		float mPosX, mPosY;
+//Works out par and a difficulty heatmap across all cores
+int runSolver( int argc, char* args[] );
 
-		//The velocity of the dot
-		float mVelX, mVelY;
+//Generates courses across all cores and writes the ones that pass the solver
+int runGenerator( int argc, char* args[] );
 
-		int mouseX_down;
-		int mouseY_down;
-		int mouseX_up;
-		int mouseY_up;
+//Plays recorded rounds back headless and checks they end the same way
+int runReplays( int argc, char* args[] );
 
-		//Dot's collision circle
-		Circle mCollider;
-
-		//Moves the collision circle relative to the dot's offset
-		void shiftColliders();
-};
-
-//The application time based timer
-class LTimer
-{
-    public:
-		//Initializes variables
-		LTimer();
-
-		//The various clock actions
-		void start();
-		void stop();
-		void pause();
-		void unpause();
-
-		//Gets the timer's time
-		Uint32 getTicks();
-
-		//Checks the status of the timer
-		bool isStarted();
-		bool isPaused();
-
-    private:
-		//The clock time when the timer started
-		Uint32 mStartTicks;
-
-		//The ticks stored when the timer was paused
-		Uint32 mPausedTicks;
-
-		//The timer status
-		bool mPaused;
-		bool mStarted;
-};
-
-//Starts up SDL and creates window
-bool init();
-
-//Loads media
-bool loadMedia( Tile* tiles[] );
-
-//Frees media and shuts down SDL
-void close( Tile* tiles[] );
-
-//Box collision detector
-bool checkCollision( Circle& a, SDL_Rect b );
-
-//Checks collision box against set of tiles
-bool touchesWall( Circle& circle, Tile* tiles[] );
-
-//Checks collision box against hole tile
-bool touchesHole( Circle& circle, Tile* tiles[] );
-
-//Calculates distance squared between two points
-double distanceSquared( int x1, int y1, int x2, int y2 );
-
-//Sets tiles from tile map
-bool setTiles( Tile *tiles[] );
-
-//The window we'll be rendering to
-SDL_Window* gWindow = NULL;
-
-//The window renderer
-SDL_Renderer* gRenderer = NULL;
-
-//Scene textures
-LTexture gDotTexture;
-LTexture gTileTexture;
-SDL_Rect gTileClips[ TOTAL_TILE_SPRITES ];
-
-LTexture::LTexture()
-{
-	//Initialize
-	mTexture = NULL;
-	mWidth = 0;
-	mHeight = 0;
-}
-
-LTexture::~LTexture()
-{
-	//Deallocate
-	free();
-}
+//Plays a hosted match in a window
+int runClient( int argc, char* args[] );
 
-bool LTexture::loadFromFile( std::string path )
+bool hasFlag( int argc, char* args[], const char* flag )
 {
-	//Get rid of preexisting texture
-	free();
-
-	//The final texture
-	SDL_Texture* newTexture = NULL;
-
-	//Load image at specified path
-	SDL_Surface* loadedSurface = IMG_Load( path.c_str() );
-	if( loadedSurface == NULL )
-	{
-		printf( "Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError() );
-	}
-	else
+	for( int i = 1; i < argc; ++i )
 	{
-		//Color key image
-		SDL_SetColorKey( loadedSurface, SDL_TRUE, SDL_MapRGB( loadedSurface->format, 0, 0xFF, 0xFF ) );
-
-		//Create texture from surface pixels
-        newTexture = SDL_CreateTextureFromSurface( gRenderer, loadedSurface );
-		if( newTexture == NULL )
+		if( strcmp( args[ i ], flag ) == 0 )
 		{
-			printf( "Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError() );
+			return true;
 		}
-		else
-		{
-			//Get image dimensions
-			mWidth = loadedSurface->w;
-			mHeight = loadedSurface->h;
-		}
-
-		//Get rid of old loaded surface
-		SDL_FreeSurface( loadedSurface );
 	}
 
-	//Return success
-	mTexture = newTexture;
-	return mTexture != NULL;
+	return false;
 }
 
-#if defined(SDL_TTF_MAJOR_VERSION)
-bool LTexture::loadFromRenderedText( std::string textureText, SDL_Color textColor )
+const char* getOption( int argc, char* args[], const char* option )
 {
-	//Get rid of preexisting texture
-	free();
-
-	//Render text surface
-	SDL_Surface* textSurface = TTF_RenderText_Solid( gFont, textureText.c_str(), textColor );
-	if( textSurface != NULL )
+	for( int i = 1; i + 1 < argc; ++i )
 	{
-		//Create texture from surface pixels
-        mTexture = SDL_CreateTextureFromSurface( gRenderer, textSurface );
-		if( mTexture == NULL )
-		{
-			printf( "Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError() );
-		}
-		else
+		if( strcmp( args[ i ], option ) == 0 )
 		{
-			//Get image dimensions
-			mWidth = textSurface->w;
-			mHeight = textSurface->h;
+			return args[ i + 1 ];
 		}
-
-		//Get rid of old surface
-		SDL_FreeSurface( textSurface );
-	}
-	else
-	{
-		printf( "Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError() );
 	}
 
-
-	//Return success
-	return mTexture != NULL;
+	return NULL;
 }
-#endif
 
-void LTexture::free()
+std::string getMapPath( int argc, char* args[] )
 {
-	//Free texture if it exists
-	if( mTexture != NULL )
-	{
-		SDL_DestroyTexture( mTexture );
-		mTexture = NULL;
-		mWidth = 0;
-		mHeight = 0;
-	}
+	const char* path = getOption( argc, args, "--map" );
+	return path != NULL ? path : "./golf.map";
 }
 
-void LTexture::setColor( Uint8 red, Uint8 green, Uint8 blue )
+CollisionMode getCollisionMode( int argc, char* args[] )
 {
-	//Modulate texture rgb
-	SDL_SetTextureColorMod( mTexture, red, green, blue );
-}
+	const char* mode = getOption( argc, args, "--collision" );
+	if( mode == NULL || strcmp( mode, "swept" ) == 0 )
+	{
+		return COLLISION_SWEPT;
+	}
 
-void LTexture::setBlendMode( SDL_BlendMode blending )
-{
-	//Set blending function
-	SDL_SetTextureBlendMode( mTexture, blending );
-}
+	if( strcmp( mode, "field" ) != 0 )
+	{
+		printf( "Unknown collision mode %s, using swept!\n", mode );
+		return COLLISION_SWEPT;
+	}
 
-void LTexture::setAlpha( Uint8 alpha )
-{
-	//Modulate texture alpha
-	SDL_SetTextureAlphaMod( mTexture, alpha );
+	return COLLISION_FIELD;
 }
 
-void LTexture::render( int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip )
+void setCollisionMode( Course& course, int argc, char* args[] )
 {
-	//Set rendering space and render to screen
-	SDL_Rect renderQuad = { x, y, mWidth, mHeight };
-
-	//Set clip rendering dimensions
-	if( clip != NULL )
+	if( getCollisionMode( argc, args ) == COLLISION_FIELD && !course.setCollisionMode( COLLISION_FIELD ) )
 	{
-		renderQuad.w = clip->w;
-		renderQuad.h = clip->h;
+		printf( "Failed to bake distance fields, using swept collision!\n" );
 	}
-
-	//Render to screen
-	SDL_RenderCopyEx( gRenderer, mTexture, clip, &renderQuad, angle, center, flip );
 }
 
-int LTexture::getWidth()
+std::string getReplayPath( const char* recordPath, int hole, int holeCount )
 {
-	return mWidth;
-}
+	std::string path = recordPath;
+	if( holeCount <= 1 )
+	{
+		return path;
+	}
 
-int LTexture::getHeight()
-{
-	return mHeight;
+	//round.grpl becomes round.3.grpl for the third hole
+	char number[ 16 ];
+	snprintf( number, sizeof( number ), ".%d", hole + 1 );
+	size_t extension = path.find_last_of( '.' );
+	if( extension == std::string::npos || path.find_first_of( "/\\", extension ) != std::string::npos )
+	{
+		return path + number;
+	}
+	return path.substr( 0, extension ) + number + path.substr( extension );
 }
 
-Tile::Tile( int x, int y, int tileType )
+void saveReplay( Replay& replay, const char* recordPath, const Session& session, uint32_t tick, const Dot& dot )
 {
-    //Get the offsets
-    mBox.x = x;
-    mBox.y = y;
-
-    //Set the collision box
-    mBox.w = TILE_WIDTH;
-    mBox.h = TILE_HEIGHT;
-
-    //Get the tile type
-    mType = tileType;
+	ReplayOutcome outcome = { tick, dot.numStrokes, dot.getState() };
+	replay.finish( outcome );
+	std::string path = getReplayPath( recordPath, session.getHole(), session.getHoleCount() );
+	if( replay.saveToFile( path ) )
+	{
+		printf( "Recorded replay to %s\n", path.c_str() );
+	}
 }
 
-void Tile::render()
+int compileMap( int argc, char* args[] )
 {
-	gTileTexture.render( mBox.x, mBox.y, &gTileClips[ mType ] );
-}
+	if( argc != 4 )
+	{
+		printf( "Usage: %s --compile-map <map> <compiled map>\n", args[ 0 ] );
+		return 1;
+	}
 
-int Tile::getType()
-{
-    return mType;
-}
+	//Parse the text map and write it back out compiled
+	TileMap tiles;
+	if( !tiles.loadFromFile( args[ 2 ] ) || !tiles.saveCompiled( args[ 3 ] ) )
+	{
+		printf( "Failed to compile map!\n" );
+		return 1;
+	}
 
-SDL_Rect Tile::getBox()
-{
-    return mBox;
+	printf( "Compiled %dx%d map to %s\n", tiles.getColumns(), tiles.getRows(), args[ 3 ] );
+	return 0;
 }
 
-Dot::Dot( int x, int y)
+int runSolver( int argc, char* args[] )
 {
-    //Initialize the offsets
-    mPosX = x;
-    mPosY = y;
-
-		//Set collision circle size
-		mCollider.r = DOT_WIDTH / 2;
-		mCollider.x = x;
-		mCollider.y = y;
-
-    //Initialize the velocity
-    mVelX = 0;
-    mVelY = 0;
+	//The collision data for the level
+	Course course;
+	if( !course.loadFromFile( getMapPath( argc, args ) ) )
+	{
+		printf( "Failed to load tile set!\n" );
+		return 1;
+	}
 
-		//Move collider relative to the circle
-		shiftColliders();
-}
+	//Pick the collision backend
+	setCollisionMode( course, argc, args );
 
-void Dot::handleEvent( SDL_Event& e )
-{
-		if (mVelX == 0 && mVelY == 0) {
-			if ( e.type == SDL_MOUSEBUTTONDOWN)
-			{
+	//Read the sampling options
+	SolverSettings settings = getDefaultSolverSettings();
+	if( getOption( argc, args, "--angles" ) != NULL ) settings.angles = atoi( getOption( argc, args, "--angles" ) );
+	if( getOption( argc, args, "--powers" ) != NULL ) settings.powers = atoi( getOption( argc, args, "--powers" ) );
+	if( getOption( argc, args, "--max-drag" ) != NULL ) settings.maxDrag = atof( getOption( argc, args, "--max-drag" ) );
+	if( settings.angles <= 0 || settings.powers <= 0 || settings.maxDrag <= 0 )
+	{
+		printf( "Usage: %s --solve [--threads <n>] [--angles <n>] [--powers <n>] [--max-drag <pixels>] [--collision swept|field] [--map <map>]\n", args[ 0 ] );
+		return 1;
+	}
 
-				mouseX_down = e.button.x;
-				mouseY_down = e.button.y;
+	ThreadPool pool( getOption( argc, args, "--threads" ) != NULL ? atoi( getOption( argc, args, "--threads" ) ) : 0 );
 
-			}
-			if ( e.type == SDL_MOUSEBUTTONUP)
-			{
-				mouseX_up = e.button.x;
-				mouseY_up = e.button.y;
-				float changeX;
-				float changeY;
-				changeX = mouseX_down - mouseX_up;
-				changeY = mouseY_down - mouseY_up;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	SolverResult result = solveCourse( course, settings, pool );
+	double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
 
-				mVelX += changeX * 3;
-				mVelY += changeY * 3;
+	printf( "Par: %d\n", result.par );
+	printf( "Tee hole chance: %.4f\n", result.teeHoleChance );
+	printf( "Shots: %lld in %.2fs on %d threads\n", result.shots, seconds, pool.getThreadCount() );
 
-				numStrokes++;
-			}
+	//Show strokes to the hole from every cell
+	const TileMap& tiles = course.getTiles();
+	for( int row = 0; row < tiles.getRows(); ++row )
+	{
+		for( int column = 0; column < tiles.getColumns(); ++column )
+		{
+			int i = row * tiles.getColumns() + column;
+			if( tiles.getType( i ) == TILE_BLACK ) printf( " #" );
+			else if( tiles.getType( i ) == TILE_YELLOW ) printf( " O" );
+			else if( result.cells[ i ].strokes < 0 ) printf( " -" );
+			else printf( " %d", result.cells[ i ].strokes );
 		}
+		printf( "\n" );
+	}
 
+	return 0;
 }
 
-void Dot::move( Tile *tiles[] , float timeStep )
+int runGenerator( int argc, char* args[] )
 {
-    //Move the dot left or right
-		float oldX = mPosX;
-		float oldY = mPosY;
-
-    mPosX += (mVelX * timeStep);
-
-		shiftColliders();
-
-    //If the dot went too far to the left or right
-    if( mPosX < DOT_WIDTH / 2 )
-    {
-        mPosX = DOT_WIDTH / 2;
-				mVelX = -mVelX;
-    }
-    else if( mPosX > SCREEN_WIDTH - (DOT_WIDTH / 2) )
-    {
-        mPosX = SCREEN_WIDTH - (DOT_WIDTH / 2);
-				mVelX = -mVelX;
-    }
-		else if (touchesWall( mCollider, tiles ))
-		{
-			mPosX = oldX;
-			mVelX = -mVelX;
-		}
+	//Read the layout and acceptance options
+	GeneratorSettings settings = getDefaultGeneratorSettings();
+	if( getOption( argc, args, "--columns" ) != NULL ) settings.columns = atoi( getOption( argc, args, "--columns" ) );
+	if( getOption( argc, args, "--rows" ) != NULL ) settings.rows = atoi( getOption( argc, args, "--rows" ) );
+	if( getOption( argc, args, "--min-par" ) != NULL ) settings.minPar = atoi( getOption( argc, args, "--min-par" ) );
+	if( getOption( argc, args, "--max-par" ) != NULL ) settings.maxPar = atoi( getOption( argc, args, "--max-par" ) );
+	if( getOption( argc, args, "--walls" ) != NULL ) settings.wallChance = atof( getOption( argc, args, "--walls" ) );
+	if( getOption( argc, args, "--seed" ) != NULL ) settings.seed = strtoul( getOption( argc, args, "--seed" ), NULL, 10 );
+	if( getOption( argc, args, "--angles" ) != NULL ) settings.solver.angles = atoi( getOption( argc, args, "--angles" ) );
+	if( getOption( argc, args, "--powers" ) != NULL ) settings.solver.powers = atoi( getOption( argc, args, "--powers" ) );
+	int count = argc >= 4 ? atoi( args[ 2 ] ) : 0;
+	if( count <= 0 || settings.columns < GENERATOR_MIN_COLUMNS || settings.rows < GENERATOR_MIN_ROWS || (long long)settings.columns * settings.rows > MAX_TOTAL_TILES ||
+		settings.minPar < 1 || settings.maxPar < settings.minPar || settings.solver.angles <= 0 || settings.solver.powers <= 0 )
+	{
+		printf( "Usage: %s --generate <count> <directory> [--threads <n>] [--seed <n>] [--columns <n>] [--rows <n>] [--walls <chance>] [--min-par <n>] [--max-par <n>] [--angles <n>] [--powers <n>]\n", args[ 0 ] );
+		return 1;
+	}
 
-		shiftColliders();
-
-    //Move the dot up or down
-    mPosY += (mVelY * timeStep);
-		shiftColliders();
-
-    // //If the dot went too far up or down or touched a wall
-		if( mPosY < DOT_WIDTH / 2 )
-    {
-        mPosY = DOT_WIDTH / 2;
-				mVelY = -mVelY;
-    }
-    else if( mPosY > SCREEN_HEIGHT - (DOT_WIDTH / 2 ))
-    {
-        mPosY = SCREEN_HEIGHT - (DOT_WIDTH / 2);
-				mVelY = -mVelY;
-    }
-		else if (touchesWall( mCollider, tiles ))
-		{
-			mPosY = oldY;
-			mVelY = -mVelY;
-		}
-		shiftColliders();
+	//Accepted maps are listed as they're written so the list can be played with --course
+	std::string directory = args[ 3 ];
+	std::string listPath = directory + "/courses.txt";
+	FILE* list = fopen( listPath.c_str(), "a" );
+	if( list == NULL )
+	{
+		printf( "Unable to write course list %s!\n", listPath.c_str() );
+		return 1;
+	}
 
-		if (touchesHole(mCollider, tiles)) {
-			touchingHole = true;
-		}
+	ThreadPool pool( getOption( argc, args, "--threads" ) != NULL ? atoi( getOption( argc, args, "--threads" ) ) : 0 );
+	CourseGenerator generator( settings, pool );
+	int roundSize = pool.getThreadCount() * GENERATE_ROUND_PER_THREAD;
 
-		mVelX = mVelX * 0.97;
-		mVelY = mVelY * 0.97;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	TileMap tiles;
+	int written = 0;
+	int emptyRounds = 0;
+	while( written < count && emptyRounds < GENERATE_MAX_EMPTY_ROUNDS )
+	{
+		int accepted = generator.generateRound( roundSize );
+		emptyRounds = accepted > 0 ? 0 : emptyRounds + 1;
 
-		if (mVelX < 20 && mVelX > -20 && mVelY < 20 && mVelY > -20)
+		//Stream each round's courses out before the next one starts
+		for( int i = 0; i < accepted && written < count; ++i )
 		{
-			mVelX = 0;
-			mVelY = 0;
+			const GeneratedCourse& course = generator.getAccepted( i );
+			char name[ 64 ];
+			snprintf( name, sizeof( name ), "/course-%u-%u.gmap", settings.seed, course.candidate );
+			std::string path = directory + name;
+			if( !tiles.loadFromTypes( settings.columns, settings.rows, &course.types[ 0 ] ) || !tiles.saveCompiled( path ) )
+			{
+				fclose( list );
+				return 1;
+			}
+			fprintf( list, "%s\n", path.c_str() );
+			++written;
 		}
-}
+		fflush( list );
 
-void Dot::render()
-{
-    //Show the dot
-	gDotTexture.render( int(mPosX - mCollider.r), int(mPosY - mCollider.r));
-	// std::cout << "rendered at: " << (mPosX - mCollider.r) << ", "  << (mPosY - mCollider.r) << std::endl;
-	// std::cout << "collision at: " << mPosX << ", " << mPosY << std::endl;
-}
+		double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+		printf( "Accepted %d of %lld candidates, %.0f courses a minute\n", written, generator.getCandidateCount(), seconds > 0 ? written * 60 / seconds : 0.0 );
+	}
+	fclose( list );
 
-Circle& Dot::getCollider()
-{
-	return mCollider;
-}
+	double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+	printf( "Shots: %lld in %.2fs on %d threads\n", generator.getShotCount(), seconds, pool.getThreadCount() );
+	if( written < count )
+	{
+		printf( "Gave up after %d rounds without a course that passed!\n", GENERATE_MAX_EMPTY_ROUNDS );
+		return 1;
+	}
 
-void Dot::shiftColliders()
-{
-	//Align collider to center of dot
-	mCollider.x = int(mPosX);
-	mCollider.y = int(mPosY);
-	//std::cout << "collsion point at: " << (mCollider.x) << (mCollider.y) << std::endl;
+	return 0;
 }
 
-LTimer::LTimer()
+int runSimulation( int argc, char* args[] )
 {
-    //Initialize the variables
-    mStartTicks = 0;
-    mPausedTicks = 0;
+	//The collision data for the level
+	Course course;
+	if( !course.loadFromFile( getMapPath( argc, args ) ) )
+	{
+		printf( "Failed to load tile set!\n" );
+		return 1;
+	}
 
-    mPaused = false;
-    mStarted = false;
-}
+	//Pick the collision backend
+	setCollisionMode( course, argc, args );
 
-void LTimer::start()
-{
-    //Start the timer
-    mStarted = true;
+	//The ball starts on the tee
+	BallState tee = makeTeeBall( course );
 
-    //Unpause the timer
-    mPaused = false;
+	//The stock map runs through the course specialized for it, any other map through the loaded one
+	bool stock = course.getCollisionMode() == COLLISION_SWEPT && STOCK_COURSE.matches( course.getTiles() );
 
-    //Get the current clock time
-    mStartTicks = SDL_GetTicks();
-	mPausedTicks = 0;
-}
-
-void LTimer::stop()
-{
-    //Stop the timer
-    mStarted = false;
+	//Simulate a single shot
+	if( strcmp( args[ 1 ], "--simulate" ) == 0 && argc >= 6 )
+	{
+		BallState start = makeBall( atof( args[ 2 ] ), atof( args[ 3 ] ) );
+		ShotResult result = stock ? simulateShot( STOCK_COURSE, start, atof( args[ 4 ] ), atof( args[ 5 ] ) ) : simulateShot( course, start, atof( args[ 4 ] ), atof( args[ 5 ] ) );
 
-    //Unpause the timer
-    mPaused = false;
+		printf( "Steps: %d\n", result.steps );
+		printf( "Rest: %f, %f\n", result.ball.posX, result.ball.posY );
+		printf( "Holed: %s\n", result.ball.touchingHole ? "yes" : "no" );
+		return 0;
+	}
 
-	//Clear tick variables
-	mStartTicks = 0;
-	mPausedTicks = 0;
-}
+	//Simulate random drags from the tee
+	if( strcmp( args[ 1 ], "--simulate-batch" ) == 0 && argc >= 3 )
+	{
+		int shots = atoi( args[ 2 ] );
+		unsigned int seed = argc > 3 && args[ 3 ][ 0 ] != '-' ? atoi( args[ 3 ] ) : 1;
 
-void LTimer::pause()
-{
-    //If the timer is running and isn't already paused
-    if( mStarted && !mPaused )
-    {
-        //Pause the timer
-        mPaused = true;
-
-        //Calculate the paused ticks
-        mPausedTicks = SDL_GetTicks() - mStartTicks;
-		mStartTicks = 0;
-    }
-}
+		int holed = 0;
+		long long steps = 0;
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		for( int i = 0; i < shots; ++i )
+		{
+			//Drag up to 200 pixels on either axis like handleEvent would see
+			seed = seed * 1103515245 + 12345;
+			float changeX = (int)( ( seed >> 16 ) % 401 ) - 200;
+			seed = seed * 1103515245 + 12345;
+			float changeY = (int)( ( seed >> 16 ) % 401 ) - 200;
+
+			ShotResult result = stock ? simulateShot( STOCK_COURSE, tee, changeX * DRAG_VELOCITY, changeY * DRAG_VELOCITY ) : simulateShot( course, tee, changeX * DRAG_VELOCITY, changeY * DRAG_VELOCITY );
+			steps += result.steps;
+			if( result.ball.touchingHole )
+			{
+				++holed;
+			}
+		}
+		double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
 
-void LTimer::unpause()
-{
-    //If the timer is running and paused
-    if( mStarted && mPaused )
-    {
-        //Unpause the timer
-        mPaused = false;
-
-        //Reset the starting ticks
-        mStartTicks = SDL_GetTicks() - mPausedTicks;
-
-        //Reset the paused ticks
-        mPausedTicks = 0;
-    }
-}
+		printf( "Shots: %d%s\n", shots, stock ? " through the built in stock course" : "" );
+		printf( "Holed: %d\n", holed );
+		printf( "Steps: %lld\n", steps );
+		printf( "Shots per second: %.0f\n", seconds > 0 ? shots / seconds : 0.0 );
+		return 0;
+	}
 
-Uint32 LTimer::getTicks()
-{
-	//The actual timer time
-	Uint32 time = 0;
-
-    //If the timer is running
-    if( mStarted )
-    {
-        //If the timer is paused
-        if( mPaused )
-        {
-            //Return the number of ticks when the timer was paused
-            time = mPausedTicks;
-        }
-        else
-        {
-            //Return the current time minus the start time
-            time = SDL_GetTicks() - mStartTicks;
-        }
-    }
-
-    return time;
+	printf( "Usage: %s --simulate <x> <y> <velX> <velY> [--map <map>]\n", args[ 0 ] );
+	printf( "       %s --simulate-batch <shots> [seed] [--map <map>]\n", args[ 0 ] );
+	return 1;
 }
 
-bool LTimer::isStarted()
+int runReplays( int argc, char* args[] )
 {
-	//Timer is running and paused or unpaused
-    return mStarted;
-}
+	//Replay files follow the flag up to the first option
+	std::vector<std::string> paths;
+	for( int i = 2; i < argc && strncmp( args[ i ], "--", 2 ) != 0; ++i )
+	{
+		paths.push_back( args[ i ] );
+	}
+	if( paths.empty() )
+	{
+		printf( "Usage: %s --replay <replay>... [--threads <n>] [--map <map>]\n", args[ 0 ] );
+		return 1;
+	}
 
-bool LTimer::isPaused()
-{
-	//Timer is running and paused
-    return mPaused && mStarted;
-}
+	//Load every replay, -1 marks ones that can't be played
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	const char* mapOverride = getOption( argc, args, "--map" );
+	std::vector<Replay> replays( paths.size() );
+	std::vector<int> replayCourses( paths.size(), -1 );
+	std::vector<std::string> coursePaths;
+	std::vector<CollisionMode> courseModes;
+	for( size_t i = 0; i < paths.size(); ++i )
+	{
+		if( !replays[ i ].loadFromFile( paths[ i ] ) )
+		{
+			continue;
+		}
 
-bool init()
-{
-	//Initialization flag
-	bool success = true;
+		//Rounds on the same map and backend share one course
+		std::string mapPath = mapOverride != NULL ? mapOverride : replays[ i ].getMapPath();
+		size_t course = 0;
+		while( course < coursePaths.size() && ( coursePaths[ course ] != mapPath || courseModes[ course ] != replays[ i ].getCollisionMode() ) )
+		{
+			++course;
+		}
+		if( course == coursePaths.size() )
+		{
+			coursePaths.push_back( mapPath );
+			courseModes.push_back( replays[ i ].getCollisionMode() );
+		}
+		replayCourses[ i ] = course;
+	}
 
-	//Initialize SDL
-	if( SDL_Init( SDL_INIT_VIDEO ) < 0 )
+	//Load the courses
+	std::vector<Course> courses( coursePaths.size() );
+	std::vector<bool> courseLoaded( coursePaths.size(), false );
+	for( size_t i = 0; i < courses.size(); ++i )
 	{
-		printf( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
-		success = false;
+		courseLoaded[ i ] = courses[ i ].loadFromFile( coursePaths[ i ] ) && courses[ i ].setCollisionMode( courseModes[ i ] );
+		if( !courseLoaded[ i ] )
+		{
+			printf( "Failed to load course %s!\n", coursePaths[ i ].c_str() );
+		}
 	}
-	else
+
+	//Each replay only reads its shared course
+	ThreadPool pool( getOption( argc, args, "--threads" ) != NULL ? atoi( getOption( argc, args, "--threads" ) ) : 0 );
+	std::vector<ReplayOutcome> outcomes( paths.size() );
+	pool.parallelFor( paths.size(), [ & ]( int i, int worker )
 	{
-		//Set texture filtering to linear
-		if( !SDL_SetHint( SDL_HINT_RENDER_SCALE_QUALITY, "1" ) )
+		if( replayCourses[ i ] != -1 && courseLoaded[ replayCourses[ i ] ] )
 		{
-			printf( "Warning: Linear texture filtering not enabled!" );
+			outcomes[ i ] = playReplay( replays[ i ], courses[ replayCourses[ i ] ] );
 		}
+	} );
 
-		//Create window
-		gWindow = SDL_CreateWindow( "SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN );
-		if( gWindow == NULL )
+	int failed = 0;
+	for( size_t i = 0; i < paths.size(); ++i )
+	{
+		if( replayCourses[ i ] == -1 || !courseLoaded[ replayCourses[ i ] ] )
 		{
-			printf( "Window could not be created! SDL Error: %s\n", SDL_GetError() );
-			success = false;
+			++failed;
+			continue;
 		}
-		else
-		{
-			//Create renderer for window | SDL_RENDERER_PRESENTVSYNC
-			gRenderer = SDL_CreateRenderer( gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-			if( gRenderer == NULL )
-			{
-				printf( "Renderer could not be created! SDL Error: %s\n", SDL_GetError() );
-				success = false;
-			}
-			else
-			{
-				//Initialize renderer color
-				SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
 
-				//Initialize PNG loading
-				int imgFlags = IMG_INIT_PNG;
-				if( !( IMG_Init( imgFlags ) & imgFlags ) )
-				{
-					printf( "SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError() );
-					success = false;
-				}
-			}
+		const ReplayOutcome& expected = replays[ i ].getOutcome();
+		if( !isSameOutcome( outcomes[ i ], expected ) )
+		{
+			printf( "Mismatch in %s: expected %d strokes at %f, %f after %u ticks, got %d strokes at %f, %f after %u ticks\n", paths[ i ].c_str(),
+				expected.strokes, expected.ball.posX, expected.ball.posY, expected.ticks,
+				outcomes[ i ].strokes, outcomes[ i ].ball.posX, outcomes[ i ].ball.posY, outcomes[ i ].ticks );
+			++failed;
 		}
 	}
+	double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
 
-	return success;
+	printf( "Verified %d replays in %.2fs on %d threads, %d failed\n", (int)paths.size(), seconds, pool.getThreadCount(), failed );
+	return failed == 0 ? 0 : 1;
 }
 
-bool loadMedia( Tile* tiles[] )
+int runClient( int argc, char* args[] )
 {
-	//Loading success flag
-	bool success = true;
-
-	//Load dot texture
-	if( !gDotTexture.loadFromFile( "./dot.bmp" ) )
+	if( argc < 3 )
 	{
-		printf( "Failed to load dot texture!\n" );
-		success = false;
+		printf( "Usage: %s --join <host:port> [--match <id>] [--courses <directory>]\n", args[ 0 ] );
+		return 1;
 	}
 
-	//Load tile texture
-	if( !gTileTexture.loadFromFile( "./tiles.png" ) )
+	NetClient client;
+	const char* match = getOption( argc, args, "--match" );
+	if( !client.connect( args[ 2 ], match != NULL ? strtoul( match, NULL, 10 ) : 0 ) )
 	{
-		printf( "Failed to load tile set texture!\n" );
-		success = false;
+		return 1;
 	}
 
-	//Load tile map
-	if( !setTiles( tiles ) )
+	//Wait to be let in before opening the window
+	while( client.isOpen() && !client.isConnected() )
 	{
-		printf( "Failed to load tile set!\n" );
-		success = false;
+		std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+		client.update( 0.01, NULL );
 	}
-
-	return success;
-}
-
-void close( Tile* tiles[] )
-{
-	//Deallocate tiles
-	for( int i = 0; i < TOTAL_TILES; ++i )
+	if( !client.isConnected() )
 	{
-		 if( tiles[ i ] != NULL )
-		 {
-			delete tiles[ i ];
-			tiles[ i ] = NULL;
-		 }
+		return 1;
 	}
 
-	//Free loaded images
-	gDotTexture.free();
-	gTileTexture.free();
-
-	//Destroy window
-	SDL_DestroyRenderer( gRenderer );
-	SDL_DestroyWindow( gWindow );
-	gWindow = NULL;
-	gRenderer = NULL;
-
-	//Quit SDL subsystems
-	IMG_Quit();
-	SDL_Quit();
-}
-
-bool checkCollision( Circle& a, SDL_Rect b )
-{
-    //Closest point on collision box
-    float cX, cY;
-
-    //Find closest x offset
-    if( a.x < b.x )
-    {
-        cX = b.x;
-    }
-    else if( a.x > b.x + b.w )
-    {
-        cX = b.x + b.w;
-    }
-    else
-    {
-        cX = a.x;
-    }
-
-    //Find closest y offset
-    if( a.y < b.y )
-    {
-        cY = b.y;
-    }
-    else if( a.y > b.y + b.h )
-    {
-        cY = b.y + b.h;
-    }
-    else
-    {
-        cY = a.y;
-    }
-
-    //If the closest point is inside the circle
-    if( distanceSquared( a.x, a.y, cX, cY ) < a.r * a.r )
-    {
-        //This box and the circle have collided
-        return true;
-    }
-
-    //If the shapes have not collided
-    return false;
-}
+	//Start up SDL and create window
+	if( !init() )
+	{
+		printf( "Failed to initialize!\n" );
+	}
+	else
+	{
+		//The server names the course, it's looked up in our own course directory
+		const char* courses = getOption( argc, args, "--courses" );
+		std::string mapPath = std::string( courses != NULL ? courses : "." ) + "/" + client.getCourseName();
+		Course course;
+		if( !loadMedia( course, mapPath ) || ( client.getCollisionMode() != COLLISION_SWEPT && !course.setCollisionMode( client.getCollisionMode() ) ) )
+		{
+			printf( "Failed to load media!\n" );
+		}
+		else
+		{
+			bool quit = false;
+			int strokes = 0;
+			SDL_Event e;
+			SDL_Rect camera = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+			Uint64 lastCounter = SDL_GetPerformanceCounter();
 
-bool setTiles( Tile* tiles[] )
-{
-	//Success flag
-	bool tilesLoaded = true;
+			//Play until our ball drops in or the connection goes
+			while( !quit && client.isConnected() && !client.getBall().touchingHole )
+			{
+				//Strokes go to the server, and are predicted straight away
+				while( SDL_PollEvent( &e ) != 0 )
+				{
+					if( e.type == SDL_QUIT )
+					{
+						quit = true;
+					}
 
-    //The tile offsets
-    int x = 0, y = 0;
+					if( ( e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP ) &&
+						client.handleMouseButton( e.type == SDL_MOUSEBUTTONDOWN, e.button.x, e.button.y ) )
+					{
+						++strokes;
+					}
+				}
 
-    //Open the map
-    std::ifstream map( "./golf.map" );
+				//Predict the balls over the real time since last frame
+				Uint64 counter = SDL_GetPerformanceCounter();
+				double frameTime = ( counter - lastCounter ) / (double)SDL_GetPerformanceFrequency();
+				lastCounter = counter;
+				client.update( frameTime, &course );
 
-    //If the map couldn't be loaded
-    if( map.fail() )
-    {
-		printf( "Unable to load map file!\n" );
-		tilesLoaded = false;
-    }
-	else
-	{
-		//Initialize the tiles
-		for( int i = 0; i < TOTAL_TILES; ++i )
-		{
-			//Determines what kind of tile will be made
-			int tileType = -1;
+				//Clear screen
+				SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
+				SDL_RenderClear( gRenderer );
 
-			//Read tile from map file
-			map >> tileType;
+				//Render level around our ball
+				centerCamera( camera, client.getBall().posX, client.getBall().posY, course.getTiles() );
+				gTileLayer.render( course.getTiles(), camera );
 
-			//If the was a problem in reading the map
-			if( map.fail() )
-			{
-				//Stop loading map
-				printf( "Error loading map: Unexpected end of file!\n" );
-				tilesLoaded = false;
-				break;
-			}
+				//Render every player's ball
+				const std::vector<BallState>& balls = client.getBalls();
+				for( size_t i = 0; i < balls.size(); ++i )
+				{
+					if( client.isPresent( i ) )
+					{
+						renderBall( balls[ i ], camera );
+					}
+				}
+				gSprites.flush( gRenderer );
 
-			//If the number is a valid tile number
-			if( ( tileType >= 0 ) && ( tileType < TOTAL_TILE_SPRITES ) )
-			{
-				tiles[ i ] = new Tile( x, y, tileType );
-			}
-			//If we don't recognize the tile type
-			else
-			{
-				//Stop loading map
-				printf( "Error loading map: Invalid tile type at %d!\n", i );
-				tilesLoaded = false;
-				break;
+				//Update screen
+				SDL_RenderPresent( gRenderer );
 			}
 
-			//Move to next tile spot
-			x += TILE_WIDTH;
-
-			//If we've gone too far
-			if( x >= SCREEN_WIDTH )
+			if( client.getBall().touchingHole )
 			{
-				//Move back
-				x = 0;
-
-				//Move to the next row
-				y += TILE_HEIGHT;
+				std::cout << "U WON!" << std::endl;
 			}
+			std::cout << "Strokes: " << strokes << std::endl;
 		}
 
-		//Clip the sprite sheet
-		if( tilesLoaded )
-		{
-			gTileClips[ TILE_BLACK ].x = 0;
-			gTileClips[ TILE_BLACK ].y = 0;
-			gTileClips[ TILE_BLACK ].w = TILE_WIDTH;
-			gTileClips[ TILE_BLACK ].h = TILE_HEIGHT;
-
-			gTileClips[ TILE_GREEN ].x = 0;
-			gTileClips[ TILE_GREEN ].y = 80;
-			gTileClips[ TILE_GREEN ].w = TILE_WIDTH;
-			gTileClips[ TILE_GREEN ].h = TILE_HEIGHT;
-
-			gTileClips[ TILE_YELLOW ].x = 0;
-			gTileClips[ TILE_YELLOW ].y = 160;
-			gTileClips[ TILE_YELLOW ].w = TILE_WIDTH;
-			gTileClips[ TILE_YELLOW ].h = TILE_HEIGHT;
-		}
+		//Free resources and close SDL
+		client.disconnect();
+		close();
 	}
 
-    //Close the file
-    map.close();
-
-    //If the map was loaded fine
-    return tilesLoaded;
+	return 0;
 }
 
-bool touchesWall( Circle& circle, Tile* tiles[] )
+int main( int argc, char* args[] )
 {
-    //Go through the tiles
-    for( int i = 0; i < TOTAL_TILES; ++i )
-    {
-        //If the tile is a wall type tile
-        if( ( tiles[ i ]->getType() == TILE_BLACK ))
-        {
-            //If the collision box touches the wall tile
-            if( checkCollision( circle , tiles[ i ]->getBox() ) )
-            {
-                return true;
-            }
-        }
-    }
-
-    //If no wall tiles were touched
-    return false;
-}
+	//Batch shot simulation never touches SDL
+	if( argc > 1 && strncmp( args[ 1 ], "--simulate", 10 ) == 0 )
+	{
+		return runSimulation( argc, args );
+	}
 
-bool touchesHole( Circle& circle, Tile* tiles[] )
-{
-    //Go through the tiles
-    for( int i = 0; i < TOTAL_TILES; ++i )
-    {
-        //If the tile is a hole type tile
-        if( ( tiles[ i ]->getType() == TILE_YELLOW ))
-        {
-            //If the collision box touches the hole tile
-            if( checkCollision( circle , tiles[ i ]->getBox() ) )
-            {
-                return true;
-            }
-        }
-    }
-
-    //If no hole tiles were touched
-    return false;
-}
+	//Neither does compiling maps
+	if( argc > 1 && strcmp( args[ 1 ], "--compile-map" ) == 0 )
+	{
+		return compileMap( argc, args );
+	}
 
-double distanceSquared( int x1, int y1, int x2, int y2 )
-{
-	int deltaX = x2 - x1;
-	int deltaY = y2 - y1;
-	return deltaX*deltaX + deltaY*deltaY;
-}
+	//Or solving courses
+	if( argc > 1 && strcmp( args[ 1 ], "--solve" ) == 0 )
+	{
+		return runSolver( argc, args );
+	}
+
+	//Or generating courses
+	if( argc > 1 && strcmp( args[ 1 ], "--generate" ) == 0 )
+	{
+		return runGenerator( argc, args );
+	}
+
+	//Or checking replays
+	if( argc > 1 && strcmp( args[ 1 ], "--replay" ) == 0 )
+	{
+		return runReplays( argc, args );
+	}
+
+	//Joining a hosted match gets its own loop
+	if( argc > 1 && strcmp( args[ 1 ], "--join" ) == 0 )
+	{
+		return runClient( argc, args );
+	}
 
-int main( int argc, char* args[] )
-{
 	//Start up SDL and create window
 	if( !init() )
 	{
@@ -929,11 +627,20 @@ int main( int argc, char* args[] )
 	}
 	else
 	{
-		//The level tiles
-		Tile* tileSet[ TOTAL_TILES ];
+		//The level
+		Course course;
+
+		//The holes to play, each next one loads while the current one is played
+		Session session;
+		const char* coursePath = getOption( argc, args, "--course" );
+		bool holesListed = coursePath != NULL ? session.loadFromFile( coursePath ) : true;
+		if( coursePath == NULL )
+		{
+			session.setHoles( std::vector<std::string>( 1, getMapPath( argc, args ) ) );
+		}
 
 		//Load media
-		if( !loadMedia( tileSet ) )
+		if( !holesListed || !session.begin( course, getCollisionMode( argc, args ) ) )
 		{
 			printf( "Failed to load media!\n" );
 		}
@@ -946,15 +653,99 @@ int main( int argc, char* args[] )
 			//Event handler
 			SDL_Event e;
 
+			//Mouse buttons waiting for the physics tick they happened during
+			InputQueue input;
+
 			//The dot that will be moving around on the screen
-			Dot dot( SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80);
+			BallState tee = makeTeeBall( course );
+			Dot dot( tee.posX, tee.posY );
+
+			//The part of the level on screen, following the dot
+			SDL_Rect camera = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+			dot.setCamera( camera, course.getTiles() );
+
+			//Only repaint what changed and sleep while nothing moves
+			bool lowPower = hasFlag( argc, args, "--low-power" );
+
+			//Pick up edits to the map while it's being played
+			FileWatcher watcher;
+			if( hasFlag( argc, args, "--watch" ) )
+			{
+				watcher.watch( session.getMapPath() );
+			}
+			std::vector<int> changedTiles;
 
-			LTimer stepTimer;
+			//Where the shot being dragged would go, worked out off the main thread
+			TrajectoryPredictor predictor;
+			predictor.start( course );
+
+			//The physics runs at a fixed rate independent of the display
+			int tickRate = PHYSICS_TICK_RATE;
+			const char* tickRateOption = getOption( argc, args, "--tick-rate" );
+			if( tickRateOption != NULL && atoi( tickRateOption ) >= 30 && atoi( tickRateOption ) <= 1000 )
+			{
+				tickRate = atoi( tickRateOption );
+			}
+			float physicsStep = 1.f / tickRate;
+
+			//The round's input, kept by physics tick so it can be played back
+			const char* recordPath = getOption( argc, args, "--record" );
+			Replay replay;
+			replay.begin( session.getMapPath(), tickRate, course.getCollisionMode() );
+			uint32_t tick = 0;
+
+			//Time every phase of the frame, F3 toggles the overlay
+			FrameProfiler profiler;
+			bool showProfile = hasFlag( argc, args, "--profile-overlay" );
+			const char* profilePath = getOption( argc, args, "--profile" );
+			if( profilePath != NULL )
+			{
+				profiler.openDump( profilePath );
+			}
+
+			//Real time not yet simulated
+			double accumulator = 0;
+			Uint64 lastCounter = SDL_GetPerformanceCounter();
+
+			//The path drawn last, so a new one gets repainted
+			uint32_t shownPath = 0;
+
+			//Shot and frame metrics exported in the background with --telemetry, with the export interval in seconds
+			Telemetry telemetry;
+			const char* telemetryPath = getOption( argc, args, "--telemetry" );
+			const char* telemetryInterval = getOption( argc, args, "--telemetry-interval" );
+			if( telemetryPath != NULL && !telemetry.start( telemetryPath, telemetryInterval != NULL ? (int)( atof( telemetryInterval ) * 1000 ) : TELEMETRY_DEFAULT_INTERVAL_MS ) )
+			{
+				printf( "Failed to start telemetry!\n" );
+			}
+
+			//The tick the rolling shot was played on, for how long it takes to settle
+			bool shotRolling = false;
+			uint32_t shotTick = 0;
+
+			//Heap use counted once the hole has started
+			size_t holeAllocations = getAllocationCount();
 
 			//While application is running
 			while( !quit and !win)
 			{
+				profiler.beginFrame();
+
+				//Wait for input instead of spinning while the dot is at rest, no press is queued for it and no path is on its way
+				double waited = 0;
+				if( lowPower && dot.isAtRest() && input.getPendingCount() == 0 && !gDirtyRegions.isDirty() && !predictor.isPredicting() )
+				{
+					ProfileScope idle( profiler, PHASE_IDLE );
+					Uint64 waitStart = SDL_GetPerformanceCounter();
+					SDL_WaitEventTimeout( NULL, IDLE_WAIT_MS );
+
+					//Don't simulate the sleep unless it brought input
+					lastCounter = SDL_GetPerformanceCounter();
+					waited = ( lastCounter - waitStart ) / (double)SDL_GetPerformanceFrequency();
+				}
+
 				//Handle events on queue
+				profiler.beginPhase( PHASE_EVENTS );
 				while( SDL_PollEvent( &e ) != 0 )
 				{
 					//User requests quit
@@ -963,49 +754,283 @@ int main( int argc, char* args[] )
 						quit = true;
 					}
 
-					//Handle input for the dot
-					dot.handleEvent( e );
+					//Show or hide the frame timings
+					if( e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3 )
+					{
+						showProfile = !showProfile;
+					}
+
+					//Target textures may be lost with the device
+					if( e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET )
+					{
+						gTileLayer.invalidate();
+						gDirtyRegions.free();
+					}
+
+					//Every texture is lost with the device
+					if( e.type == SDL_RENDER_DEVICE_RESET )
+					{
+						gAtlas.restore();
+					}
+
+					//The window contents may have been lost
+					if( e.type == SDL_WINDOWEVENT && ( e.window.event == SDL_WINDOWEVENT_EXPOSED || e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED ) )
+					{
+						gDirtyRegions.invalidate();
+					}
+
+					//Mouse buttons reach the dot on the tick they happened during
+					input.push( e );
 				}
+				profiler.endPhase( PHASE_EVENTS );
 
-				//Calculate time step
-				float timeStep = stepTimer.getTicks() / 1000.f;
+				//Swap in only what an edit to the map changed, keeping the old map if the new one doesn't parse
+				if( watcher.poll() )
+				{
+					Uint64 reloadStart = SDL_GetPerformanceCounter();
+					bool replaced;
+
+					//The predictor reads the course so it has to be off it while the map changes
+					predictor.stop();
+					dot.setPath( NULL );
+					bool reloaded = course.reloadFromFile( watcher.getPath(), changedTiles, replaced );
+					predictor.start( course );
+					if( reloaded )
+					{
+						if( replaced )
+						{
+							gTileLayer.invalidate();
+						}
+						else
+						{
+							gTileLayer.update( course.getTiles(), changedTiles );
+						}
+						gDirtyRegions.invalidate();
+
+						double reloadTime = ( SDL_GetPerformanceCounter() - reloadStart ) * 1000.0 / SDL_GetPerformanceFrequency();
+						if( replaced )
+						{
+							printf( "Reloaded %s in %.2fms\n", watcher.getPath().c_str(), reloadTime );
+						}
+						else
+						{
+							printf( "Reloaded %d changed tiles of %s in %.2fms\n", (int)changedTiles.size(), watcher.getPath().c_str(), reloadTime );
+						}
+					}
+					else
+					{
+						printf( "Keeping the last good version of %s!\n", watcher.getPath().c_str() );
+					}
 
-				//Move the dot
-				dot.move( tileSet, timeStep);
+					//Reloading is allowed to allocate
+					holeAllocations = getAllocationCount();
+				}
 
-				stepTimer.start();
+				//Accumulate the real time since last frame
+				Uint64 counter = SDL_GetPerformanceCounter();
+				Uint32 eventClock = SDL_GetTicks();
+				double frameTime = ( counter - lastCounter ) / (double)SDL_GetPerformanceFrequency();
+				lastCounter = counter;
+				telemetry.count( TELEMETRY_FRAMES );
+				telemetry.observe( TELEMETRY_FRAME_TIME, (uint64_t)( frameTime * 1e6 ) );
+				if( frameTime > MAX_FRAME_TIME )
+				{
+					frameTime = MAX_FRAME_TIME;
+				}
+				accumulator += frameTime;
 
-				//Clear screen
-				SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
-				SDL_RenderClear( gRenderer );
+				//A press or release that woke the loop happened during the sleep, so the ticks up to it are simulated now
+				if( waited > 0 && input.getPendingCount() > 0 )
+				{
+					accumulator = std::min( accumulator + waited, MAX_FRAME_TIME );
+				}
 
-				//Render level
-				for( int i = 0; i < TOTAL_TILES; ++i )
+				//Move the dot in fixed steps
+				profiler.beginPhase( PHASE_PHYSICS );
+				SDL_Rect oldCamera = camera;
+				SDL_Rect oldBox = dot.getBox( camera );
+				SDL_Rect oldAim = dot.getAimBox( camera );
+				input.beginTicks( eventClock - accumulator * 1000.0, physicsStep );
+				for( int batchTick = 0; accumulator >= physicsStep && !dot.touchingHole; ++batchTick )
 				{
-					tileSet[ i ]->render();
+					//Strokes land on the sub frame tick they were played on rather than the frame's first
+					InputRecord record;
+					while( input.pop( batchTick, record ) )
+					{
+						replay.record( tick, record.down, record.x, record.y );
+						int strokes = dot.numStrokes;
+						dot.handleMouseButton( record.down, record.x, record.y );
+						if( dot.numStrokes != strokes )
+						{
+							telemetry.count( TELEMETRY_SHOTS );
+							shotRolling = true;
+							shotTick = tick;
+						}
+					}
+
+					int bounces = dot.move( course, physicsStep );
+					if( bounces > 0 )
+					{
+						telemetry.count( TELEMETRY_WALL_BOUNCES, bounces );
+					}
+					accumulator -= physicsStep;
+					++tick;
+
+					//A shot has settled once the ball stops or drops in
+					if( shotRolling && ( dot.isAtRest() || dot.touchingHole ) )
+					{
+						telemetry.observe( TELEMETRY_SETTLE_TIME, (uint64_t)( tick - shotTick ) * 1000 / tickRate );
+						shotRolling = false;
+					}
 				}
+				profiler.endPhase( PHASE_PHYSICS );
 
-				//Render dot
-				dot.render();
+				//The drag preview follows the mouse as of now rather than the frame's events
+				int mouseX = 0, mouseY = 0;
+				SDL_PumpEvents();
+				SDL_GetMouseState( &mouseX, &mouseY );
+				dot.setAim( mouseX, mouseY );
 
-				//Update screen
-				SDL_RenderPresent( gRenderer );
+				//Ask for the path of the shot being lined up, the last one finished is shown meanwhile
+				if( dot.isAiming() )
+				{
+					float aimVelX, aimVelY;
+					dot.getAimVelocity( aimVelX, aimVelY );
+					predictor.request( dot.getState(), aimVelX, aimVelY );
+				}
+				else
+				{
+					predictor.cancel();
+				}
+				const PredictedPath* path = predictor.getPath();
+				dot.setPath( dot.isAiming() ? path : NULL );
+
+				//Draw the dot between the last two steps
+				dot.interpolate( accumulator / physicsStep );
+				dot.setCamera( camera, course.getTiles() );
+
+				if( lowPower )
+				{
+					//Repaint where the dot was and where it is now, or everything once the view scrolls
+					SDL_Rect newBox = dot.getBox( camera );
+					if( camera.x != oldCamera.x || camera.y != oldCamera.y )
+					{
+						gDirtyRegions.invalidate();
+					}
+					else if( newBox.x != oldBox.x || newBox.y != oldBox.y )
+					{
+						gDirtyRegions.add( oldBox );
+						gDirtyRegions.add( newBox );
+					}
+
+					//The drag preview is repainted where it was and where it is now, also when a new path fits the same box
+					SDL_Rect newAim = dot.getAimBox( camera );
+					uint32_t newPath = path != NULL && dot.isAiming() ? path->request : 0;
+					if( newAim.x != oldAim.x || newAim.y != oldAim.y || newAim.w != oldAim.w || newAim.h != oldAim.h || newPath != shownPath )
+					{
+						shownPath = newPath;
+						gDirtyRegions.add( oldAim );
+						gDirtyRegions.add( newAim );
+					}
+
+					//Present only if something changed, the overlay would keep the screen dirty so it stays off
+					ProfileScope render( profiler, PHASE_RENDER );
+					gDirtyRegions.present( course.getTiles(), dot, camera );
+				}
+				else
+				{
+					profiler.beginPhase( PHASE_RENDER );
+
+					//Clear screen
+					SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xFF, 0xFF, 0xFF );
+					SDL_RenderClear( gRenderer );
+
+					//Render level
+					gTileLayer.render( course.getTiles(), camera );
+
+					//Render dot and the shot being dragged
+					dot.render( camera );
+					gSprites.flush( gRenderer );
+					dot.renderAim( camera );
+
+					//Render frame timings
+					if( showProfile )
+					{
+						profiler.renderOverlay( gRenderer, 0, 0 );
+					}
+					profiler.endPhase( PHASE_RENDER );
+
+					//Update screen
+					ProfileScope present( profiler, PHASE_PRESENT );
+					SDL_RenderPresent( gRenderer );
+				}
 
 				if (dot.touchingHole == true)
 				{
-					win = true;
+					telemetry.count( TELEMETRY_HOLES );
+					telemetry.observe( TELEMETRY_HOLE_STROKES, dot.numStrokes );
+
+					//Save the hole so it can be checked with --replay
+					if( recordPath != NULL )
+					{
+						saveReplay( replay, recordPath, session, tick, dot );
+					}
+
+					//Tee off on the next hole in the same window, the round is won after the last
+					predictor.stop();
+					if( session.nextHole( course, dot.numStrokes ) )
+					{
+						predictor.start( course );
+						tee = makeTeeBall( course );
+						dot = Dot( tee.posX, tee.posY );
+						dot.setCamera( camera, course.getTiles() );
+						input.clear();
+						if( watcher.isWatching() )
+						{
+							watcher.watch( session.getMapPath() );
+						}
+						replay.begin( session.getMapPath(), tickRate, course.getCollisionMode() );
+						tick = 0;
+						accumulator = 0;
+						lastCounter = SDL_GetPerformanceCounter();
+						holeAllocations = getAllocationCount();
+					}
+					else
+					{
+						win = session.isOver();
+						quit = !win;
+					}
 				}
+
+				profiler.endFrame();
+
+				//Frames within a hole must not touch the heap, allocator jitter shows up in the frame times
+				assert( dot.touchingHole || getAllocationCount() == holeAllocations );
+			}
+
+			//Report where the frame time went
+			if( profilePath != NULL )
+			{
+				profiler.printSummary();
+				profiler.closeDump();
+			}
+
+			//Save the unfinished hole so it can be checked with --replay
+			if( recordPath != NULL && !dot.touchingHole )
+			{
+				saveReplay( replay, recordPath, session, tick, dot );
 			}
 
 			while (!quit and win) {
 				 std::cout << "U WON!" << std::endl;
-				 std::cout << "Strokes: " << dot.numStrokes << std::endl;
+				 std::cout << "Strokes: " << session.getScorecard().getTotalStrokes() << std::endl;
+				 session.getScorecard().print();
 				 quit = true;
 			}
 		}
 
 		//Free resources and close SDL
-		close( tileSet );
+		close();
 	}
 
 	return 0;
@@ -0,0 +1,124 @@
+//Read only memory mapped files
+#include "mappedfile.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	//Initialize
+	mData = NULL;
+	mSize = 0;
+
+	#ifdef _WIN32
+	mMapping = NULL;
+	#endif
+}
+
+MappedFile::~MappedFile()
+{
+	//Deallocate
+	close();
+}
+
+bool MappedFile::open( const std::string& path )
+{
+	//Get rid of preexisting mapping
+	close();
+
+	#ifdef _WIN32
+	HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( file == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if( GetFileSizeEx( file, &size ) && size.QuadPart > 0 )
+	{
+		mMapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+		if( mMapping != NULL )
+		{
+			mData = (const uint8_t*)MapViewOfFile( mMapping, FILE_MAP_READ, 0, 0, 0 );
+			if( mData == NULL )
+			{
+				CloseHandle( mMapping );
+				mMapping = NULL;
+			}
+			else
+			{
+				mSize = (size_t)size.QuadPart;
+			}
+		}
+	}
+
+	//The mapping keeps the file open
+	CloseHandle( file );
+	#else
+	int file = ::open( path.c_str(), O_RDONLY );
+	if( file < 0 )
+	{
+		return false;
+	}
+
+	struct stat info;
+	if( fstat( file, &info ) == 0 && info.st_size > 0 )
+	{
+		void* data = mmap( NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+		if( data != MAP_FAILED )
+		{
+			mData = (const uint8_t*)data;
+			mSize = info.st_size;
+		}
+	}
+
+	//The mapping keeps the file open
+	::close( file );
+	#endif
+
+	return mData != NULL;
+}
+
+void MappedFile::close()
+{
+	//Unmap the view if it exists
+	if( mData != NULL )
+	{
+		#ifdef _WIN32
+		UnmapViewOfFile( mData );
+		CloseHandle( mMapping );
+		mMapping = NULL;
+		#else
+		munmap( (void*)mData, mSize );
+		#endif
+
+		mData = NULL;
+		mSize = 0;
+	}
+}
+
+void MappedFile::swap( MappedFile& other )
+{
+	std::swap( mData, other.mData );
+	std::swap( mSize, other.mSize );
+	#ifdef _WIN32
+	std::swap( mMapping, other.mMapping );
+	#endif
+}
+
+const uint8_t* MappedFile::getData() const
+{
+	return mData;
+}
+
+size_t MappedFile::getSize() const
+{
+	return mSize;
+}
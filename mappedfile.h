@@ -0,0 +1,47 @@
+//Read only memory mapped files
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+//A whole file mapped into memory
+class MappedFile
+{
+	public:
+		//Initializes variables
+		MappedFile();
+
+		//Unmaps the file
+		~MappedFile();
+
+		//Maps file at specified path
+		bool open( const std::string& path );
+
+		//Unmaps the file
+		void close();
+
+		//Exchanges mappings with another file
+		void swap( MappedFile& other );
+
+		//Gets the mapped bytes
+		const uint8_t* getData() const;
+		size_t getSize() const;
+
+	private:
+		//Mapped files can't be copied
+		MappedFile( const MappedFile& );
+		MappedFile& operator=( const MappedFile& );
+
+		//The mapped view
+		const uint8_t* mData;
+		size_t mSize;
+
+		#ifdef _WIN32
+		//The file mapping object
+		void* mMapping;
+		#endif
+};
+
+#endif
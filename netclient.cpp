@@ -0,0 +1,389 @@
+//Playing a hosted match with local prediction
+#include "netclient.h"
+#include <stdio.h>
+#include <cmath>
+
+//Longest stretch of time the prediction catches up on after a stall
+const double NET_MAX_CATCH_UP = 0.25;
+
+NetClient::NetClient()
+{
+	//Initialize
+	mServer.host = 0;
+	mServer.port = 0;
+	mConnected = false;
+	mMatch = 0;
+	mPlayer = 0;
+	mCollisionMode = COLLISION_SWEPT;
+	mTick = 0;
+	mRoundTrip = 0;
+	mMeasured = false;
+	mSnapshotAck = 0;
+	mNextStroke = 1;
+	mStroke = makeStrokeInput();
+	mAccumulator = 0;
+	mTime = 0;
+	mLastSent = 0;
+	mLastHeard = 0;
+	mPacket.reserve( NET_MAX_PACKET );
+	mPending.reserve( NET_MAX_PENDING_STROKES );
+	mSnapshot.reserve( NET_MAX_PLAYERS );
+	mBalls.reserve( NET_MAX_PLAYERS );
+}
+
+NetClient::~NetClient()
+{
+	//Deallocate
+	disconnect();
+}
+
+bool NetClient::connect( const std::string& serverAddress, uint32_t match )
+{
+	disconnect();
+	if( !resolveAddress( serverAddress, mServer ) || !mSocket.open() )
+	{
+		return false;
+	}
+
+	mMatch = match;
+	mTime = 0;
+	mLastHeard = 0;
+
+	//Keeps asking until accepted, see update
+	beginPacket( mPacket, NET_CONNECT );
+	writeConnect( mPacket, mMatch );
+	mSocket.send( mServer, &mPacket[ 0 ], mPacket.size() );
+	mLastSent = mTime;
+	return true;
+}
+
+void NetClient::disconnect()
+{
+	if( mSocket.isOpen() && mConnected )
+	{
+		beginPacket( mPacket, NET_DISCONNECT );
+		mSocket.send( mServer, &mPacket[ 0 ], mPacket.size() );
+	}
+	mSocket.close();
+
+	mConnected = false;
+	mBalls.clear();
+	mSnapshot.clear();
+	mHistory.clear();
+	mSnapshotAck = 0;
+	mPending.clear();
+	mNextStroke = 1;
+	mAccumulator = 0;
+	mRoundTrip = 0;
+	mMeasured = false;
+}
+
+bool NetClient::isConnected() const
+{
+	return mConnected;
+}
+
+bool NetClient::isOpen() const
+{
+	return mSocket.isOpen();
+}
+
+int NetClient::getPlayer() const
+{
+	return mPlayer;
+}
+
+const std::string& NetClient::getCourseName() const
+{
+	return mCourseName;
+}
+
+CollisionMode NetClient::getCollisionMode() const
+{
+	return mCollisionMode;
+}
+
+void NetClient::update( double seconds, const Course* course )
+{
+	mTime += seconds;
+
+	//Handle every waiting packet
+	NetAddress address;
+	int size;
+	while( mSocket.isOpen() && ( size = mSocket.receive( address, mBuffer, sizeof( mBuffer ) ) ) > 0 )
+	{
+		if( isSameAddress( address, mServer ) )
+		{
+			handlePacket( mBuffer, size, course );
+		}
+	}
+
+	if( !mSocket.isOpen() )
+	{
+		return;
+	}
+
+	//Give up on a server that went quiet
+	if( mTime - mLastHeard > NET_TIMEOUT )
+	{
+		printf( mConnected ? "Lost connection to the server!\n" : "The server didn't answer!\n" );
+		disconnect();
+		return;
+	}
+
+	//Connects can be lost too
+	if( !mConnected )
+	{
+		if( mTime - mLastSent >= NET_CONNECT_RETRY )
+		{
+			beginPacket( mPacket, NET_CONNECT );
+			writeConnect( mPacket, mMatch );
+			mSocket.send( mServer, &mPacket[ 0 ], mPacket.size() );
+			mLastSent = mTime;
+		}
+		return;
+	}
+
+	//Predict the balls at the server's rate
+	if( course != NULL )
+	{
+		mAccumulator += seconds < NET_MAX_CATCH_UP ? seconds : NET_MAX_CATCH_UP;
+		while( mAccumulator >= PHYSICS_TIMESTEP )
+		{
+			stepBalls( *course );
+			mAccumulator -= PHYSICS_TIMESTEP;
+			++mTick;
+		}
+	}
+
+	//Ack snapshots as often as they come
+	if( mTime - mLastSent >= NET_SNAPSHOT_INTERVAL * PHYSICS_TIMESTEP )
+	{
+		sendInput();
+	}
+}
+
+bool NetClient::handleMouseButton( bool down, int x, int y )
+{
+	if( !mConnected || mPlayer >= (int)mBalls.size() || mBalls[ mPlayer ].touchingHole )
+	{
+		return false;
+	}
+
+	//Strokes wait for acks, don't play more than can be resent
+	if( !down && (int)mPending.size() >= NET_MAX_PENDING_STROKES )
+	{
+		return false;
+	}
+
+	//Predict the stroke straight away and tell the server which tick it was played on
+	NetStroke stroke = { mNextStroke, mTick, mStroke.downX - x, mStroke.downY - y };
+	if( !applyMouseButton( mBalls[ mPlayer ], mStroke, down, x, y ) )
+	{
+		return false;
+	}
+
+	mPending.push_back( stroke );
+	++mNextStroke;
+	sendInput();
+	return true;
+}
+
+const std::vector<BallState>& NetClient::getBalls() const
+{
+	return mBalls;
+}
+
+bool NetClient::isPresent( int ball ) const
+{
+	return ball < (int)mSnapshot.size() && ( mSnapshot[ ball ].flags & NET_BALL_PRESENT );
+}
+
+const BallState& NetClient::getBall() const
+{
+	static const BallState none = makeBall( 0, 0 );
+	return mPlayer < (int)mBalls.size() ? mBalls[ mPlayer ] : none;
+}
+
+uint32_t NetClient::getTick() const
+{
+	return mTick;
+}
+
+double NetClient::getRoundTrip() const
+{
+	return mRoundTrip;
+}
+
+void NetClient::handlePacket( const uint8_t* data, int size, const Course* course )
+{
+	const uint8_t* cursor = data;
+	const uint8_t* end = data + size;
+	NetPacketType type;
+	if( !readPacketType( cursor, end, type ) )
+	{
+		return;
+	}
+
+	if( type == NET_ACCEPT && !mConnected )
+	{
+		uint32_t match;
+		if( readAccept( cursor, end, match, mPlayer, mTick, mCollisionMode, mCourseName ) && match == mMatch )
+		{
+			mConnected = true;
+			mLastHeard = mTime;
+		}
+	}
+	else if( type == NET_REJECT && !mConnected )
+	{
+		printf( "Match %u is full!\n", mMatch );
+		disconnect();
+	}
+	else if( type == NET_SNAPSHOT && mConnected )
+	{
+		//Snapshots can arrive late or out of order, only newer ones count
+		NetSnapshotInfo info;
+		if( !readSnapshotInfo( cursor, end, info ) || info.tick <= mSnapshotAck )
+		{
+			return;
+		}
+
+		//A delta is only usable if we still have what it was coded against
+		const std::vector<NetBall>* baseline = mHistory.find( info.baselineTick );
+		if( ( info.baselineTick != 0 && baseline == NULL ) || !readSnapshotBalls( cursor, end, baseline, mSnapshot ) )
+		{
+			return;
+		}
+
+		mHistory.store( info.tick, mSnapshot );
+		mSnapshotAck = info.tick;
+		mLastHeard = mTime;
+		reconcile( info, course );
+	}
+	else if( type == NET_DISCONNECT && mConnected )
+	{
+		printf( "The server closed the match!\n" );
+		disconnect();
+	}
+}
+
+void NetClient::reconcile( const NetSnapshotInfo& info, const Course* course )
+{
+	//Take the server's word for where the balls were
+	mBalls.resize( mSnapshot.size() );
+	for( size_t i = 0; i < mSnapshot.size(); ++i )
+	{
+		mBalls[ i ] = dequantizeBall( mSnapshot[ i ] );
+	}
+
+	//Forget strokes the server has played
+	size_t kept = 0;
+	for( size_t i = 0; i < mPending.size(); ++i )
+	{
+		if( mPending[ i ].sequence > info.strokeAck )
+		{
+			mPending[ kept++ ] = mPending[ i ];
+		}
+	}
+	mPending.resize( kept );
+
+	adjustLead( info );
+	if( course == NULL )
+	{
+		return;
+	}
+
+	int ticks = mTick - info.tick;
+	if( ticks > NET_MAX_RESIMULATE )
+	{
+		ticks = NET_MAX_RESIMULATE;
+		mTick = info.tick + ticks;
+	}
+
+	//Simulate forward to where the prediction was, playing each stroke the server hasn't on the tick it was played on
+	//Strokes from before the snapshot haven't reached the server yet, so they're played as soon as it could
+	size_t next = 0;
+	for( int tick = 0; ; ++tick )
+	{
+		for( ; next < mPending.size() && (int32_t)( mPending[ next ].tick - info.tick ) <= tick; ++next )
+		{
+			replayStroke( mPending[ next ] );
+		}
+
+		if( tick >= ticks )
+		{
+			break;
+		}
+		stepBalls( *course );
+	}
+
+	//Anything past a cut short resimulation is played on the last tick
+	for( ; next < mPending.size(); ++next )
+	{
+		replayStroke( mPending[ next ] );
+	}
+}
+
+void NetClient::adjustLead( const NetSnapshotInfo& info )
+{
+	//The echoed time came back after a round trip and however long the server held it
+	if( info.echoTime != 0 )
+	{
+		double sample = mTime - info.echoTime / 1000.0 - info.echoHold / 1000.0;
+		if( sample >= 0 )
+		{
+			mRoundTrip = mMeasured ? mRoundTrip + ( sample - mRoundTrip ) * NET_ROUND_TRIP_SMOOTHING : sample;
+			mMeasured = true;
+		}
+	}
+
+	//A stroke played now reaches the server a round trip after this snapshot left it, plus a margin for jitter
+	uint32_t target = info.tick + (uint32_t)ceil( mRoundTrip / PHYSICS_TIMESTEP ) + NET_INPUT_MARGIN;
+	int error = target - mTick;
+	if( error > NET_TICK_SLACK )
+	{
+		//Catching up is done in one go, the resimulation covers the skipped ticks
+		mTick = target;
+	}
+	else if( error < -NET_TICK_SLACK )
+	{
+		//Slowing down is done a tick per snapshot so the prediction never goes back
+		mAccumulator -= PHYSICS_TIMESTEP;
+	}
+}
+
+void NetClient::replayStroke( const NetStroke& stroke )
+{
+	if( mPlayer < (int)mBalls.size() && !mBalls[ mPlayer ].touchingHole )
+	{
+		StrokeInput input = { stroke.dragX, stroke.dragY };
+		applyMouseButton( mBalls[ mPlayer ], input, false, 0, 0 );
+	}
+}
+
+void NetClient::stepBalls( const Course& course )
+{
+	//Every ball moves before any of them bounce off each other
+	mBroadphase.clear();
+	for( size_t i = 0; i < mBalls.size(); ++i )
+	{
+		if( isPresent( i ) )
+		{
+			stepNetBall( mBalls[ i ], course );
+			if( !mBalls[ i ].touchingHole )
+			{
+				mBroadphase.insert( i, getCollider( mBalls[ i ] ) );
+			}
+		}
+	}
+	mBroadphase.findPairs( mPairs );
+	collideBalls( mBalls, mPairs );
+}
+
+void NetClient::sendInput()
+{
+	beginPacket( mPacket, NET_INPUT );
+	writeInput( mPacket, mSnapshotAck, (uint32_t)( mTime * 1000 ), mPending.empty() ? NULL : &mPending[ 0 ], mPending.size() );
+	mSocket.send( mServer, &mPacket[ 0 ], mPacket.size() );
+	mLastSent = mTime;
+}
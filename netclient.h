@@ -0,0 +1,123 @@
+//Playing a hosted match with local prediction, usable without SDL
+#ifndef NETCLIENT_H
+#define NETCLIENT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "netcode.h"
+#include "netsocket.h"
+#include "broadphase.h"
+
+//Sends strokes to a match server and predicts the balls between its snapshots
+class NetClient
+{
+	public:
+		//Initializes variables
+		NetClient();
+
+		//Leaves the match
+		~NetClient();
+
+		//Starts joining a match, the server answers during update
+		bool connect( const std::string& serverAddress, uint32_t match );
+
+		//Leaves the match
+		void disconnect();
+
+		//Checks if the server accepted us, and if the connection is still alive
+		bool isConnected() const;
+		bool isOpen() const;
+
+		//Gets what the server said when it accepted us, the course by name so it's looked up in a local directory
+		int getPlayer() const;
+		const std::string& getCourseName() const;
+		CollisionMode getCollisionMode() const;
+
+		//Handles packets, then steps the predicted balls for the elapsed time once the course is loaded
+		void update( double seconds, const Course* course );
+
+		//Feeds a mouse press or release to our ball, true if a stroke was played
+		bool handleMouseButton( bool down, int x, int y );
+
+		//Gets every ball in the match and whether a player holds it
+		const std::vector<BallState>& getBalls() const;
+		bool isPresent( int ball ) const;
+
+		//Gets our ball
+		const BallState& getBall() const;
+
+		//Gets the tick the prediction is at
+		uint32_t getTick() const;
+
+		//Gets the measured round trip to the server in seconds
+		double getRoundTrip() const;
+
+	private:
+		//Clients can't be copied since they own the socket
+		NetClient( const NetClient& );
+		NetClient& operator=( const NetClient& );
+
+		//Handles one packet from the server
+		void handlePacket( const uint8_t* data, int size, const Course* course );
+
+		//Resets the balls to a snapshot and simulates back up to the predicted tick, replaying strokes on their ticks
+		void reconcile( const NetSnapshotInfo& info, const Course* course );
+
+		//Measures the round trip from a snapshot's echo and keeps the prediction that far ahead of the server
+		void adjustLead( const NetSnapshotInfo& info );
+
+		//Plays a stroke on our ball again
+		void replayStroke( const NetStroke& stroke );
+
+		//Sends unacked strokes and the snapshot ack
+		void sendInput();
+
+		//Moves the balls in play one tick and bounces them off each other like the server does
+		void stepBalls( const Course& course );
+
+		//The socket and the server it talks to
+		UdpSocket mSocket;
+		NetAddress mServer;
+		bool mConnected;
+
+		//What we asked for and were given
+		uint32_t mMatch;
+		int mPlayer;
+		std::string mCourseName;
+		CollisionMode mCollisionMode;
+
+		//The predicted balls, ahead of the server so strokes reach it before their tick
+		std::vector<BallState> mBalls;
+		std::vector<NetBall> mSnapshot;
+		uint32_t mTick;
+
+		//The smoothed round trip in seconds, and whether it's been measured yet
+		double mRoundTrip;
+		bool mMeasured;
+
+		//Snapshots received, to decode deltas against
+		SnapshotHistory mHistory;
+		uint32_t mSnapshotAck;
+
+		//Strokes sent but not yet acked, replayed on top of every correction
+		std::vector<NetStroke> mPending;
+		uint32_t mNextStroke;
+		StrokeInput mStroke;
+
+		//Clocks for the physics, resends and the timeout
+		double mAccumulator;
+		double mTime;
+		double mLastSent;
+		double mLastHeard;
+
+		//Scratch reused for every tick's contacts
+		Broadphase mBroadphase;
+		std::vector<BodyPair> mPairs;
+
+		//Scratch reused for every packet
+		std::vector<uint8_t> mPacket;
+		uint8_t mBuffer[ NET_MAX_PACKET ];
+};
+
+#endif
@@ -0,0 +1,358 @@
+//The wire protocol shared by match servers and clients
+#include "netcode.h"
+#include <string.h>
+#include <cmath>
+
+//Bits marking which parts of a ball changed from its baseline
+const uint8_t DELTA_POS_X = 1;
+const uint8_t DELTA_POS_Y = 2;
+const uint8_t DELTA_VEL_X = 4;
+const uint8_t DELTA_VEL_Y = 8;
+const uint8_t DELTA_FLAGS = 16;
+
+//Appends a variable length unsigned value, seven bits per byte
+static void writeVarint( std::vector<uint8_t>& bytes, uint32_t value )
+{
+	while( value >= 0x80 )
+	{
+		bytes.push_back( ( value & 0x7F ) | 0x80 );
+		value >>= 7;
+	}
+	bytes.push_back( value );
+}
+
+//Reads a variable length unsigned value, false if it runs off the end
+static bool readVarint( const uint8_t*& cursor, const uint8_t* end, uint32_t& value )
+{
+	value = 0;
+	for( int shift = 0; shift < 35 && cursor < end; shift += 7 )
+	{
+		uint8_t byte = *cursor++;
+		value |= (uint32_t)( byte & 0x7F ) << shift;
+		if( !( byte & 0x80 ) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//Maps signed values onto small unsigned values
+static uint32_t zigzag( int32_t value )
+{
+	return ( (uint32_t)value << 1 ) ^ (uint32_t)( value >> 31 );
+}
+
+static int32_t unzigzag( uint32_t value )
+{
+	return (int32_t)( value >> 1 ) ^ -(int32_t)( value & 1 );
+}
+
+//Appends the change from a baseline value, wrapping so any pair of values round trips
+static void writeDelta( std::vector<uint8_t>& bytes, int32_t value, int32_t base )
+{
+	writeVarint( bytes, zigzag( (int32_t)( (uint32_t)value - (uint32_t)base ) ) );
+}
+
+static bool readDelta( const uint8_t*& cursor, const uint8_t* end, int32_t base, int32_t& value )
+{
+	uint32_t delta;
+	if( !readVarint( cursor, end, delta ) )
+	{
+		return false;
+	}
+
+	value = (int32_t)( (uint32_t)base + (uint32_t)unzigzag( delta ) );
+	return true;
+}
+
+//Rounds a value onto the fixed point grid
+static int32_t quantize( float value, float scale )
+{
+	return (int32_t)floor( value * scale + 0.5f );
+}
+
+NetBall quantizeBall( const BallState& ball, bool present )
+{
+	NetBall quantized;
+	quantized.posX = quantize( ball.posX, NET_POSITION_SCALE );
+	quantized.posY = quantize( ball.posY, NET_POSITION_SCALE );
+	quantized.velX = quantize( ball.velX, NET_VELOCITY_SCALE );
+	quantized.velY = quantize( ball.velY, NET_VELOCITY_SCALE );
+	quantized.flags = ( present ? NET_BALL_PRESENT : 0 ) | ( ball.touchingHole ? NET_BALL_HOLED : 0 );
+	return quantized;
+}
+
+BallState dequantizeBall( const NetBall& ball )
+{
+	BallState state;
+	state.posX = ball.posX / NET_POSITION_SCALE;
+	state.posY = ball.posY / NET_POSITION_SCALE;
+	state.velX = ball.velX / NET_VELOCITY_SCALE;
+	state.velY = ball.velY / NET_VELOCITY_SCALE;
+	state.touchingHole = ( ball.flags & NET_BALL_HOLED ) != 0;
+	return state;
+}
+
+void stepNetBall( BallState& ball, const Course& course )
+{
+	if( !ball.touchingHole && !isAtRest( ball ) )
+	{
+		step( ball, course );
+	}
+}
+
+std::string getCourseName( const std::string& mapPath )
+{
+	size_t slash = mapPath.find_last_of( "/\\" );
+	return slash == std::string::npos ? mapPath : mapPath.substr( slash + 1 );
+}
+
+bool isCourseName( const std::string& name )
+{
+	//Anything that could climb out of the course directory or name a drive is refused
+	if( name.empty() || name.size() > (size_t)NET_MAX_COURSE_NAME || name == "." || name == ".." )
+	{
+		return false;
+	}
+
+	for( size_t i = 0; i < name.size(); ++i )
+	{
+		if( name[ i ] == '/' || name[ i ] == '\\' || name[ i ] == ':' || (unsigned char)name[ i ] < ' ' )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void beginPacket( std::vector<uint8_t>& packet, NetPacketType type )
+{
+	packet.assign( NET_MAGIC, NET_MAGIC + sizeof( NET_MAGIC ) );
+	packet.push_back( NET_VERSION );
+	packet.push_back( type );
+}
+
+void writeConnect( std::vector<uint8_t>& packet, uint32_t match )
+{
+	writeVarint( packet, match );
+}
+
+void writeAccept( std::vector<uint8_t>& packet, uint32_t match, int player, uint32_t tick, CollisionMode mode, const std::string& courseName )
+{
+	writeVarint( packet, match );
+	writeVarint( packet, player );
+	writeVarint( packet, tick );
+	packet.push_back( mode );
+	writeVarint( packet, courseName.size() );
+	packet.insert( packet.end(), courseName.begin(), courseName.end() );
+}
+
+void writeInput( std::vector<uint8_t>& packet, uint32_t snapshotAck, uint32_t sentTime, const NetStroke* strokes, int count )
+{
+	//Every unacked stroke rides along so a lost packet doesn't lose one
+	writeVarint( packet, snapshotAck );
+	writeVarint( packet, sentTime );
+	writeVarint( packet, count );
+	for( int i = 0; i < count; ++i )
+	{
+		writeVarint( packet, strokes[ i ].sequence );
+		writeVarint( packet, strokes[ i ].tick );
+		writeVarint( packet, zigzag( strokes[ i ].dragX ) );
+		writeVarint( packet, zigzag( strokes[ i ].dragY ) );
+	}
+}
+
+void writeSnapshot( std::vector<uint8_t>& packet, const NetSnapshotInfo& info, const std::vector<NetBall>& balls, const std::vector<NetBall>* baseline )
+{
+	writeVarint( packet, info.tick );
+	writeVarint( packet, baseline != NULL ? info.baselineTick : 0 );
+	writeVarint( packet, info.strokeAck );
+	writeVarint( packet, info.echoTime );
+	writeVarint( packet, info.echoHold );
+	writeVarint( packet, balls.size() );
+
+	//Only what changed since the baseline is sent, balls it didn't have start from zero
+	static const NetBall empty = { 0, 0, 0, 0, 0 };
+	for( size_t i = 0; i < balls.size(); ++i )
+	{
+		const NetBall& ball = balls[ i ];
+		const NetBall& base = baseline != NULL && i < baseline->size() ? ( *baseline )[ i ] : empty;
+
+		uint8_t changes = ( ball.posX != base.posX ? DELTA_POS_X : 0 ) | ( ball.posY != base.posY ? DELTA_POS_Y : 0 ) |
+			( ball.velX != base.velX ? DELTA_VEL_X : 0 ) | ( ball.velY != base.velY ? DELTA_VEL_Y : 0 ) |
+			( ball.flags != base.flags ? DELTA_FLAGS : 0 );
+		packet.push_back( changes );
+
+		if( changes & DELTA_POS_X ) writeDelta( packet, ball.posX, base.posX );
+		if( changes & DELTA_POS_Y ) writeDelta( packet, ball.posY, base.posY );
+		if( changes & DELTA_VEL_X ) writeDelta( packet, ball.velX, base.velX );
+		if( changes & DELTA_VEL_Y ) writeDelta( packet, ball.velY, base.velY );
+		if( changes & DELTA_FLAGS ) packet.push_back( ball.flags );
+	}
+}
+
+bool readPacketType( const uint8_t*& cursor, const uint8_t* end, NetPacketType& type )
+{
+	if( end - cursor < (long)sizeof( NET_MAGIC ) + 2 || memcmp( cursor, NET_MAGIC, sizeof( NET_MAGIC ) ) != 0 ||
+		cursor[ sizeof( NET_MAGIC ) ] != NET_VERSION || cursor[ sizeof( NET_MAGIC ) + 1 ] >= TOTAL_NET_PACKET_TYPES )
+	{
+		return false;
+	}
+
+	type = (NetPacketType)cursor[ sizeof( NET_MAGIC ) + 1 ];
+	cursor += sizeof( NET_MAGIC ) + 2;
+	return true;
+}
+
+bool readConnect( const uint8_t*& cursor, const uint8_t* end, uint32_t& match )
+{
+	return readVarint( cursor, end, match );
+}
+
+bool readAccept( const uint8_t*& cursor, const uint8_t* end, uint32_t& match, int& player, uint32_t& tick, CollisionMode& mode, std::string& courseName )
+{
+	uint32_t playerIndex, nameLength;
+	if( !readVarint( cursor, end, match ) || !readVarint( cursor, end, playerIndex ) || !readVarint( cursor, end, tick ) ||
+		cursor == end || *cursor > COLLISION_FIELD )
+	{
+		return false;
+	}
+	mode = (CollisionMode)*cursor++;
+
+	if( !readVarint( cursor, end, nameLength ) || (uint32_t)( end - cursor ) < nameLength || nameLength > (uint32_t)NET_MAX_COURSE_NAME || playerIndex >= (uint32_t)NET_MAX_PLAYERS )
+	{
+		return false;
+	}
+
+	//The name is only a name, the client picks the directory
+	std::string name( (const char*)cursor, nameLength );
+	if( !isCourseName( name ) )
+	{
+		return false;
+	}
+
+	player = playerIndex;
+	courseName = name;
+	cursor += nameLength;
+	return true;
+}
+
+bool readInput( const uint8_t*& cursor, const uint8_t* end, uint32_t& snapshotAck, uint32_t& sentTime, std::vector<NetStroke>& strokes )
+{
+	uint32_t count;
+	if( !readVarint( cursor, end, snapshotAck ) || !readVarint( cursor, end, sentTime ) || !readVarint( cursor, end, count ) || count > (uint32_t)NET_MAX_PENDING_STROKES )
+	{
+		return false;
+	}
+
+	strokes.clear();
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		NetStroke stroke;
+		uint32_t dragX, dragY;
+		if( !readVarint( cursor, end, stroke.sequence ) || !readVarint( cursor, end, stroke.tick ) || !readVarint( cursor, end, dragX ) || !readVarint( cursor, end, dragY ) )
+		{
+			return false;
+		}
+
+		stroke.dragX = unzigzag( dragX );
+		stroke.dragY = unzigzag( dragY );
+		strokes.push_back( stroke );
+	}
+
+	return true;
+}
+
+bool readSnapshotInfo( const uint8_t*& cursor, const uint8_t* end, NetSnapshotInfo& info )
+{
+	return readVarint( cursor, end, info.tick ) && readVarint( cursor, end, info.baselineTick ) && readVarint( cursor, end, info.strokeAck ) &&
+		readVarint( cursor, end, info.echoTime ) && readVarint( cursor, end, info.echoHold );
+}
+
+bool readSnapshotBalls( const uint8_t*& cursor, const uint8_t* end, const std::vector<NetBall>* baseline, std::vector<NetBall>& balls )
+{
+	uint32_t count;
+	if( !readVarint( cursor, end, count ) || count > (uint32_t)NET_MAX_PLAYERS )
+	{
+		return false;
+	}
+
+	static const NetBall empty = { 0, 0, 0, 0, 0 };
+	balls.resize( count );
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		const NetBall& base = baseline != NULL && i < baseline->size() ? ( *baseline )[ i ] : empty;
+		NetBall& ball = balls[ i ];
+		ball = base;
+
+		if( cursor == end )
+		{
+			return false;
+		}
+		uint8_t changes = *cursor++;
+
+		if( ( ( changes & DELTA_POS_X ) && !readDelta( cursor, end, base.posX, ball.posX ) ) ||
+			( ( changes & DELTA_POS_Y ) && !readDelta( cursor, end, base.posY, ball.posY ) ) ||
+			( ( changes & DELTA_VEL_X ) && !readDelta( cursor, end, base.velX, ball.velX ) ) ||
+			( ( changes & DELTA_VEL_Y ) && !readDelta( cursor, end, base.velY, ball.velY ) ) )
+		{
+			return false;
+		}
+
+		if( changes & DELTA_FLAGS )
+		{
+			if( cursor == end )
+			{
+				return false;
+			}
+			ball.flags = *cursor++;
+		}
+	}
+
+	return true;
+}
+
+SnapshotHistory::SnapshotHistory()
+{
+	//Initialize
+	clear();
+}
+
+void SnapshotHistory::clear()
+{
+	for( int i = 0; i < NET_SNAPSHOT_HISTORY; ++i )
+	{
+		mEntries[ i ].tick = 0;
+	}
+	mNext = 0;
+}
+
+void SnapshotHistory::store( uint32_t tick, const std::vector<NetBall>& balls )
+{
+	//Assigning over the oldest entry reuses its memory
+	Entry& entry = mEntries[ mNext ];
+	entry.tick = tick;
+	entry.balls.assign( balls.begin(), balls.end() );
+	mNext = ( mNext + 1 ) % NET_SNAPSHOT_HISTORY;
+}
+
+const std::vector<NetBall>* SnapshotHistory::find( uint32_t tick ) const
+{
+	if( tick == 0 )
+	{
+		return NULL;
+	}
+
+	for( int i = 0; i < NET_SNAPSHOT_HISTORY; ++i )
+	{
+		if( mEntries[ i ].tick == tick )
+		{
+			return &mEntries[ i ].balls;
+		}
+	}
+
+	return NULL;
+}
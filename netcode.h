@@ -0,0 +1,183 @@
+//The wire protocol shared by match servers and clients, usable without SDL
+#ifndef NETCODE_H
+#define NETCODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "physics.h"
+
+//Packet identification, a server and client only talk if both match
+const char NET_MAGIC[ 4 ] = { 'G', 'N', 'E', 'T' };
+const uint8_t NET_VERSION = 3;
+
+//Largest datagram sent, small enough to never be fragmented
+const int NET_MAX_PACKET = 1200;
+
+//Most balls sharing one match
+const int NET_MAX_PLAYERS = 16;
+
+//Physics ticks between snapshots, 30 a second at the stock tick rate
+const int NET_SNAPSHOT_INTERVAL = 8;
+
+//Snapshots kept on each side so deltas can be taken against an older acked one
+const int NET_SNAPSHOT_HISTORY = 32;
+
+//Fixed point steps balls are quantized to per pixel and per pixel per second
+const float NET_POSITION_SCALE = 256;
+const float NET_VELOCITY_SCALE = 256;
+
+//Longest drag accepted for a stroke on either axis
+const int NET_MAX_DRAG = 2048;
+
+//Strokes a client resends until the server acks them
+const int NET_MAX_PENDING_STROKES = 8;
+
+//Most ticks a client simulates again after a correction
+const int NET_MAX_RESIMULATE = PHYSICS_TICK_RATE;
+
+//Most ticks ahead of the server a stroke is held for, ones played further ahead wait at the edge
+const int NET_MAX_STROKE_LEAD = PHYSICS_TICK_RATE / 2;
+
+//Ticks a client runs ahead of the server beyond the round trip, so jitter doesn't make strokes late
+const int NET_INPUT_MARGIN = 4;
+
+//Ticks a client's lead may be off by before it's corrected
+const int NET_TICK_SLACK = 2;
+
+//How much each round trip sample moves the client's estimate
+const double NET_ROUND_TRIP_SMOOTHING = 0.1;
+
+//Longest course name a server sends
+const int NET_MAX_COURSE_NAME = 64;
+
+//Seconds of silence before the other side is given up on, and between connection attempts
+const double NET_TIMEOUT = 5;
+const double NET_CONNECT_RETRY = 0.5;
+
+//What a packet carries
+enum NetPacketType
+{
+	//Client asks to join a match
+	NET_CONNECT,
+
+	//Server tells a client its ball and course
+	NET_ACCEPT,
+
+	//Server turns a client away
+	NET_REJECT,
+
+	//Client sends strokes and acks snapshots
+	NET_INPUT,
+
+	//Server sends every ball in a match
+	NET_SNAPSHOT,
+
+	//Either side leaves
+	NET_DISCONNECT,
+
+	TOTAL_NET_PACKET_TYPES
+};
+
+//Ball flags sent with each quantized ball
+const uint8_t NET_BALL_PRESENT = 1;
+const uint8_t NET_BALL_HOLED = 2;
+
+//A ball in fixed point, the state both sides agree on at a snapshot
+struct NetBall
+{
+	int32_t posX, posY;
+	int32_t velX, velY;
+	uint8_t flags;
+};
+
+//A stroke as the drag it was played with and the tick it was played on, so the server applies exactly what the client did
+struct NetStroke
+{
+	uint32_t sequence;
+	uint32_t tick;
+	int dragX, dragY;
+};
+
+//A snapshot's header
+struct NetSnapshotInfo
+{
+	//The server tick the balls are at
+	uint32_t tick;
+
+	//The snapshot the balls are delta coded against, 0 for none
+	uint32_t baselineTick;
+
+	//The newest stroke of the receiving client the balls include
+	uint32_t strokeAck;
+
+	//The newest input time in milliseconds the client sent, and how long the server held it before this snapshot
+	uint32_t echoTime;
+	uint32_t echoHold;
+};
+
+//Quantizes a ball
+NetBall quantizeBall( const BallState& ball, bool present );
+
+//Rebuilds a ball from its quantized form
+BallState dequantizeBall( const NetBall& ball );
+
+//Steps a networked ball the same way on both sides, balls at rest or holed are left alone
+void stepNetBall( BallState& ball, const Course& course );
+
+//Gets the name a course is known by on the wire, its file name without any directories
+std::string getCourseName( const std::string& mapPath );
+
+//Checks a course name from the wire names a file in one directory and nothing outside it
+bool isCourseName( const std::string& name );
+
+//Starts a packet of a type
+void beginPacket( std::vector<uint8_t>& packet, NetPacketType type );
+
+//Appends packet bodies
+void writeConnect( std::vector<uint8_t>& packet, uint32_t match );
+void writeAccept( std::vector<uint8_t>& packet, uint32_t match, int player, uint32_t tick, CollisionMode mode, const std::string& courseName );
+void writeInput( std::vector<uint8_t>& packet, uint32_t snapshotAck, uint32_t sentTime, const NetStroke* strokes, int count );
+void writeSnapshot( std::vector<uint8_t>& packet, const NetSnapshotInfo& info, const std::vector<NetBall>& balls, const std::vector<NetBall>* baseline );
+
+//Checks a packet's header and gets its type, leaving the cursor at the body
+bool readPacketType( const uint8_t*& cursor, const uint8_t* end, NetPacketType& type );
+
+//Reads packet bodies, false if they're malformed
+bool readConnect( const uint8_t*& cursor, const uint8_t* end, uint32_t& match );
+bool readAccept( const uint8_t*& cursor, const uint8_t* end, uint32_t& match, int& player, uint32_t& tick, CollisionMode& mode, std::string& courseName );
+bool readInput( const uint8_t*& cursor, const uint8_t* end, uint32_t& snapshotAck, uint32_t& sentTime, std::vector<NetStroke>& strokes );
+bool readSnapshotInfo( const uint8_t*& cursor, const uint8_t* end, NetSnapshotInfo& info );
+bool readSnapshotBalls( const uint8_t*& cursor, const uint8_t* end, const std::vector<NetBall>* baseline, std::vector<NetBall>& balls );
+
+//The last few snapshots, kept to delta code against
+class SnapshotHistory
+{
+	public:
+		//Initializes variables
+		SnapshotHistory();
+
+		//Forgets every snapshot
+		void clear();
+
+		//Keeps a snapshot, replacing the oldest
+		void store( uint32_t tick, const std::vector<NetBall>& balls );
+
+		//Gets a kept snapshot, NULL if it's gone
+		const std::vector<NetBall>* find( uint32_t tick ) const;
+
+	private:
+		//A kept snapshot, tick 0 marks an empty slot
+		struct Entry
+		{
+			uint32_t tick;
+			std::vector<NetBall> balls;
+		};
+
+		//The snapshots as a ring
+		Entry mEntries[ NET_SNAPSHOT_HISTORY ];
+		int mNext;
+};
+
+#endif
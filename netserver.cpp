@@ -0,0 +1,463 @@
+//Authoritative match hosting over UDP
+#include "netserver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+//Longest stretch of time the physics catches up on after a stall
+const double NET_MAX_CATCH_UP = 0.25;
+
+NetServer::NetServer()
+{
+	//Initialize
+	mTick = 1;
+	mAccumulator = 0;
+	mTime = 0;
+	mPool = NULL;
+	mPacket.reserve( NET_MAX_PACKET );
+	mStrokes.reserve( NET_MAX_PENDING_STROKES );
+}
+
+NetServer::~NetServer()
+{
+	//Deallocate
+	close();
+}
+
+bool NetServer::open( uint16_t port, const std::vector<std::string>& mapPaths, CollisionMode mode, int threads )
+{
+	close();
+
+	//Each course is loaded once and only read from then on
+	for( size_t i = 0; i < mapPaths.size(); ++i )
+	{
+		Course* course = new Course;
+		if( !course->loadFromFile( mapPaths[ i ] ) )
+		{
+			printf( "Unable to host %s!\n", mapPaths[ i ].c_str() );
+			delete course;
+			close();
+			return false;
+		}
+		if( mode != COLLISION_SWEPT && !course->setCollisionMode( mode ) )
+		{
+			printf( "Failed to bake distance fields for %s, using swept collision!\n", mapPaths[ i ].c_str() );
+		}
+
+		//Players are only told the file name, they find the course in their own directory
+		mCourses.push_back( course );
+		mCourseNames.push_back( getCourseName( mapPaths[ i ] ) );
+	}
+	if( mCourses.empty() )
+	{
+		printf( "Unable to host without a course!\n" );
+		return false;
+	}
+
+	mPool = new ThreadPool( threads );
+	mBroadphases.resize( mPool->getThreadCount() );
+	mPairs.resize( mPool->getThreadCount() );
+	if( !mSocket.open( port ) )
+	{
+		close();
+		return false;
+	}
+	if( !mSocket.setBufferSize( NET_SERVER_SOCKET_BUFFER ) )
+	{
+		printf( "Unable to grow socket buffers, busy matches may drop packets!\n" );
+	}
+
+	return true;
+}
+
+void NetServer::close()
+{
+	//Let the players know rather than have them time out
+	beginPacket( mPacket, NET_DISCONNECT );
+	for( std::unordered_map<uint64_t, Peer>::iterator i = mPeers.begin(); i != mPeers.end(); ++i )
+	{
+		mSocket.send( i->second.address, &mPacket[ 0 ], mPacket.size() );
+	}
+
+	for( std::unordered_map<uint32_t, Match*>::iterator i = mMatches.begin(); i != mMatches.end(); ++i )
+	{
+		delete i->second;
+	}
+	mMatches.clear();
+	mMatchList.clear();
+	mPeers.clear();
+	mSocket.close();
+
+	for( size_t i = 0; i < mCourses.size(); ++i )
+	{
+		delete mCourses[ i ];
+	}
+	mCourses.clear();
+	mCourseNames.clear();
+
+	delete mPool;
+	mPool = NULL;
+}
+
+void NetServer::update( double seconds )
+{
+	mTime += seconds;
+	receive();
+
+	//Step every match at the fixed rate, running each batch up to the next snapshot in one go
+	mAccumulator += seconds < NET_MAX_CATCH_UP ? seconds : NET_MAX_CATCH_UP;
+	int due = (int)( mAccumulator / PHYSICS_TIMESTEP );
+	mAccumulator -= due * PHYSICS_TIMESTEP;
+	while( due > 0 )
+	{
+		int ticks = std::min( due, (int)( NET_SNAPSHOT_INTERVAL - mTick % NET_SNAPSHOT_INTERVAL ) );
+		stepMatches( ticks );
+		mTick += ticks;
+		due -= ticks;
+
+		if( mTick % NET_SNAPSHOT_INTERVAL == 0 )
+		{
+			sendSnapshots();
+		}
+	}
+
+	//Drop players that went quiet
+	for( std::unordered_map<uint64_t, Peer>::iterator i = mPeers.begin(); i != mPeers.end(); )
+	{
+		uint64_t key = i->first;
+		bool timedOut = mTime - i->second.lastHeard > NET_TIMEOUT;
+		++i;
+		if( timedOut )
+		{
+			leave( key );
+		}
+	}
+}
+
+uint32_t NetServer::getTick() const
+{
+	return mTick;
+}
+
+int NetServer::getMatchCount() const
+{
+	return mMatches.size();
+}
+
+int NetServer::getPlayerCount() const
+{
+	return mPeers.size();
+}
+
+void NetServer::receive()
+{
+	NetAddress address;
+	int size;
+	while( ( size = mSocket.receive( address, mBuffer, sizeof( mBuffer ) ) ) > 0 )
+	{
+		handlePacket( address, mBuffer, size );
+	}
+}
+
+void NetServer::handlePacket( const NetAddress& address, const uint8_t* data, int size )
+{
+	const uint8_t* cursor = data;
+	const uint8_t* end = data + size;
+	NetPacketType type;
+	if( !readPacketType( cursor, end, type ) )
+	{
+		return;
+	}
+
+	uint64_t key = getKey( address );
+	std::unordered_map<uint64_t, Peer>::iterator found = mPeers.find( key );
+	Peer* peer = found != mPeers.end() ? &found->second : NULL;
+
+	if( type == NET_CONNECT )
+	{
+		uint32_t matchId;
+		if( !readConnect( cursor, end, matchId ) )
+		{
+			return;
+		}
+
+		//Accepts can be lost so a repeated connect gets the same answer
+		if( peer == NULL )
+		{
+			peer = join( address, matchId );
+		}
+
+		if( peer == NULL )
+		{
+			beginPacket( mPacket, NET_REJECT );
+		}
+		else
+		{
+			peer->lastHeard = mTime;
+			beginPacket( mPacket, NET_ACCEPT );
+			int course = peer->match->course;
+			writeAccept( mPacket, peer->match->id, peer->player, mTick, mCourses[ course ]->getCollisionMode(), mCourseNames[ course ] );
+		}
+		mSocket.send( address, &mPacket[ 0 ], mPacket.size() );
+	}
+	else if( type == NET_INPUT && peer != NULL )
+	{
+		uint32_t snapshotAck, sentTime;
+		if( !readInput( cursor, end, snapshotAck, sentTime, mStrokes ) )
+		{
+			return;
+		}
+
+		peer->lastHeard = mTime;
+		if( snapshotAck > peer->snapshotAck && snapshotAck <= mTick )
+		{
+			peer->snapshotAck = snapshotAck;
+		}
+
+		//Inputs can arrive out of order, only the newest is echoed
+		if( sentTime > peer->echoTime )
+		{
+			peer->echoTime = sentTime;
+			peer->echoHeard = mTime;
+		}
+
+		//Queue strokes not seen yet in order
+		for( size_t i = 0; i < mStrokes.size(); ++i )
+		{
+			const NetStroke& stroke = mStrokes[ i ];
+			if( stroke.sequence > peer->strokeQueued && abs( stroke.dragX ) <= NET_MAX_DRAG && abs( stroke.dragY ) <= NET_MAX_DRAG )
+			{
+				queueStroke( *peer, stroke );
+			}
+		}
+	}
+	else if( type == NET_DISCONNECT && peer != NULL )
+	{
+		leave( key );
+	}
+}
+
+void NetServer::queueStroke( Peer& peer, const NetStroke& stroke )
+{
+	Match& match = *peer.match;
+	peer.strokeQueued = stroke.sequence;
+
+	//Late strokes are played on the next tick and ones too far ahead wait at the edge of the window
+	uint32_t tick = stroke.tick;
+	if( (int32_t)( tick - mTick ) < 0 )
+	{
+		tick = mTick;
+	}
+	else if( tick - mTick > (uint32_t)NET_MAX_STROKE_LEAD )
+	{
+		tick = mTick + NET_MAX_STROKE_LEAD;
+	}
+
+	//A player never has more waiting than they can resend, and their strokes stay in order
+	int waiting = 0;
+	for( size_t i = 0; i < match.strokes.size(); ++i )
+	{
+		if( match.strokes[ i ].player == peer.player )
+		{
+			++waiting;
+			tick = std::max( tick, match.strokes[ i ].tick );
+		}
+	}
+	if( waiting >= NET_MAX_PENDING_STROKES )
+	{
+		return;
+	}
+
+	QueuedStroke queued = { tick, stroke.sequence, peer.player, stroke.dragX, stroke.dragY };
+	std::vector<QueuedStroke>::iterator position = match.strokes.end();
+	while( position != match.strokes.begin() && ( position - 1 )->tick > tick )
+	{
+		--position;
+	}
+	match.strokes.insert( position, queued );
+}
+
+void NetServer::playStrokes( Match& match, uint32_t tick )
+{
+	//A ball that's still rolling ignores a stroke like it would locally
+	size_t played = 0;
+	for( ; played < match.strokes.size() && (int32_t)( match.strokes[ played ].tick - tick ) <= 0; ++played )
+	{
+		const QueuedStroke& stroke = match.strokes[ played ];
+		BallState& ball = match.balls[ stroke.player ];
+		StrokeInput input = { stroke.dragX, stroke.dragY };
+		if( !ball.touchingHole )
+		{
+			applyMouseButton( ball, input, false, 0, 0 );
+		}
+		match.strokeAcks[ stroke.player ] = stroke.sequence;
+	}
+	match.strokes.erase( match.strokes.begin(), match.strokes.begin() + played );
+}
+
+NetServer::Peer* NetServer::join( const NetAddress& address, uint32_t matchId )
+{
+	//Find the match or start it
+	Match* match = NULL;
+	std::unordered_map<uint32_t, Match*>::iterator found = mMatches.find( matchId );
+	if( found != mMatches.end() )
+	{
+		match = found->second;
+	}
+	else
+	{
+		match = new Match;
+		match->id = matchId;
+		match->course = matchId % mCourses.size();
+		match->players = 0;
+		match->strokes.reserve( NET_MAX_PLAYERS * NET_MAX_PENDING_STROKES );
+		mMatches[ matchId ] = match;
+		mMatchList.insert( std::upper_bound( mMatchList.begin(), mMatchList.end(), match, isEarlierCourse ), match );
+	}
+
+	//Reuse a ball left behind or add one
+	int player = -1;
+	for( size_t i = 0; i < match->taken.size() && player == -1; ++i )
+	{
+		if( !match->taken[ i ] )
+		{
+			player = i;
+		}
+	}
+	if( player == -1 )
+	{
+		if( (int)match->balls.size() >= NET_MAX_PLAYERS )
+		{
+			printf( "Match %u is full!\n", matchId );
+			return NULL;
+		}
+
+		player = match->balls.size();
+		match->balls.push_back( makeTeeBall( *mCourses[ match->course ] ) );
+		match->taken.push_back( false );
+		match->strokeAcks.push_back( 0 );
+	}
+
+	match->balls[ player ] = makeTeeBall( *mCourses[ match->course ] );
+	match->taken[ player ] = true;
+	match->strokeAcks[ player ] = 0;
+	++match->players;
+
+	Peer peer = { address, match, player, 0, 0, 0, mTime, mTime };
+	return &( mPeers[ getKey( address ) ] = peer );
+}
+
+void NetServer::leave( uint64_t key )
+{
+	std::unordered_map<uint64_t, Peer>::iterator found = mPeers.find( key );
+	if( found == mPeers.end() )
+	{
+		return;
+	}
+
+	//Free the ball along with any strokes still waiting for it, and the match once nobody is left
+	Match* match = found->second.match;
+	int player = found->second.player;
+	match->taken[ player ] = false;
+	size_t kept = 0;
+	for( size_t i = 0; i < match->strokes.size(); ++i )
+	{
+		if( match->strokes[ i ].player != player )
+		{
+			match->strokes[ kept++ ] = match->strokes[ i ];
+		}
+	}
+	match->strokes.resize( kept );
+	if( --match->players == 0 )
+	{
+		mMatches.erase( match->id );
+		mMatchList.erase( std::find( mMatchList.begin(), mMatchList.end(), match ) );
+		delete match;
+	}
+
+	mPeers.erase( found );
+}
+
+void NetServer::stepMatches( int ticks )
+{
+	int batches = ( mMatchList.size() + NET_MATCH_BATCH - 1 ) / NET_MATCH_BATCH;
+	uint32_t start = mTick;
+	mPool->parallelFor( batches, [ this, ticks, start ]( int batch, int worker )
+	{
+		Broadphase& broadphase = mBroadphases[ worker ];
+		std::vector<BodyPair>& pairs = mPairs[ worker ];
+		int last = std::min( (int)mMatchList.size(), ( batch + 1 ) * NET_MATCH_BATCH );
+		for( int i = batch * NET_MATCH_BATCH; i < last; ++i )
+		{
+			//Matches only share read only course data so they step independently
+			Match& match = *mMatchList[ i ];
+			const Course& course = *mCourses[ match.course ];
+			for( int tick = 0; tick < ticks; ++tick )
+			{
+				//Strokes go in before the tick they were played on is stepped, the same as the client replays them
+				if( !match.strokes.empty() )
+				{
+					playStrokes( match, start + tick );
+				}
+
+				//Every ball moves before any of them bounce off each other
+				broadphase.clear();
+				for( size_t ball = 0; ball < match.balls.size(); ++ball )
+				{
+					if( match.taken[ ball ] )
+					{
+						stepNetBall( match.balls[ ball ], course );
+						if( !match.balls[ ball ].touchingHole )
+						{
+							broadphase.insert( ball, getCollider( match.balls[ ball ] ) );
+						}
+					}
+				}
+				broadphase.findPairs( pairs );
+				collideBalls( match.balls, pairs );
+			}
+		}
+	} );
+}
+
+void NetServer::sendSnapshots()
+{
+	//Both sides carry on from the quantized balls so a client's prediction matches exactly
+	int batches = ( mMatchList.size() + NET_MATCH_BATCH - 1 ) / NET_MATCH_BATCH;
+	mPool->parallelFor( batches, [ this ]( int batch, int )
+	{
+		int last = std::min( (int)mMatchList.size(), ( batch + 1 ) * NET_MATCH_BATCH );
+		for( int i = batch * NET_MATCH_BATCH; i < last; ++i )
+		{
+			Match& match = *mMatchList[ i ];
+			match.snapshot.resize( match.balls.size() );
+			for( size_t ball = 0; ball < match.balls.size(); ++ball )
+			{
+				match.snapshot[ ball ] = quantizeBall( match.balls[ ball ], match.taken[ ball ] );
+				match.balls[ ball ] = dequantizeBall( match.snapshot[ ball ] );
+			}
+			match.history.store( mTick, match.snapshot );
+		}
+	} );
+
+	//Every ball in a match goes in one packet, coded against what the player last acked
+	for( std::unordered_map<uint64_t, Peer>::iterator i = mPeers.begin(); i != mPeers.end(); ++i )
+	{
+		Peer& peer = i->second;
+		const std::vector<NetBall>* baseline = peer.match->history.find( peer.snapshotAck );
+		NetSnapshotInfo info = { mTick, peer.snapshotAck, peer.match->strokeAcks[ peer.player ], peer.echoTime, (uint32_t)( ( mTime - peer.echoHeard ) * 1000 ) };
+		beginPacket( mPacket, NET_SNAPSHOT );
+		writeSnapshot( mPacket, info, peer.match->snapshot, baseline );
+		mSocket.send( peer.address, &mPacket[ 0 ], mPacket.size() );
+	}
+}
+
+bool NetServer::isEarlierCourse( const Match* a, const Match* b )
+{
+	return a->course < b->course;
+}
+
+uint64_t NetServer::getKey( const NetAddress& address )
+{
+	return ( (uint64_t)address.host << 16 ) | address.port;
+}
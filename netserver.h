@@ -0,0 +1,161 @@
+//Authoritative match hosting over UDP, usable without SDL
+#ifndef NETSERVER_H
+#define NETSERVER_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "netcode.h"
+#include "netsocket.h"
+#include "threadpool.h"
+#include "broadphase.h"
+
+//Matches stepped together by one worker task
+const int NET_MATCH_BATCH = 64;
+
+//Socket queue size asked for, enough for every player's input to land between updates
+const int NET_SERVER_SOCKET_BUFFER = 1 << 22;
+
+//Runs every match's physics and streams snapshots to the players in it
+class NetServer
+{
+	public:
+		//Initializes variables
+		NetServer();
+
+		//Deallocates matches
+		~NetServer();
+
+		//Loads the courses matches are played on and starts listening, threads 0 uses every core
+		bool open( uint16_t port, const std::vector<std::string>& mapPaths, CollisionMode mode = COLLISION_SWEPT, int threads = 0 );
+
+		//Tells every player the server is going and stops listening
+		void close();
+
+		//Handles packets, runs the physics for the elapsed time and sends due snapshots
+		void update( double seconds );
+
+		//Gets the current physics tick
+		uint32_t getTick() const;
+
+		//Gets the matches and players being hosted
+		int getMatchCount() const;
+		int getPlayerCount() const;
+
+	private:
+		//Servers can't be copied since they own the socket
+		NetServer( const NetServer& );
+		NetServer& operator=( const NetServer& );
+
+		//A stroke held until the tick it was played on
+		struct QueuedStroke
+		{
+			uint32_t tick;
+			uint32_t sequence;
+			int player;
+			int dragX, dragY;
+		};
+
+		//A set of balls sharing a course
+		struct Match
+		{
+			uint32_t id;
+
+			//The course, shared read only with every other match on it
+			int course;
+
+			//The balls and whether a player holds each one
+			std::vector<BallState> balls;
+			std::vector<bool> taken;
+
+			//Strokes waiting for their tick in tick order, and the newest stroke played on each ball
+			std::vector<QueuedStroke> strokes;
+			std::vector<uint32_t> strokeAcks;
+
+			//The snapshots sent lately, for delta coding
+			SnapshotHistory history;
+			std::vector<NetBall> snapshot;
+
+			//Players in the match
+			int players;
+		};
+
+		//A connected player
+		struct Peer
+		{
+			NetAddress address;
+			Match* match;
+			int player;
+
+			//The newest stroke queued and snapshot acked
+			uint32_t strokeQueued;
+			uint32_t snapshotAck;
+
+			//The newest input time the player sent and when it arrived, echoed so the player can measure the round trip
+			uint32_t echoTime;
+			double echoHeard;
+
+			//When the player was last heard from
+			double lastHeard;
+		};
+
+		//Reads every waiting packet
+		void receive();
+
+		//Handles one packet from an address
+		void handlePacket( const NetAddress& address, const uint8_t* data, int size );
+
+		//Holds a player's stroke for the tick it was played on, clamped to the window the server accepts
+		void queueStroke( Peer& peer, const NetStroke& stroke );
+
+		//Adds a player to a match, creating it if needed, NULL if it's full
+		Peer* join( const NetAddress& address, uint32_t match );
+
+		//Removes a player, and the match once it's empty
+		void leave( uint64_t key );
+
+		//Steps every match from the current tick, playing strokes as their ticks come up, a batch of matches per task
+		void stepMatches( int ticks );
+
+		//Plays a match's strokes due by a tick
+		static void playStrokes( Match& match, uint32_t tick );
+
+		//Quantizes every match and sends each player a snapshot
+		void sendSnapshots();
+
+		//Orders matches by course so a batch keeps touching the same map data
+		static bool isEarlierCourse( const Match* a, const Match* b );
+
+		//Packs an address into a lookup key
+		static uint64_t getKey( const NetAddress& address );
+
+		//The socket players talk to
+		UdpSocket mSocket;
+
+		//The courses, loaded once however many matches are on them
+		std::vector<Course*> mCourses;
+		std::vector<std::string> mCourseNames;
+
+		//The matches by id, in course order and players by address
+		std::unordered_map<uint32_t, Match*> mMatches;
+		std::vector<Match*> mMatchList;
+		std::unordered_map<uint64_t, Peer> mPeers;
+
+		//The workers matches are stepped on, each with its own contact scratch
+		ThreadPool* mPool;
+		std::vector<Broadphase> mBroadphases;
+		std::vector< std::vector<BodyPair> > mPairs;
+
+		//The physics clock
+		uint32_t mTick;
+		double mAccumulator;
+		double mTime;
+
+		//Scratch reused for every packet
+		std::vector<uint8_t> mPacket;
+		std::vector<NetStroke> mStrokes;
+		uint8_t mBuffer[ NET_MAX_PACKET ];
+};
+
+#endif
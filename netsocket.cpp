@@ -0,0 +1,209 @@
+//Non blocking UDP sockets
+#include "netsocket.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+//The handle of a socket that isn't open
+static const intptr_t INVALID_HANDLE = -1;
+
+//Starts the socket library once, Windows needs it before any call
+static bool startSockets()
+{
+	#ifdef _WIN32
+	static bool started = false;
+	if( !started )
+	{
+		WSADATA data;
+		if( WSAStartup( MAKEWORD( 2, 2 ), &data ) != 0 )
+		{
+			printf( "Unable to start Winsock!\n" );
+			return false;
+		}
+		started = true;
+	}
+	#endif
+
+	return true;
+}
+
+//Fills a socket address from an endpoint
+static sockaddr_in toSocketAddress( const NetAddress& address )
+{
+	sockaddr_in socketAddress;
+	memset( &socketAddress, 0, sizeof( socketAddress ) );
+	socketAddress.sin_family = AF_INET;
+	socketAddress.sin_addr.s_addr = htonl( address.host );
+	socketAddress.sin_port = htons( address.port );
+	return socketAddress;
+}
+
+bool isSameAddress( const NetAddress& a, const NetAddress& b )
+{
+	return a.host == b.host && a.port == b.port;
+}
+
+bool resolveAddress( const std::string& text, NetAddress& address )
+{
+	size_t colon = text.find_last_of( ':' );
+	if( colon == std::string::npos || colon + 1 == text.size() || !startSockets() )
+	{
+		printf( "Unable to resolve %s, expected host:port!\n", text.c_str() );
+		return false;
+	}
+
+	std::string host = text.substr( 0, colon );
+	addrinfo hints;
+	memset( &hints, 0, sizeof( hints ) );
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	addrinfo* results = NULL;
+	if( getaddrinfo( host.c_str(), NULL, &hints, &results ) != 0 || results == NULL )
+	{
+		printf( "Unable to resolve host %s!\n", host.c_str() );
+		return false;
+	}
+
+	address.host = ntohl( ( (sockaddr_in*)results->ai_addr )->sin_addr.s_addr );
+	address.port = (uint16_t)atoi( text.c_str() + colon + 1 );
+	freeaddrinfo( results );
+	return true;
+}
+
+UdpSocket::UdpSocket()
+{
+	//Initialize
+	mHandle = INVALID_HANDLE;
+}
+
+UdpSocket::~UdpSocket()
+{
+	//Deallocate
+	close();
+}
+
+bool UdpSocket::open( uint16_t port )
+{
+	close();
+	if( !startSockets() )
+	{
+		return false;
+	}
+
+	#ifdef _WIN32
+	SOCKET handle = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if( handle == INVALID_SOCKET )
+	#else
+	int handle = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if( handle < 0 )
+	#endif
+	{
+		printf( "Unable to create socket!\n" );
+		return false;
+	}
+	mHandle = (intptr_t)handle;
+
+	//Listen on every interface
+	NetAddress local = { INADDR_ANY, port };
+	sockaddr_in socketAddress = toSocketAddress( local );
+	if( bind( handle, (sockaddr*)&socketAddress, sizeof( socketAddress ) ) != 0 )
+	{
+		printf( "Unable to bind socket to port %u!\n", port );
+		close();
+		return false;
+	}
+
+	//Reads and writes return straight away
+	#ifdef _WIN32
+	u_long nonBlocking = 1;
+	bool unblocked = ioctlsocket( handle, FIONBIO, &nonBlocking ) == 0;
+	#else
+	bool unblocked = fcntl( handle, F_SETFL, fcntl( handle, F_GETFL, 0 ) | O_NONBLOCK ) == 0;
+	#endif
+	if( !unblocked )
+	{
+		printf( "Unable to make socket non blocking!\n" );
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void UdpSocket::close()
+{
+	if( mHandle != INVALID_HANDLE )
+	{
+		#ifdef _WIN32
+		closesocket( (SOCKET)mHandle );
+		#else
+		::close( (int)mHandle );
+		#endif
+		mHandle = INVALID_HANDLE;
+	}
+}
+
+bool UdpSocket::isOpen() const
+{
+	return mHandle != INVALID_HANDLE;
+}
+
+bool UdpSocket::setBufferSize( int bytes )
+{
+	//The system can clamp the size, which is fine as this is only a hint
+	#ifdef _WIN32
+	SOCKET handle = (SOCKET)mHandle;
+	const char* value = (const char*)&bytes;
+	#else
+	int handle = (int)mHandle;
+	const void* value = &bytes;
+	#endif
+	bool receiving = setsockopt( handle, SOL_SOCKET, SO_RCVBUF, value, sizeof( bytes ) ) == 0;
+	bool sending = setsockopt( handle, SOL_SOCKET, SO_SNDBUF, value, sizeof( bytes ) ) == 0;
+	return receiving && sending;
+}
+
+bool UdpSocket::send( const NetAddress& address, const uint8_t* data, size_t size )
+{
+	if( !isOpen() )
+	{
+		return false;
+	}
+
+	sockaddr_in socketAddress = toSocketAddress( address );
+	return sendto( mHandle, (const char*)data, (int)size, 0, (sockaddr*)&socketAddress, sizeof( socketAddress ) ) == (int)size;
+}
+
+int UdpSocket::receive( NetAddress& address, uint8_t* buffer, size_t size )
+{
+	if( !isOpen() )
+	{
+		return 0;
+	}
+
+	sockaddr_in socketAddress;
+	socklen_t addressSize = sizeof( socketAddress );
+	int received = recvfrom( mHandle, (char*)buffer, (int)size, 0, (sockaddr*)&socketAddress, &addressSize );
+	if( received <= 0 )
+	{
+		return 0;
+	}
+
+	address.host = ntohl( socketAddress.sin_addr.s_addr );
+	address.port = ntohs( socketAddress.sin_port );
+	return received;
+}
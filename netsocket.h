@@ -0,0 +1,59 @@
+//Non blocking UDP sockets, usable without SDL
+#ifndef NETSOCKET_H
+#define NETSOCKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+//An IPv4 endpoint in host byte order
+struct NetAddress
+{
+	uint32_t host;
+	uint16_t port;
+};
+
+//Checks if two endpoints are the same
+bool isSameAddress( const NetAddress& a, const NetAddress& b );
+
+//Looks up "host:port", false if it can't be resolved
+bool resolveAddress( const std::string& text, NetAddress& address );
+
+//A UDP socket that never blocks
+class UdpSocket
+{
+	public:
+		//Initializes variables
+		UdpSocket();
+
+		//Closes the socket
+		~UdpSocket();
+
+		//Binds to a local port, 0 picks any free one
+		bool open( uint16_t port = 0 );
+
+		//Closes the socket
+		void close();
+
+		//Checks if the socket is open
+		bool isOpen() const;
+
+		//Asks for bigger kernel queues so bursts from many peers aren't dropped
+		bool setBufferSize( int bytes );
+
+		//Sends one datagram, false if it couldn't be queued
+		bool send( const NetAddress& address, const uint8_t* data, size_t size );
+
+		//Receives one datagram, returns its size or 0 if none are waiting
+		int receive( NetAddress& address, uint8_t* buffer, size_t size );
+
+	private:
+		//Sockets can't be copied since they own the handle
+		UdpSocket( const UdpSocket& );
+		UdpSocket& operator=( const UdpSocket& );
+
+		//The socket handle, wide enough for a Windows SOCKET
+		intptr_t mHandle;
+};
+
+#endif
@@ -0,0 +1,687 @@
+//Headless golf physics
+#include "physics.h"
+#include "stepping.h"
+#include <stdio.h>
+#include <cmath>
+#include <algorithm>
+
+Course::Course()
+{
+	//Initialize
+	mCollisionMode = COLLISION_SWEPT;
+}
+
+bool Course::loadFromFile( const std::string& path )
+{
+	if( !mTiles.loadFromFile( path ) )
+	{
+		return false;
+	}
+
+	//Fields baked from the old tiles are stale
+	if( mCollisionMode == COLLISION_FIELD && !bakeFields() )
+	{
+		printf( "Falling back to swept collision!\n" );
+		mCollisionMode = COLLISION_SWEPT;
+	}
+
+	return true;
+}
+
+bool Course::loadFromTypes( int columns, int rows, const uint8_t* types )
+{
+	if( !mTiles.loadFromTypes( columns, rows, types ) )
+	{
+		return false;
+	}
+
+	//Fields baked from the old tiles are stale
+	if( mCollisionMode == COLLISION_FIELD && !bakeFields() )
+	{
+		printf( "Falling back to swept collision!\n" );
+		mCollisionMode = COLLISION_SWEPT;
+	}
+
+	return true;
+}
+
+const TileMap& Course::getTiles() const
+{
+	return mTiles;
+}
+
+void Course::swap( Course& other )
+{
+	mTiles.swap( other.mTiles );
+	std::swap( mCollisionMode, other.mCollisionMode );
+	mWallField.swap( other.mWallField );
+	mHoleField.swap( other.mHoleField );
+}
+
+bool Course::reloadFromFile( const std::string& path, std::vector<int>& changed, bool& replaced )
+{
+	changed.clear();
+	replaced = false;
+
+	TileMap edited;
+	if( !edited.loadFromFile( path ) )
+	{
+		return false;
+	}
+
+	//Mapped tiles can't be written and a resized grid changes everything
+	if( mTiles.isMapped() || !mTiles.diff( edited, changed ) )
+	{
+		changed.clear();
+		mTiles.swap( edited );
+		replaced = true;
+		if( mCollisionMode == COLLISION_FIELD && !bakeFields() )
+		{
+			printf( "Falling back to swept collision!\n" );
+			mCollisionMode = COLLISION_SWEPT;
+		}
+		return true;
+	}
+
+	for( size_t i = 0; i < changed.size(); ++i )
+	{
+		mTiles.setType( changed[ i ], edited.getType( changed[ i ] ) );
+	}
+
+	//Only samples near an edited tile can have moved
+	if( mCollisionMode == COLLISION_FIELD )
+	{
+		for( size_t i = 0; i < changed.size(); ++i )
+		{
+			Rect box = mTiles.getBox( changed[ i ] );
+			mWallField.update( mTiles, mTiles.getWallMask(), box );
+			mHoleField.update( mTiles, mTiles.getHoleMask(), box );
+		}
+	}
+
+	return true;
+}
+
+bool Course::setCollisionMode( CollisionMode mode )
+{
+	if( mode == COLLISION_FIELD && !bakeFields() )
+	{
+		return false;
+	}
+
+	//Swept collision reads the tiles directly
+	if( mode == COLLISION_SWEPT )
+	{
+		mWallField.free();
+		mHoleField.free();
+	}
+
+	mCollisionMode = mode;
+	return true;
+}
+
+CollisionMode Course::getCollisionMode() const
+{
+	return mCollisionMode;
+}
+
+const DistanceField& Course::getWallField() const
+{
+	return mWallField;
+}
+
+const DistanceField& Course::getHoleField() const
+{
+	return mHoleField;
+}
+
+bool Course::bakeFields()
+{
+	if( !mWallField.build( mTiles, mTiles.getWallMask() ) || !mHoleField.build( mTiles, mTiles.getHoleMask() ) )
+	{
+		mWallField.free();
+		mHoleField.free();
+		return false;
+	}
+
+	return true;
+}
+
+bool checkCollision( const Circle& a, const Rect& b )
+{
+	//Closest point on collision box
+	float cX, cY;
+
+	//Find closest x offset
+	if( a.x < b.x )
+	{
+		cX = b.x;
+	}
+	else if( a.x > b.x + b.w )
+	{
+		cX = b.x + b.w;
+	}
+	else
+	{
+		cX = a.x;
+	}
+
+	//Find closest y offset
+	if( a.y < b.y )
+	{
+		cY = b.y;
+	}
+	else if( a.y > b.y + b.h )
+	{
+		cY = b.y + b.h;
+	}
+	else
+	{
+		cY = a.y;
+	}
+
+	//If the closest point is inside the circle
+	if( distanceSquared( a.x, a.y, cX, cY ) < a.r * a.r )
+	{
+		//This box and the circle have collided
+		return true;
+	}
+
+	//If the shapes have not collided
+	return false;
+}
+
+//The grid cells covered by a box, clamped to the map
+struct CellRange
+{
+	int firstColumn, lastColumn;
+	int firstRow, lastRow;
+};
+
+//Gets the grid cells covered by the box from minX, minY to maxX, maxY
+static CellRange getCellRange( const TileMap& tiles, float minX, float minY, float maxX, float maxY )
+{
+	CellRange range;
+	range.firstColumn = (int)floor( minX / TILE_WIDTH );
+	range.lastColumn = (int)floor( maxX / TILE_WIDTH );
+	range.firstRow = (int)floor( minY / TILE_HEIGHT );
+	range.lastRow = (int)floor( maxY / TILE_HEIGHT );
+
+	//Keep the cells on the grid
+	if( range.firstColumn < 0 ) range.firstColumn = 0;
+	if( range.firstRow < 0 ) range.firstRow = 0;
+	if( range.lastColumn >= tiles.getColumns() ) range.lastColumn = tiles.getColumns() - 1;
+	if( range.lastRow >= tiles.getRows() ) range.lastRow = tiles.getRows() - 1;
+
+	return range;
+}
+
+//Checks if a tile is set in a one bit per tile mask
+static bool isMasked( const uint8_t* mask, int i )
+{
+	return ( mask[ i >> 3 ] >> ( i & 7 ) ) & 1;
+}
+
+//Checks collision circle against the masked tiles in the grid cells it covers
+static bool touchesMaskedTile( const Circle& circle, const TileMap& tiles, const uint8_t* mask )
+{
+	CellRange range = getCellRange( tiles, circle.x - circle.r, circle.y - circle.r, circle.x + circle.r, circle.y + circle.r );
+
+	//Go through the covered tiles only
+	for( int row = range.firstRow; row <= range.lastRow; ++row )
+	{
+		for( int column = range.firstColumn; column <= range.lastColumn; ++column )
+		{
+			int i = row * tiles.getColumns() + column;
+
+			//If the tile is in the mask and the collision box touches it
+			if( isMasked( mask, i ) && checkCollision( circle, tiles.getBox( i ) ) )
+			{
+				return true;
+			}
+		}
+	}
+
+	//If no masked tiles were touched
+	return false;
+}
+
+//Gets the cells a circle moving by dx, dy passes over
+static CellRange getSweptCellRange( const TileMap& tiles, const Circle& circle, float dx, float dy )
+{
+	float minX = dx < 0 ? circle.x + dx : circle.x;
+	float maxX = dx < 0 ? circle.x : circle.x + dx;
+	float minY = dy < 0 ? circle.y + dy : circle.y;
+	float maxY = dy < 0 ? circle.y : circle.y + dy;
+	return getCellRange( tiles, minX - circle.r, minY - circle.r, maxX + circle.r, maxY + circle.r );
+}
+
+//Finds the closest point on a box to a point
+static void closestPoint( const Rect& box, float x, float y, float& cX, float& cY )
+{
+	cX = x < box.x ? box.x : ( x > box.x + box.w ? box.x + box.w : x );
+	cY = y < box.y ? box.y : ( y > box.y + box.h ? box.y + box.h : y );
+}
+
+bool sweepCircle( const Circle& circle, float dx, float dy, const Rect& box, SweepHit& hit )
+{
+	//If the circle already overlaps the box only count it when moving further in
+	float cX, cY;
+	closestPoint( box, circle.x, circle.y, cX, cY );
+	float deltaX = circle.x - cX;
+	float deltaY = circle.y - cY;
+	float distance = deltaX * deltaX + deltaY * deltaY;
+	if( distance < circle.r * circle.r )
+	{
+		float normalX = 0, normalY = 0;
+		if( distance > 0 )
+		{
+			//Push out from the closest point
+			distance = sqrt( distance );
+			normalX = deltaX / distance;
+			normalY = deltaY / distance;
+		}
+		else
+		{
+			//The center is inside the box so push out the shortest way
+			float left = circle.x - box.x, right = box.x + box.w - circle.x;
+			float top = circle.y - box.y, bottom = box.y + box.h - circle.y;
+			float nearest = fmin( fmin( left, right ), fmin( top, bottom ) );
+			if( nearest == left ) normalX = -1;
+			else if( nearest == right ) normalX = 1;
+			else if( nearest == top ) normalY = -1;
+			else normalY = 1;
+		}
+
+		if( dx * normalX + dy * normalY >= 0 )
+		{
+			return false;
+		}
+
+		hit.time = 0;
+		hit.normalX = normalX;
+		hit.normalY = normalY;
+		return true;
+	}
+
+	//Slab test against the box grown by the radius
+	float minX = box.x - circle.r, maxX = box.x + box.w + circle.r;
+	float minY = box.y - circle.r, maxY = box.y + box.h + circle.r;
+	float tEnter = 0, tExit = 1;
+
+	if( dx == 0 )
+	{
+		if( circle.x < minX || circle.x > maxX ) return false;
+	}
+	else
+	{
+		float t1 = ( minX - circle.x ) / dx;
+		float t2 = ( maxX - circle.x ) / dx;
+		if( t1 > t2 ) { float t = t1; t1 = t2; t2 = t; }
+		if( t1 > tEnter ) tEnter = t1;
+		if( t2 < tExit ) tExit = t2;
+		if( tEnter > tExit ) return false;
+	}
+
+	if( dy == 0 )
+	{
+		if( circle.y < minY || circle.y > maxY ) return false;
+	}
+	else
+	{
+		float t1 = ( minY - circle.y ) / dy;
+		float t2 = ( maxY - circle.y ) / dy;
+		if( t1 > t2 ) { float t = t1; t1 = t2; t2 = t; }
+		if( t1 > tEnter ) tEnter = t1;
+		if( t2 < tExit ) tExit = t2;
+		if( tEnter > tExit ) return false;
+	}
+
+	//Where the center enters the grown box
+	float enterX = circle.x + dx * tEnter;
+	float enterY = circle.y + dy * tEnter;
+
+	//Entering beside a face hits that face, if moving into it
+	bool besideX = enterX >= box.x && enterX <= box.x + box.w;
+	bool besideY = enterY >= box.y && enterY <= box.y + box.h;
+	if( besideY && !besideX )
+	{
+		float normalX = enterX < box.x ? -1 : 1;
+		if( dx * normalX >= 0 )
+		{
+			return false;
+		}
+
+		hit.time = tEnter;
+		hit.normalX = normalX;
+		hit.normalY = 0;
+		return true;
+	}
+	if( besideX && !besideY )
+	{
+		float normalY = enterY < box.y ? -1 : 1;
+		if( dy * normalY >= 0 )
+		{
+			return false;
+		}
+
+		hit.time = tEnter;
+		hit.normalX = 0;
+		hit.normalY = normalY;
+		return true;
+	}
+	if( besideX && besideY )
+	{
+		return false;
+	}
+
+	//Otherwise it's heading for the rounded corner
+	float cornerX = enterX < box.x ? box.x : box.x + box.w;
+	float cornerY = enterY < box.y ? box.y : box.y + box.h;
+	float mX = circle.x - cornerX;
+	float mY = circle.y - cornerY;
+	float a = dx * dx + dy * dy;
+	float b = mX * dx + mY * dy;
+	float c = mX * mX + mY * mY - circle.r * circle.r;
+	float discriminant = b * b - a * c;
+	if( a == 0 || discriminant < 0 )
+	{
+		return false;
+	}
+
+	//Real overlaps were handled above so an entry just behind the start is rounding
+	float t = ( -b - sqrt( discriminant ) ) / a;
+	if( ( -b + sqrt( discriminant ) ) / a < 0 || t > 1 )
+	{
+		return false;
+	}
+	if( t < 0 )
+	{
+		t = 0;
+	}
+
+	//Only moving into the corner counts, not grazing past it
+	float normalX = ( mX + dx * t ) / circle.r;
+	float normalY = ( mY + dy * t ) / circle.r;
+	if( dx * normalX + dy * normalY >= 0 )
+	{
+		return false;
+	}
+
+	hit.time = t;
+	hit.normalX = normalX;
+	hit.normalY = normalY;
+	return true;
+}
+
+//Marches a circle moving by dx, dy through the wall field to the first surface it moves into
+static bool marchWalls( const Circle& circle, float dx, float dy, const DistanceField& field, SweepHit& hit )
+{
+	float length = sqrt( dx * dx + dy * dy );
+	if( length == 0 )
+	{
+		return false;
+	}
+
+	float travelled = 0;
+	for( int march = 0; march < MAX_FIELD_MARCHES; ++march )
+	{
+		float x = circle.x + dx * ( travelled / length );
+		float y = circle.y + dy * ( travelled / length );
+		float gap = field.getDistance( x, y ) - circle.r;
+
+		if( gap <= FIELD_CONTACT )
+		{
+			//Surfaces the ball is leaving don't stop it
+			float normalX, normalY;
+			field.getNormal( x, y, normalX, normalY );
+			if( dx * normalX + dy * normalY < 0 )
+			{
+				hit.time = travelled / length;
+				hit.normalX = normalX;
+				hit.normalY = normalY;
+				return true;
+			}
+		}
+
+		//The free space around the ball can be skipped in one go
+		travelled += std::max( gap * FIELD_MARCH_SCALE, FIELD_MIN_MARCH );
+		if( travelled >= length )
+		{
+			return false;
+		}
+	}
+
+	return false;
+}
+
+//Marches a circle moving by dx, dy through the hole field checking if it ever overlaps
+static bool marchHole( const Circle& circle, float dx, float dy, const DistanceField& field )
+{
+	float length = sqrt( dx * dx + dy * dy );
+	float travelled = 0;
+	for( int march = 0; march < MAX_FIELD_MARCHES; ++march )
+	{
+		float x = length > 0 ? circle.x + dx * ( travelled / length ) : circle.x;
+		float y = length > 0 ? circle.y + dy * ( travelled / length ) : circle.y;
+		float gap = field.getDistance( x, y ) - circle.r;
+		if( gap < 0 )
+		{
+			return true;
+		}
+
+		travelled += std::max( gap * FIELD_MARCH_SCALE, FIELD_MIN_MARCH );
+		if( travelled >= length )
+		{
+			return false;
+		}
+	}
+
+	return false;
+}
+
+bool sweepWalls( const Circle& circle, float dx, float dy, const Course& course, SweepHit& hit )
+{
+	const TileMap& tiles = course.getTiles();
+	bool found = false;
+
+	//The level bounds keep the whole ball inside
+	sweepBounds( circle, dx, dy, tiles.getWidth(), tiles.getHeight(), hit, found );
+
+	//The field gives the distance to every wall in one lookup
+	if( course.getCollisionMode() == COLLISION_FIELD )
+	{
+		SweepHit fieldHit;
+		if( marchWalls( circle, dx, dy, course.getWallField(), fieldHit ) )
+		{
+			takeEarlier( hit, found, fieldHit.time, fieldHit.normalX, fieldHit.normalY );
+		}
+
+		return found;
+	}
+
+	//Go through the wall tiles along the path
+	CellRange range = getSweptCellRange( tiles, circle, dx, dy );
+	const uint8_t* walls = tiles.getWallMask();
+	for( int row = range.firstRow; row <= range.lastRow; ++row )
+	{
+		for( int column = range.firstColumn; column <= range.lastColumn; ++column )
+		{
+			int i = row * tiles.getColumns() + column;
+
+			SweepHit tileHit;
+			if( isMasked( walls, i ) && sweepCircle( circle, dx, dy, tiles.getBox( i ), tileHit ) )
+			{
+				takeEarlier( hit, found, tileHit.time, tileHit.normalX, tileHit.normalY );
+			}
+		}
+	}
+
+	return found;
+}
+
+bool sweepsHole( const Circle& circle, float dx, float dy, const Course& course )
+{
+	if( course.getCollisionMode() == COLLISION_FIELD )
+	{
+		return marchHole( circle, dx, dy, course.getHoleField() );
+	}
+
+	//Go through the hole tiles along the path
+	const TileMap& tiles = course.getTiles();
+	CellRange range = getSweptCellRange( tiles, circle, dx, dy );
+	const uint8_t* holes = tiles.getHoleMask();
+	for( int row = range.firstRow; row <= range.lastRow; ++row )
+	{
+		for( int column = range.firstColumn; column <= range.lastColumn; ++column )
+		{
+			int i = row * tiles.getColumns() + column;
+			if( !isMasked( holes, i ) )
+			{
+				continue;
+			}
+
+			//Starting over the hole or crossing into it both count
+			SweepHit hit;
+			Rect box = tiles.getBox( i );
+			if( checkCollision( circle, box ) || sweepCircle( circle, dx, dy, box, hit ) )
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool touchesWall( const Circle& circle, const Course& course )
+{
+	if( course.getCollisionMode() == COLLISION_FIELD )
+	{
+		return course.getWallField().getDistance( circle.x, circle.y ) < circle.r;
+	}
+
+	return touchesMaskedTile( circle, course.getTiles(), course.getTiles().getWallMask() );
+}
+
+bool touchesHole( const Circle& circle, const Course& course )
+{
+	if( course.getCollisionMode() == COLLISION_FIELD )
+	{
+		return course.getHoleField().getDistance( circle.x, circle.y ) < circle.r;
+	}
+
+	return touchesMaskedTile( circle, course.getTiles(), course.getTiles().getHoleMask() );
+}
+
+float distanceSquared( float x1, float y1, float x2, float y2 )
+{
+	float deltaX = x2 - x1;
+	float deltaY = y2 - y1;
+	return deltaX*deltaX + deltaY*deltaY;
+}
+
+BallState makeBall( float x, float y )
+{
+	BallState ball;
+
+	//Initialize the offsets
+	ball.posX = x;
+	ball.posY = y;
+
+	//Initialize the velocity
+	ball.velX = 0;
+	ball.velY = 0;
+
+	ball.touchingHole = false;
+
+	return ball;
+}
+
+BallState makeTeeBall( const Course& course )
+{
+	return makeBall( course.getTiles().getWidth() / 2, course.getTiles().getHeight() - TILE_HEIGHT );
+}
+
+Circle getCollider( const BallState& ball )
+{
+	//Align collider to center of ball
+	Circle collider;
+	collider.x = int( ball.posX );
+	collider.y = int( ball.posY );
+	collider.r = BALL_WIDTH / 2;
+	return collider;
+}
+
+bool isAtRest( const BallState& ball )
+{
+	return ball.velX == 0 && ball.velY == 0;
+}
+
+StrokeInput makeStrokeInput()
+{
+	StrokeInput input;
+	input.downX = 0;
+	input.downY = 0;
+	return input;
+}
+
+bool applyMouseButton( BallState& ball, StrokeInput& input, bool down, int x, int y )
+{
+	//The ball can only be played once it stops
+	if( !isAtRest( ball ) )
+	{
+		return false;
+	}
+
+	if( down )
+	{
+		input.downX = x;
+		input.downY = y;
+		return false;
+	}
+
+	//Hit the ball away from the drag
+	float changeX = input.downX - x;
+	float changeY = input.downY - y;
+	ball.velX += changeX * DRAG_VELOCITY;
+	ball.velY += changeY * DRAG_VELOCITY;
+	return true;
+}
+
+double getDamping( float timeStep )
+{
+	//The fixed step is by far the most common so keep it precomputed
+	static const double fixedDamping = pow( BALL_DAMPING, PHYSICS_TIMESTEP / BALL_DAMPING_INTERVAL );
+	if( timeStep == PHYSICS_TIMESTEP )
+	{
+		return fixedDamping;
+	}
+
+	return pow( BALL_DAMPING, timeStep / BALL_DAMPING_INTERVAL );
+}
+
+void dampBall( BallState& ball, float timeStep )
+{
+	//Damp by the same amount per second at any step size, in float so batched balls match
+	float damping = (float)getDamping( timeStep );
+	ball.velX = ball.velX * damping;
+	ball.velY = ball.velY * damping;
+
+	//Stop the ball once it has slowed down enough on both axes
+	if( ball.velX < BALL_REST_VEL && ball.velX > -BALL_REST_VEL && ball.velY < BALL_REST_VEL && ball.velY > -BALL_REST_VEL )
+	{
+		ball.velX = 0;
+		ball.velY = 0;
+	}
+}
+
+int step( BallState& ball, const Course& course, float timeStep )
+{
+	return stepThrough( ball, LoadedCourse( course ), timeStep );
+}
+
+ShotResult simulateShot( const Course& course, const BallState& start, float velX, float velY, int maxSteps )
+{
+	return simulateShotThrough( LoadedCourse( course ), start, velX, velY, maxSteps );
+}
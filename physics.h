@@ -0,0 +1,197 @@
+//Headless golf physics, usable without SDL
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include <string>
+#include <vector>
+#include "tilemap.h"
+#include "distancefield.h"
+
+//The dimensions of the ball
+const int BALL_WIDTH = 20;
+const int BALL_HEIGHT = 20;
+
+//Velocity damping applied over every damping interval
+const double BALL_DAMPING = 0.97;
+const float BALL_DAMPING_INTERVAL = 1.f / 60.f;
+
+//Axis velocity below which the ball comes to rest
+const float BALL_REST_VEL = 20;
+
+//Fixed simulation rate in steps per second and the matching time step
+const int PHYSICS_TICK_RATE = 240;
+const float PHYSICS_TIMESTEP = 1.f / PHYSICS_TICK_RATE;
+
+//The velocity a stroke gives per pixel of mouse drag
+const float DRAG_VELOCITY = 3;
+
+//Upper bound on steps for a single simulated shot
+const int MAX_SHOT_STEPS = 100000;
+
+//Upper bound on bounces resolved within one step
+const int MAX_STEP_BOUNCES = 8;
+
+//Upper bound on distance field lookups for one movement
+const int MAX_FIELD_MARCHES = 32;
+
+//Gap in pixels at which a ball marching through a distance field touches a wall
+const float FIELD_CONTACT = 0.1f;
+
+//Interpolated distances can run a little long so marches step short of them
+const float FIELD_MARCH_SCALE = 0.7f;
+const float FIELD_MIN_MARCH = 0.5f;
+
+//How balls are collided with the course
+enum CollisionMode
+{
+	//Exact swept tests against the tile boxes
+	COLLISION_SWEPT,
+
+	//Lookups into distance fields baked at load time
+	COLLISION_FIELD
+};
+
+//A circle stucture
+struct Circle
+{
+	float x, y;
+	float r;
+};
+
+//The level the ball is played through
+class Course
+{
+	public:
+		//Initializes variables
+		Course();
+
+		//Loads tile types from map file
+		bool loadFromFile( const std::string& path );
+
+		//Loads tile types laid out row major, such as a generated map's
+		bool loadFromTypes( int columns, int rows, const uint8_t* types );
+
+		//Gets the level tiles
+		const TileMap& getTiles() const;
+
+		//Exchanges levels with another course, so one loaded elsewhere can be put in play
+		void swap( Course& other );
+
+		//Loads an edited version of the level, changing only the edited tiles and the fields around them
+		//Changed lists the edited tiles, replaced is set instead when the level had to be swapped in whole
+		bool reloadFromFile( const std::string& path, std::vector<int>& changed, bool& replaced );
+
+		//Switches collision backend, baking the fields if needed
+		bool setCollisionMode( CollisionMode mode );
+		CollisionMode getCollisionMode() const;
+
+		//Gets the distance fields for the wall and hole tiles
+		const DistanceField& getWallField() const;
+		const DistanceField& getHoleField() const;
+
+	private:
+		//Bakes the distance fields from the tile masks
+		bool bakeFields();
+
+		//The level tiles
+		TileMap mTiles;
+
+		//The collision backend
+		CollisionMode mCollisionMode;
+
+		//The baked distance fields
+		DistanceField mWallField;
+		DistanceField mHoleField;
+};
+
+//The simulated state of a ball
+struct BallState
+{
+	//The position of the ball's center
+	float posX, posY;
+
+	//The velocity of the ball
+	float velX, velY;
+
+	//Win check
+	bool touchingHole;
+};
+
+//The mouse press a stroke is dragged from
+struct StrokeInput
+{
+	int downX, downY;
+};
+
+//Where a moving circle first touches something
+struct SweepHit
+{
+	//Fraction of the movement done before the impact
+	float time;
+
+	//The surface normal at the impact point
+	float normalX, normalY;
+};
+
+//The outcome of a simulated shot
+struct ShotResult
+{
+	//The ball once it came to rest or dropped in
+	BallState ball;
+
+	//Steps taken until the ball stopped
+	int steps;
+};
+
+//Box collision detector
+bool checkCollision( const Circle& a, const Rect& b );
+
+//Finds when a circle moving by dx, dy first hits a box
+bool sweepCircle( const Circle& circle, float dx, float dy, const Rect& box, SweepHit& hit );
+
+//Finds when a circle moving by dx, dy first hits a wall tile or the level bounds
+bool sweepWalls( const Circle& circle, float dx, float dy, const Course& course, SweepHit& hit );
+
+//Checks if a circle moving by dx, dy passes over the hole
+bool sweepsHole( const Circle& circle, float dx, float dy, const Course& course );
+
+//Checks collision circle against set of tiles
+bool touchesWall( const Circle& circle, const Course& course );
+
+//Checks collision circle against hole tile
+bool touchesHole( const Circle& circle, const Course& course );
+
+//Calculates distance squared between two points
+float distanceSquared( float x1, float y1, float x2, float y2 );
+
+//Creates a ball at rest at the given position
+BallState makeBall( float x, float y );
+
+//Creates a ball at rest on the course's tee, centered above the bottom row
+BallState makeTeeBall( const Course& course );
+
+//Gets the ball's collision circle
+Circle getCollider( const BallState& ball );
+
+//Checks if the ball has stopped moving
+bool isAtRest( const BallState& ball );
+
+//Creates stroke input with the press at the origin
+StrokeInput makeStrokeInput();
+
+//Feeds a mouse press or release to a resting ball, true if a release hit it
+bool applyMouseButton( BallState& ball, StrokeInput& input, bool down, int x, int y );
+
+//Gets the velocity damping for a time step
+double getDamping( float timeStep );
+
+//Slows the ball by a step's damping and stops it once it's slow enough
+void dampBall( BallState& ball, float timeStep );
+
+//Moves the ball and checks collision against the course, gets the number of walls bounced off
+int step( BallState& ball, const Course& course, float timeStep = PHYSICS_TIMESTEP );
+
+//Hits the ball from start and steps until it rests or drops in
+ShotResult simulateShot( const Course& course, const BallState& start, float velX, float velY, int maxSteps = MAX_SHOT_STEPS );
+
+#endif
@@ -0,0 +1,132 @@
+//Levels and images loaded on a background thread while the current hole is played
+#include "preloader.h"
+#include <SDL_image.h>
+#include <stdio.h>
+
+Preloader::Preloader()
+{
+	//Initialize
+	mReady = false;
+	mMode = COLLISION_SWEPT;
+	mCourseLoaded = false;
+}
+
+Preloader::~Preloader()
+{
+	//Wait for the worker before freeing what it made
+	if( mThread.joinable() )
+	{
+		mThread.join();
+	}
+
+	freeImages();
+}
+
+bool Preloader::start( const std::string& mapPath, const std::vector<std::string>& imagePaths, CollisionMode mode )
+{
+	if( isStarted() )
+	{
+		printf( "Unable to preload %s while %s is still loading!\n", mapPath.c_str(), mMapPath.c_str() );
+		return false;
+	}
+
+	mMapPath = mapPath;
+	mImagePaths = imagePaths;
+	mMode = mode;
+	mCourseLoaded = false;
+	mReady = false;
+
+	mThread = std::thread( &Preloader::load, this );
+	return true;
+}
+
+bool Preloader::isStarted() const
+{
+	return mThread.joinable();
+}
+
+bool Preloader::isReady() const
+{
+	return mReady;
+}
+
+const std::string& Preloader::getMapPath() const
+{
+	return mMapPath;
+}
+
+bool Preloader::finish( Course& course, std::vector<PreloadedImage>& images )
+{
+	if( !isStarted() )
+	{
+		printf( "Unable to finish a preload that wasn't started!\n" );
+		return false;
+	}
+
+	//Blocks only if the worker isn't done yet
+	mThread.join();
+
+	//Hand over only a complete set, so a failed load changes nothing
+	bool success = mCourseLoaded;
+	for( size_t i = 0; i < mImages.size(); ++i )
+	{
+		if( mImages[ i ].surface == NULL )
+		{
+			success = false;
+		}
+	}
+
+	if( success )
+	{
+		course.swap( mCourse );
+		images.insert( images.end(), mImages.begin(), mImages.end() );
+		mImages.clear();
+	}
+
+	//The previous level is kept so the next load can reuse its storage
+	freeImages();
+	mReady = false;
+
+	return success;
+}
+
+void Preloader::load()
+{
+	//A retired level keeps its backend, don't bake fields that won't be used
+	if( mMode == COLLISION_SWEPT )
+	{
+		mCourse.setCollisionMode( COLLISION_SWEPT );
+	}
+
+	//Parse the map and bake its fields
+	mCourseLoaded = mCourse.loadFromFile( mMapPath );
+	if( mCourseLoaded && mCourse.getCollisionMode() != mMode && !mCourse.setCollisionMode( mMode ) )
+	{
+		printf( "Failed to bake distance fields for %s, using swept collision!\n", mMapPath.c_str() );
+	}
+
+	//Decode the images, uploading them is left to the render thread
+	for( size_t i = 0; i < mImagePaths.size(); ++i )
+	{
+		PreloadedImage image = { mImagePaths[ i ], IMG_Load( mImagePaths[ i ].c_str() ) };
+		if( image.surface == NULL )
+		{
+			printf( "Unable to load image %s! SDL_image Error: %s\n", mImagePaths[ i ].c_str(), IMG_GetError() );
+		}
+		mImages.push_back( image );
+	}
+
+	mReady = true;
+}
+
+void Preloader::freeImages()
+{
+	for( size_t i = 0; i < mImages.size(); ++i )
+	{
+		if( mImages[ i ].surface != NULL )
+		{
+			SDL_FreeSurface( mImages[ i ].surface );
+		}
+	}
+	mImages.clear();
+}
@@ -0,0 +1,72 @@
+//Levels and images loaded on a background thread while the current hole is played
+#ifndef PRELOADER_H
+#define PRELOADER_H
+
+#include <SDL.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "physics.h"
+
+//An image decoded off the render thread, still waiting for its upload
+struct PreloadedImage
+{
+	std::string path;
+	SDL_Surface* surface;
+};
+
+//Parses a map and decodes images on a worker thread, leaving only texture uploads to the render thread
+class Preloader
+{
+	public:
+		//Initializes variables
+		Preloader();
+
+		//Waits for the worker and deallocates anything not handed over
+		~Preloader();
+
+		//Starts loading a map and images in the background, false if a load is already running
+		bool start( const std::string& mapPath, const std::vector<std::string>& imagePaths, CollisionMode mode = COLLISION_SWEPT );
+
+		//Checks if a load was started and not handed over yet
+		bool isStarted() const;
+
+		//Checks if the worker is done, so finishing won't block
+		bool isReady() const;
+
+		//Gets the map being loaded
+		const std::string& getMapPath() const;
+
+		//Waits for the worker, swaps the loaded level into course and hands over the images
+		bool finish( Course& course, std::vector<PreloadedImage>& images );
+
+	private:
+		//Preloaders can't be copied since they own a thread
+		Preloader( const Preloader& );
+		Preloader& operator=( const Preloader& );
+
+		//Does the loading on the worker thread
+		void load();
+
+		//Deallocates decoded images
+		void freeImages();
+
+		//The worker thread
+		std::thread mThread;
+
+		//Set by the worker once everything is loaded
+		std::atomic<bool> mReady;
+
+		//What to load
+		std::string mMapPath;
+		std::vector<std::string> mImagePaths;
+		CollisionMode mMode;
+
+		//What was loaded, only touched by the worker until it's ready, then the level it replaced
+		Course mCourse;
+		bool mCourseLoaded;
+		std::vector<PreloadedImage> mImages;
+};
+
+#endif
@@ -0,0 +1,221 @@
+//Per phase frame timing with an on screen overlay
+#include "profiler.h"
+#include <string.h>
+#include <algorithm>
+
+//Overlay layout, 10 pixels per millisecond so a 60Hz frame fills the width
+static const int OVERLAY_WIDTH = 167;
+static const int OVERLAY_BAR_HEIGHT = 8;
+static const int OVERLAY_PADDING = 4;
+static const double OVERLAY_PIXELS_PER_MS = 10;
+
+//Overlay bar colors per phase, then the whole frame
+static const SDL_Color PHASE_COLORS[ TOTAL_PROFILE_PHASES + 1 ] =
+{
+	{ 0x80, 0x80, 0x80, 0xFF },
+	{ 0x40, 0xA0, 0xFF, 0xFF },
+	{ 0x40, 0xFF, 0x40, 0xFF },
+	{ 0xFF, 0xC0, 0x40, 0xFF },
+	{ 0xFF, 0x40, 0xFF, 0xFF },
+	{ 0xFF, 0xFF, 0xFF, 0xFF }
+};
+
+const char* getPhaseName( int phase )
+{
+	static const char* names[ TOTAL_PROFILE_PHASES + 1 ] = { "idle", "events", "physics", "render", "present", "frame" };
+	return phase >= 0 && phase <= TOTAL_PROFILE_PHASES ? names[ phase ] : "unknown";
+}
+
+FrameProfiler::FrameProfiler()
+{
+	//Initialize
+	mFrameStart = 0;
+	memset( mPhaseStart, 0, sizeof( mPhaseStart ) );
+	memset( mPhaseTicks, 0, sizeof( mPhaseTicks ) );
+	memset( mHistory, 0, sizeof( mHistory ) );
+	mHistoryCount = 0;
+	mHistoryNext = 0;
+	mFrequency = SDL_GetPerformanceFrequency();
+	mEpoch = SDL_GetPerformanceCounter();
+	mFrame = 0;
+	mDump = NULL;
+	mDumpTrace = false;
+	mDumpFirst = true;
+}
+
+FrameProfiler::~FrameProfiler()
+{
+	closeDump();
+}
+
+double FrameProfiler::toMilliseconds( Uint64 ticks ) const
+{
+	return mFrequency > 0 ? ticks * 1000.0 / mFrequency : 0;
+}
+
+void FrameProfiler::beginFrame()
+{
+	mFrameStart = SDL_GetPerformanceCounter();
+	memset( mPhaseTicks, 0, sizeof( mPhaseTicks ) );
+}
+
+void FrameProfiler::endFrame()
+{
+	Uint64 frameTicks = SDL_GetPerformanceCounter() - mFrameStart;
+
+	//Roll the phase totals into the history
+	for( int phase = 0; phase < TOTAL_PROFILE_PHASES; ++phase )
+	{
+		mHistory[ phase ][ mHistoryNext ] = toMilliseconds( mPhaseTicks[ phase ] );
+	}
+	mHistory[ TOTAL_PROFILE_PHASES ][ mHistoryNext ] = toMilliseconds( frameTicks );
+	mHistoryNext = ( mHistoryNext + 1 ) % PROFILE_HISTORY;
+	if( mHistoryCount < PROFILE_HISTORY )
+	{
+		++mHistoryCount;
+	}
+
+	//Trace events are written as phases end so CSV gets the frame row here
+	if( mDump != NULL && !mDumpTrace )
+	{
+		fprintf( mDump, "%d,%.3f", mFrame, toMilliseconds( mFrameStart - mEpoch ) );
+		for( int phase = 0; phase < TOTAL_PROFILE_PHASES; ++phase )
+		{
+			fprintf( mDump, ",%.3f", toMilliseconds( mPhaseTicks[ phase ] ) );
+		}
+		fprintf( mDump, ",%.3f\n", toMilliseconds( frameTicks ) );
+	}
+
+	++mFrame;
+}
+
+void FrameProfiler::beginPhase( ProfilePhase phase )
+{
+	mPhaseStart[ phase ] = SDL_GetPerformanceCounter();
+}
+
+void FrameProfiler::endPhase( ProfilePhase phase )
+{
+	Uint64 end = SDL_GetPerformanceCounter();
+	mPhaseTicks[ phase ] += end - mPhaseStart[ phase ];
+
+	//Chrome traces take complete events in microseconds
+	if( mDump != NULL && mDumpTrace )
+	{
+		fprintf( mDump, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"frame\":%d}}",
+			mDumpFirst ? "" : ",", getPhaseName( phase ), toMilliseconds( mPhaseStart[ phase ] - mEpoch ) * 1000,
+			toMilliseconds( end - mPhaseStart[ phase ] ) * 1000, mFrame );
+		mDumpFirst = false;
+	}
+}
+
+double FrameProfiler::getPercentile( int phase, double percentile ) const
+{
+	if( mHistoryCount == 0 )
+	{
+		return 0;
+	}
+
+	//Select the sample at the percentile's rank
+	std::copy( mHistory[ phase ], mHistory[ phase ] + mHistoryCount, mSorted );
+	int rank = std::min( (int)( percentile / 100 * mHistoryCount ), mHistoryCount - 1 );
+	std::nth_element( mSorted, mSorted + rank, mSorted + mHistoryCount );
+	return mSorted[ rank ];
+}
+
+SDL_Rect FrameProfiler::getOverlayBox( int x, int y ) const
+{
+	SDL_Rect box = { x, y, OVERLAY_WIDTH + OVERLAY_PADDING * 2, ( TOTAL_PROFILE_PHASES + 1 ) * ( OVERLAY_BAR_HEIGHT + OVERLAY_PADDING ) + OVERLAY_PADDING };
+	return box;
+}
+
+void FrameProfiler::renderOverlay( SDL_Renderer* renderer, int x, int y ) const
+{
+	//Darken the area behind the bars
+	SDL_Rect background = getOverlayBox( x, y );
+	SDL_SetRenderDrawBlendMode( renderer, SDL_BLENDMODE_BLEND );
+	SDL_SetRenderDrawColor( renderer, 0x00, 0x00, 0x00, 0xC0 );
+	SDL_RenderFillRect( renderer, &background );
+	SDL_SetRenderDrawBlendMode( renderer, SDL_BLENDMODE_NONE );
+
+	for( int phase = 0; phase <= TOTAL_PROFILE_PHASES; ++phase )
+	{
+		int barY = y + OVERLAY_PADDING + phase * ( OVERLAY_BAR_HEIGHT + OVERLAY_PADDING );
+		int median = std::min( (int)( getPercentile( phase, 50 ) * OVERLAY_PIXELS_PER_MS ), OVERLAY_WIDTH );
+		int worst = std::min( (int)( getPercentile( phase, 99 ) * OVERLAY_PIXELS_PER_MS ), OVERLAY_WIDTH - 1 );
+
+		//The median as a bar and the 99th percentile as a tick past it
+		const SDL_Color& color = PHASE_COLORS[ phase ];
+		SDL_Rect bar = { x + OVERLAY_PADDING, barY, median, OVERLAY_BAR_HEIGHT };
+		SDL_Rect tick = { x + OVERLAY_PADDING + worst, barY - 1, 2, OVERLAY_BAR_HEIGHT + 2 };
+		SDL_SetRenderDrawColor( renderer, color.r, color.g, color.b, color.a );
+		SDL_RenderFillRect( renderer, &bar );
+		SDL_RenderFillRect( renderer, &tick );
+	}
+}
+
+bool FrameProfiler::openDump( const std::string& path )
+{
+	closeDump();
+
+	mDump = fopen( path.c_str(), "w" );
+	if( mDump == NULL )
+	{
+		printf( "Unable to open profile dump %s!\n", path.c_str() );
+		return false;
+	}
+
+	//Pick the format from the extension
+	mDumpTrace = path.size() >= 5 && path.compare( path.size() - 5, 5, ".json" ) == 0;
+	mDumpFirst = true;
+	if( mDumpTrace )
+	{
+		fprintf( mDump, "{\"traceEvents\":[" );
+	}
+	else
+	{
+		fprintf( mDump, "frame,start_ms" );
+		for( int phase = 0; phase < TOTAL_PROFILE_PHASES; ++phase )
+		{
+			fprintf( mDump, ",%s_ms", getPhaseName( phase ) );
+		}
+		fprintf( mDump, ",frame_ms\n" );
+	}
+
+	return true;
+}
+
+void FrameProfiler::closeDump()
+{
+	if( mDump == NULL )
+	{
+		return;
+	}
+
+	if( mDumpTrace )
+	{
+		fprintf( mDump, "\n]}\n" );
+	}
+
+	fclose( mDump );
+	mDump = NULL;
+}
+
+void FrameProfiler::printSummary() const
+{
+	printf( "Phase      p50 ms   p99 ms\n" );
+	for( int phase = 0; phase <= TOTAL_PROFILE_PHASES; ++phase )
+	{
+		printf( "%-8s %8.3f %8.3f\n", getPhaseName( phase ), getPercentile( phase, 50 ), getPercentile( phase, 99 ) );
+	}
+}
+
+ProfileScope::ProfileScope( FrameProfiler& profiler, ProfilePhase phase ) : mProfiler( profiler ), mPhase( phase )
+{
+	mProfiler.beginPhase( mPhase );
+}
+
+ProfileScope::~ProfileScope()
+{
+	mProfiler.endPhase( mPhase );
+}
@@ -0,0 +1,109 @@
+//Per phase frame timing with an on screen overlay
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL.h>
+#include <stdio.h>
+#include <string>
+
+//The timed parts of a frame
+enum ProfilePhase
+{
+	PHASE_IDLE,
+	PHASE_EVENTS,
+	PHASE_PHYSICS,
+	PHASE_RENDER,
+	PHASE_PRESENT,
+	TOTAL_PROFILE_PHASES
+};
+
+//Frames the rolling statistics cover
+const int PROFILE_HISTORY = 240;
+
+//Gets the name a phase is reported under
+const char* getPhaseName( int phase );
+
+//Collects how long each phase of recent frames took
+class FrameProfiler
+{
+	public:
+		//Initializes variables
+		FrameProfiler();
+
+		//Closes the dump
+		~FrameProfiler();
+
+		//Marks the start and end of a frame
+		void beginFrame();
+		void endFrame();
+
+		//Marks the start and end of a phase, a phase may run more than once a frame
+		void beginPhase( ProfilePhase phase );
+		void endPhase( ProfilePhase phase );
+
+		//Gets a percentile of a phase over the recent frames in milliseconds, whole frames at TOTAL_PROFILE_PHASES
+		double getPercentile( int phase, double percentile ) const;
+
+		//Draws a bar per phase showing the median with a mark at the 99th percentile
+		void renderOverlay( SDL_Renderer* renderer, int x, int y ) const;
+
+		//Gets the screen area the overlay covers
+		SDL_Rect getOverlayBox( int x, int y ) const;
+
+		//Writes every frame to a Chrome trace when the path ends in .json and to CSV otherwise
+		bool openDump( const std::string& path );
+		void closeDump();
+
+		//Prints the median and 99th percentile of every phase
+		void printSummary() const;
+
+	private:
+		//Profilers can't be copied since they own the dump
+		FrameProfiler( const FrameProfiler& );
+		FrameProfiler& operator=( const FrameProfiler& );
+
+		//Converts performance counter ticks to milliseconds
+		double toMilliseconds( Uint64 ticks ) const;
+
+		//Counter values when the frame and each running phase started
+		Uint64 mFrameStart;
+		Uint64 mPhaseStart[ TOTAL_PROFILE_PHASES ];
+
+		//Time spent in each phase this frame
+		Uint64 mPhaseTicks[ TOTAL_PROFILE_PHASES ];
+
+		//Milliseconds per phase and for the whole frame, oldest overwritten first
+		double mHistory[ TOTAL_PROFILE_PHASES + 1 ][ PROFILE_HISTORY ];
+		int mHistoryCount;
+		int mHistoryNext;
+
+		//Scratch space for sorting percentiles
+		mutable double mSorted[ PROFILE_HISTORY ];
+
+		//The counter rate and when profiling started
+		Uint64 mFrequency;
+		Uint64 mEpoch;
+		int mFrame;
+
+		//The frame dump
+		FILE* mDump;
+		bool mDumpTrace;
+		bool mDumpFirst;
+};
+
+//Times a phase for as long as it's in scope
+class ProfileScope
+{
+	public:
+		//Starts the phase
+		ProfileScope( FrameProfiler& profiler, ProfilePhase phase );
+
+		//Ends the phase
+		~ProfileScope();
+
+	private:
+		FrameProfiler& mProfiler;
+		ProfilePhase mPhase;
+};
+
+#endif
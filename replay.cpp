@@ -0,0 +1,318 @@
+//Recorded rounds that play back through the headless physics
+#include "replay.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "mappedfile.h"
+
+//Appends a variable length unsigned value, seven bits per byte
+static void writeVarint( std::vector<uint8_t>& bytes, uint32_t value )
+{
+	while( value >= 0x80 )
+	{
+		bytes.push_back( ( value & 0x7F ) | 0x80 );
+		value >>= 7;
+	}
+	bytes.push_back( value );
+}
+
+//Appends a little endian 32 bit value
+static void writeUint32( std::vector<uint8_t>& bytes, uint32_t value )
+{
+	bytes.push_back( value & 0xFF );
+	bytes.push_back( ( value >> 8 ) & 0xFF );
+	bytes.push_back( ( value >> 16 ) & 0xFF );
+	bytes.push_back( ( value >> 24 ) & 0xFF );
+}
+
+//Appends a float's exact bits
+static void writeFloat( std::vector<uint8_t>& bytes, float value )
+{
+	uint32_t bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	writeUint32( bytes, bits );
+}
+
+//Reads a variable length unsigned value, false if it runs off the end
+static bool readVarint( const uint8_t*& cursor, const uint8_t* end, uint32_t& value )
+{
+	value = 0;
+	for( int shift = 0; shift < 35 && cursor < end; shift += 7 )
+	{
+		uint8_t byte = *cursor++;
+		value |= (uint32_t)( byte & 0x7F ) << shift;
+		if( !( byte & 0x80 ) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//Reads a little endian 32 bit value, false if it runs off the end
+static bool readUint32( const uint8_t*& cursor, const uint8_t* end, uint32_t& value )
+{
+	if( end - cursor < 4 )
+	{
+		return false;
+	}
+
+	value = (uint32_t)cursor[ 0 ] | ( (uint32_t)cursor[ 1 ] << 8 ) | ( (uint32_t)cursor[ 2 ] << 16 ) | ( (uint32_t)cursor[ 3 ] << 24 );
+	cursor += 4;
+	return true;
+}
+
+//Reads a float's exact bits
+static bool readFloat( const uint8_t*& cursor, const uint8_t* end, float& value )
+{
+	uint32_t bits;
+	if( !readUint32( cursor, end, bits ) )
+	{
+		return false;
+	}
+
+	memcpy( &value, &bits, sizeof( value ) );
+	return true;
+}
+
+//Maps signed coordinates onto small unsigned values
+static uint32_t zigzag( int value )
+{
+	return ( (uint32_t)value << 1 ) ^ (uint32_t)( value >> 31 );
+}
+
+static int unzigzag( uint32_t value )
+{
+	return (int)( value >> 1 ) ^ -(int)( value & 1 );
+}
+
+Replay::Replay()
+{
+	//Initialize
+	begin( "", PHYSICS_TICK_RATE, COLLISION_SWEPT );
+}
+
+void Replay::begin( const std::string& mapPath, int tickRate, CollisionMode collisionMode )
+{
+	mMapPath = mapPath;
+	mTickRate = tickRate;
+	mCollisionMode = collisionMode;
+	mEvents.clear();
+	mEvents.reserve( REPLAY_RESERVED_EVENTS );
+
+	mOutcome.ticks = 0;
+	mOutcome.strokes = 0;
+	mOutcome.ball = makeBall( 0, 0 );
+}
+
+void Replay::record( uint32_t tick, bool down, int x, int y )
+{
+	ReplayEvent event = { tick, down, x, y };
+	mEvents.push_back( event );
+}
+
+void Replay::finish( const ReplayOutcome& outcome )
+{
+	mOutcome = outcome;
+}
+
+bool Replay::saveToFile( const std::string& path ) const
+{
+	//Header, settings and the ending
+	std::vector<uint8_t> bytes( REPLAY_MAGIC, REPLAY_MAGIC + sizeof( REPLAY_MAGIC ) );
+	writeUint32( bytes, REPLAY_VERSION );
+	writeVarint( bytes, mTickRate );
+	writeVarint( bytes, mCollisionMode );
+	writeVarint( bytes, mMapPath.size() );
+	bytes.insert( bytes.end(), mMapPath.begin(), mMapPath.end() );
+	writeVarint( bytes, mOutcome.ticks );
+	writeVarint( bytes, mOutcome.strokes );
+	writeFloat( bytes, mOutcome.ball.posX );
+	writeFloat( bytes, mOutcome.ball.posY );
+	writeFloat( bytes, mOutcome.ball.velX );
+	writeFloat( bytes, mOutcome.ball.velY );
+	bytes.push_back( mOutcome.ball.touchingHole ? 1 : 0 );
+
+	//Events store the ticks since the last event and the button in the low coordinate bit
+	writeVarint( bytes, mEvents.size() );
+	uint32_t lastTick = 0;
+	for( size_t i = 0; i < mEvents.size(); ++i )
+	{
+		writeVarint( bytes, mEvents[ i ].tick - lastTick );
+		writeVarint( bytes, ( zigzag( mEvents[ i ].x ) << 1 ) | ( mEvents[ i ].down ? 1 : 0 ) );
+		writeVarint( bytes, zigzag( mEvents[ i ].y ) );
+		lastTick = mEvents[ i ].tick;
+	}
+
+	FILE* file = fopen( path.c_str(), "wb" );
+	if( file == NULL )
+	{
+		printf( "Unable to write replay %s!\n", path.c_str() );
+		return false;
+	}
+
+	bool written = fwrite( &bytes[ 0 ], 1, bytes.size(), file ) == bytes.size();
+	if( fclose( file ) != 0 || !written )
+	{
+		printf( "Unable to write replay %s!\n", path.c_str() );
+		return false;
+	}
+
+	return true;
+}
+
+bool Replay::loadFromFile( const std::string& path )
+{
+	MappedFile file;
+	if( !file.open( path ) )
+	{
+		printf( "Unable to load replay %s!\n", path.c_str() );
+		return false;
+	}
+
+	const uint8_t* cursor = file.getData();
+	const uint8_t* end = cursor + file.getSize();
+	if( file.getSize() < sizeof( REPLAY_MAGIC ) || memcmp( cursor, REPLAY_MAGIC, sizeof( REPLAY_MAGIC ) ) != 0 )
+	{
+		printf( "Error loading replay %s: Not a replay!\n", path.c_str() );
+		return false;
+	}
+	cursor += sizeof( REPLAY_MAGIC );
+
+	uint32_t version;
+	if( !readUint32( cursor, end, version ) || version != REPLAY_VERSION )
+	{
+		printf( "Error loading replay %s: Unsupported version!\n", path.c_str() );
+		return false;
+	}
+
+	//Settings and the ending
+	uint32_t tickRate, collisionMode, pathLength, strokes, eventCount;
+	bool read = readVarint( cursor, end, tickRate ) && readVarint( cursor, end, collisionMode ) && readVarint( cursor, end, pathLength );
+	if( !read || tickRate == 0 || collisionMode > COLLISION_FIELD || pathLength > (size_t)( end - cursor ) )
+	{
+		printf( "Error loading replay %s: Bad settings!\n", path.c_str() );
+		return false;
+	}
+
+	begin( std::string( (const char*)cursor, pathLength ), tickRate, (CollisionMode)collisionMode );
+	cursor += pathLength;
+
+	read = readVarint( cursor, end, mOutcome.ticks ) && readVarint( cursor, end, strokes ) &&
+		readFloat( cursor, end, mOutcome.ball.posX ) && readFloat( cursor, end, mOutcome.ball.posY ) &&
+		readFloat( cursor, end, mOutcome.ball.velX ) && readFloat( cursor, end, mOutcome.ball.velY ) && cursor < end;
+	if( !read )
+	{
+		printf( "Error loading replay %s: Truncated ending!\n", path.c_str() );
+		return false;
+	}
+	mOutcome.strokes = strokes;
+	mOutcome.ball.touchingHole = *cursor++ != 0;
+
+	//Every event takes at least three bytes
+	if( !readVarint( cursor, end, eventCount ) || eventCount > (size_t)( end - cursor ) / 3 )
+	{
+		printf( "Error loading replay %s: Truncated events!\n", path.c_str() );
+		return false;
+	}
+
+	mEvents.reserve( eventCount );
+	uint32_t tick = 0;
+	for( uint32_t i = 0; i < eventCount; ++i )
+	{
+		uint32_t delta, x, y;
+		if( !readVarint( cursor, end, delta ) || !readVarint( cursor, end, x ) || !readVarint( cursor, end, y ) )
+		{
+			printf( "Error loading replay %s: Truncated events!\n", path.c_str() );
+			return false;
+		}
+
+		tick += delta;
+		record( tick, x & 1, unzigzag( x >> 1 ), unzigzag( y ) );
+	}
+
+	return true;
+}
+
+const std::string& Replay::getMapPath() const
+{
+	return mMapPath;
+}
+
+int Replay::getTickRate() const
+{
+	return mTickRate;
+}
+
+CollisionMode Replay::getCollisionMode() const
+{
+	return mCollisionMode;
+}
+
+int Replay::getEventCount() const
+{
+	return mEvents.size();
+}
+
+const ReplayEvent& Replay::getEvent( int i ) const
+{
+	return mEvents[ i ];
+}
+
+const ReplayOutcome& Replay::getOutcome() const
+{
+	return mOutcome;
+}
+
+ReplayOutcome playReplay( const Replay& replay, const Course& course )
+{
+	ReplayOutcome outcome;
+	outcome.ticks = 0;
+	outcome.strokes = 0;
+	outcome.ball = makeTeeBall( course );
+
+	StrokeInput input = makeStrokeInput();
+	float timeStep = 1.f / replay.getTickRate();
+	uint32_t endTick = replay.getOutcome().ticks;
+	int next = 0;
+	for( ;; )
+	{
+		//Events are handled before the tick they were recorded on steps
+		while( next < replay.getEventCount() && replay.getEvent( next ).tick <= outcome.ticks )
+		{
+			const ReplayEvent& event = replay.getEvent( next++ );
+			if( applyMouseButton( outcome.ball, input, event.down, event.x, event.y ) )
+			{
+				++outcome.strokes;
+			}
+		}
+
+		//The game stops stepping once the ball drops in
+		if( outcome.ticks >= endTick || outcome.ball.touchingHole )
+		{
+			break;
+		}
+
+		//A resting ball doesn't change until the next event
+		if( isAtRest( outcome.ball ) )
+		{
+			outcome.ticks = next < replay.getEventCount() ? std::min( replay.getEvent( next ).tick, endTick ) : endTick;
+			continue;
+		}
+
+		step( outcome.ball, course, timeStep );
+		++outcome.ticks;
+	}
+
+	return outcome;
+}
+
+bool isSameOutcome( const ReplayOutcome& a, const ReplayOutcome& b )
+{
+	//Deterministic physics has to land on exactly the same bits
+	return a.ticks == b.ticks && a.strokes == b.strokes &&
+		memcmp( &a.ball.posX, &b.ball.posX, sizeof( float ) ) == 0 && memcmp( &a.ball.posY, &b.ball.posY, sizeof( float ) ) == 0 &&
+		memcmp( &a.ball.velX, &b.ball.velX, sizeof( float ) ) == 0 && memcmp( &a.ball.velY, &b.ball.velY, sizeof( float ) ) == 0 &&
+		a.ball.touchingHole == b.ball.touchingHole;
+}
@@ -0,0 +1,91 @@
+//Recorded rounds that play back through the headless physics
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "physics.h"
+
+//Replay file identification
+const char REPLAY_MAGIC[ 4 ] = { 'G', 'R', 'P', 'L' };
+const uint32_t REPLAY_VERSION = 1;
+
+//Events room is kept for up front, so recording doesn't allocate during play
+const int REPLAY_RESERVED_EVENTS = 4096;
+
+//A mouse press or release and the physics tick it was handled on
+struct ReplayEvent
+{
+	uint32_t tick;
+	bool down;
+	int x, y;
+};
+
+//Where a round stopped
+struct ReplayOutcome
+{
+	//Physics ticks simulated
+	uint32_t ticks;
+
+	//Strokes played
+	int strokes;
+
+	//The ball at the end
+	BallState ball;
+};
+
+//The input of one round and how it ended
+class Replay
+{
+	public:
+		//Initializes variables
+		Replay();
+
+		//Starts a new recording of a round on a map
+		void begin( const std::string& mapPath, int tickRate, CollisionMode collisionMode );
+
+		//Adds a mouse button event
+		void record( uint32_t tick, bool down, int x, int y );
+
+		//Stores how the round ended
+		void finish( const ReplayOutcome& outcome );
+
+		//Writes the replay as a compact binary stream
+		bool saveToFile( const std::string& path ) const;
+
+		//Reads a replay written by saveToFile
+		bool loadFromFile( const std::string& path );
+
+		//Gets what the round was played on
+		const std::string& getMapPath() const;
+		int getTickRate() const;
+		CollisionMode getCollisionMode() const;
+
+		//Gets the recorded events in tick order
+		int getEventCount() const;
+		const ReplayEvent& getEvent( int i ) const;
+
+		//Gets how the recorded round ended
+		const ReplayOutcome& getOutcome() const;
+
+	private:
+		//The map and physics settings of the round
+		std::string mMapPath;
+		int mTickRate;
+		CollisionMode mCollisionMode;
+
+		//The mouse button events
+		std::vector<ReplayEvent> mEvents;
+
+		//The recorded ending
+		ReplayOutcome mOutcome;
+};
+
+//Plays the recorded input back from the tee as fast as possible, skipping ticks while the ball rests
+ReplayOutcome playReplay( const Replay& replay, const Course& course );
+
+//Checks if two outcomes match exactly
+bool isSameOutcome( const ReplayOutcome& a, const ReplayOutcome& b );
+
+#endif
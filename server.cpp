@@ -0,0 +1,85 @@
+//Dedicated match server, built without SDL so it never opens a window
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include "netserver.h"
+
+//Seconds between status lines
+const double REPORT_INTERVAL = 10;
+
+//Gets the value following an option on the command line
+static const char* getOption( int argc, char* args[], const char* option )
+{
+	for( int i = 1; i + 1 < argc; ++i )
+	{
+		if( strcmp( args[ i ], option ) == 0 )
+		{
+			return args[ i + 1 ];
+		}
+	}
+
+	return NULL;
+}
+
+int main( int argc, char* args[] )
+{
+	if( argc < 2 || atoi( args[ 1 ] ) <= 0 || atoi( args[ 1 ] ) > 65535 )
+	{
+		printf( "Usage: %s <port> [<map>...] [--threads <n>] [--collision swept|field]\n", args[ 0 ] );
+		return 1;
+	}
+
+	//Courses follow the port up to the first option, match ids are spread across them
+	std::vector<std::string> mapPaths;
+	for( int i = 2; i < argc && strncmp( args[ i ], "--", 2 ) != 0; ++i )
+	{
+		mapPaths.push_back( args[ i ] );
+	}
+	if( mapPaths.empty() )
+	{
+		mapPaths.push_back( "./golf.map" );
+	}
+
+	const char* collision = getOption( argc, args, "--collision" );
+	CollisionMode mode = collision != NULL && strcmp( collision, "field" ) == 0 ? COLLISION_FIELD : COLLISION_SWEPT;
+	const char* threads = getOption( argc, args, "--threads" );
+
+	NetServer server;
+	if( !server.open( atoi( args[ 1 ] ), mapPaths, mode, threads != NULL ? atoi( threads ) : 0 ) )
+	{
+		return 1;
+	}
+	printf( "Hosting %d courses on port %s\n", (int)mapPaths.size(), args[ 1 ] );
+	fflush( stdout );
+
+	//Tick in real time, sleeping between updates
+	std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+	double sinceReport = 0;
+	double busy = 0;
+	for( ;; )
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>( now - last ).count();
+		last = now;
+
+		server.update( seconds );
+		busy += std::chrono::duration<double>( std::chrono::steady_clock::now() - now ).count();
+
+		//Say how busy the server is every so often
+		sinceReport += seconds;
+		if( sinceReport >= REPORT_INTERVAL )
+		{
+			printf( "Tick %u: %d matches, %d players, %.1f%% busy\n", server.getTick(), server.getMatchCount(), server.getPlayerCount(), busy / sinceReport * 100 );
+			fflush( stdout );
+			sinceReport = 0;
+			busy = 0;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,175 @@
+//Rounds of several holes played in one window
+#include "session.h"
+#include <stdio.h>
+#include <fstream>
+
+void Scorecard::addHole( const std::string& mapPath, int strokes )
+{
+	Hole hole = { mapPath, strokes };
+	mHoles.push_back( hole );
+}
+
+int Scorecard::getHoleCount() const
+{
+	return mHoles.size();
+}
+
+const std::string& Scorecard::getMapPath( int hole ) const
+{
+	return mHoles[ hole ].mapPath;
+}
+
+int Scorecard::getStrokes( int hole ) const
+{
+	return mHoles[ hole ].strokes;
+}
+
+int Scorecard::getTotalStrokes() const
+{
+	int total = 0;
+	for( size_t i = 0; i < mHoles.size(); ++i )
+	{
+		total += mHoles[ i ].strokes;
+	}
+
+	return total;
+}
+
+void Scorecard::print() const
+{
+	for( size_t i = 0; i < mHoles.size(); ++i )
+	{
+		printf( "Hole %d (%s): %d\n", (int)i + 1, mHoles[ i ].mapPath.c_str(), mHoles[ i ].strokes );
+	}
+	printf( "Total: %d\n", getTotalStrokes() );
+}
+
+void Scorecard::clear()
+{
+	mHoles.clear();
+}
+
+Session::Session()
+{
+	//Initialize
+	mHole = 0;
+	mMode = COLLISION_SWEPT;
+}
+
+bool Session::loadFromFile( const std::string& path )
+{
+	std::ifstream file( path.c_str() );
+	if( file.fail() )
+	{
+		printf( "Unable to load course file %s!\n", path.c_str() );
+		return false;
+	}
+
+	//Every non blank line names a hole's map
+	std::vector<std::string> holes;
+	std::string line;
+	while( std::getline( file, line ) )
+	{
+		size_t first = line.find_first_not_of( " \t\r" );
+		if( first == std::string::npos )
+		{
+			continue;
+		}
+		size_t last = line.find_last_not_of( " \t\r" );
+		holes.push_back( line.substr( first, last - first + 1 ) );
+	}
+
+	if( holes.empty() )
+	{
+		printf( "Error loading course: %s lists no holes!\n", path.c_str() );
+		return false;
+	}
+
+	setHoles( holes );
+	return true;
+}
+
+void Session::setHoles( const std::vector<std::string>& holes )
+{
+	mHoles = holes;
+	mHole = 0;
+	mScorecard.clear();
+}
+
+bool Session::begin( Course& course, CollisionMode mode )
+{
+	mMode = mode;
+	mHole = 0;
+	mScorecard.clear();
+
+	//Nothing is in play yet so the first hole is waited on
+	if( mHoles.empty() || !preloadLevel( mPreloader, mHoles[ 0 ], mMode ) || !installLevel( mPreloader, course ) )
+	{
+		return false;
+	}
+
+	preloadNext();
+	return true;
+}
+
+bool Session::nextHole( Course& course, int strokes )
+{
+	if( isOver() )
+	{
+		return false;
+	}
+
+	mScorecard.addHole( mHoles[ mHole ], strokes );
+	++mHole;
+	if( isOver() )
+	{
+		return false;
+	}
+
+	//The hole has been loading since the last one started, this only waits if it's still going
+	if( !mPreloader.isStarted() && !preloadLevel( mPreloader, mHoles[ mHole ], mMode ) )
+	{
+		return false;
+	}
+	if( !installLevel( mPreloader, course ) )
+	{
+		printf( "Failed to load hole %d!\n", mHole + 1 );
+		return false;
+	}
+
+	preloadNext();
+	return true;
+}
+
+bool Session::isOver() const
+{
+	return mHole >= (int)mHoles.size();
+}
+
+int Session::getHole() const
+{
+	return mHole;
+}
+
+int Session::getHoleCount() const
+{
+	return mHoles.size();
+}
+
+const std::string& Session::getMapPath() const
+{
+	return mHoles[ mHole ];
+}
+
+const Scorecard& Session::getScorecard() const
+{
+	return mScorecard;
+}
+
+void Session::preloadNext()
+{
+	if( mHole + 1 < (int)mHoles.size() )
+	{
+		preloadLevel( mPreloader, mHoles[ mHole + 1 ], mMode );
+	}
+}
@@ -0,0 +1,99 @@
+//Rounds of several holes played in one window
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <string>
+#include <vector>
+#include "game.h"
+#include "preloader.h"
+
+//The strokes taken on every hole played
+class Scorecard
+{
+	public:
+		//Records a finished hole
+		void addHole( const std::string& mapPath, int strokes );
+
+		//Gets the number of holes recorded
+		int getHoleCount() const;
+
+		//Gets a recorded hole
+		const std::string& getMapPath( int hole ) const;
+		int getStrokes( int hole ) const;
+
+		//Gets the strokes across all holes
+		int getTotalStrokes() const;
+
+		//Prints a line per hole and the total
+		void print() const;
+
+		//Forgets every hole
+		void clear();
+
+	private:
+		//A finished hole
+		struct Hole
+		{
+			std::string mapPath;
+			int strokes;
+		};
+
+		//The holes in play order
+		std::vector<Hole> mHoles;
+};
+
+//Plays a list of holes back to back, loading each next hole while the current one is played
+class Session
+{
+	public:
+		//Initializes variables
+		Session();
+
+		//Reads hole map paths from a course file, one per line
+		bool loadFromFile( const std::string& path );
+
+		//Plays a single hole
+		void setHoles( const std::vector<std::string>& holes );
+
+		//Loads the first hole into the course and starts on the next
+		bool begin( Course& course, CollisionMode mode = COLLISION_SWEPT );
+
+		//Scores the current hole and puts the next one in play, false once the round is over or on failure
+		bool nextHole( Course& course, int strokes );
+
+		//Checks if every hole has been scored
+		bool isOver() const;
+
+		//Gets the hole being played, counting from 0
+		int getHole() const;
+
+		//Gets the number of holes in the round
+		int getHoleCount() const;
+
+		//Gets the map of the hole being played
+		const std::string& getMapPath() const;
+
+		//Gets the scores so far
+		const Scorecard& getScorecard() const;
+
+	private:
+		//Starts loading the hole after the current one, if any
+		void preloadNext();
+
+		//The hole map paths in play order
+		std::vector<std::string> mHoles;
+
+		//The hole being played
+		int mHole;
+
+		//The collision backend every hole is loaded with
+		CollisionMode mMode;
+
+		//Loads the next hole in the background
+		Preloader mPreloader;
+
+		//The scores so far
+		Scorecard mScorecard;
+};
+
+#endif
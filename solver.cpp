@@ -0,0 +1,236 @@
+//Brute force shot solver
+#include "solver.h"
+#include "ballbatch.h"
+#include <algorithm>
+#include <cmath>
+
+static const float PI = 3.14159265f;
+
+//Where the shots from one start ended up
+struct StartOutcome
+{
+	//Shots that dropped in
+	int holed;
+
+	//Cells the other shots came to rest in, without repeats
+	std::vector<int> restCells;
+};
+
+SolverSettings getDefaultSolverSettings()
+{
+	SolverSettings settings;
+	settings.angles = 180;
+	settings.powers = 20;
+	settings.maxDrag = 600;
+	settings.maxStrokes = 10;
+	return settings;
+}
+
+//Gets the cell a ball rests in
+static int getCell( const TileMap& tiles, const BallState& ball )
+{
+	int column = std::min( std::max( (int)( ball.posX / TILE_WIDTH ), 0 ), tiles.getColumns() - 1 );
+	int row = std::min( std::max( (int)( ball.posY / TILE_HEIGHT ), 0 ), tiles.getRows() - 1 );
+	return row * tiles.getColumns() + column;
+}
+
+//Simulates every sampled shot from a start, all of them stepping together in the batch
+static void solveStart( const Course& course, const SolverSettings& settings, const BallState& start, BallBatch& batch, StartOutcome& outcome )
+{
+	const TileMap& tiles = course.getTiles();
+	outcome.holed = 0;
+	outcome.restCells.clear();
+
+	//Hit one ball per sampled shot
+	batch.clear();
+	for( int angle = 0; angle < settings.angles; ++angle )
+	{
+		float direction = angle * 2 * PI / settings.angles;
+		float dragX = cos( direction );
+		float dragY = sin( direction );
+
+		for( int power = 1; power <= settings.powers; ++power )
+		{
+			float drag = settings.maxDrag * power / settings.powers;
+			BallState ball = start;
+			ball.velX += dragX * drag * DRAG_VELOCITY;
+			ball.velY += dragY * drag * DRAG_VELOCITY;
+			batch.add( ball );
+		}
+	}
+
+	//Step until every ball stops or drops in
+	for( int steps = 0; steps < MAX_SHOT_STEPS && batch.getMovingCount() > 0; ++steps )
+	{
+		batch.step( course );
+	}
+
+	for( int i = 0; i < batch.getCount(); ++i )
+	{
+		BallState ball = batch.get( i );
+		if( ball.touchingHole )
+		{
+			++outcome.holed;
+		}
+		else
+		{
+			outcome.restCells.push_back( getCell( tiles, ball ) );
+		}
+	}
+
+	//Only which cells can be reached matters
+	std::sort( outcome.restCells.begin(), outcome.restCells.end() );
+	outcome.restCells.erase( std::unique( outcome.restCells.begin(), outcome.restCells.end() ), outcome.restCells.end() );
+}
+
+SolverResult solveCourse( const Course& course, const SolverSettings& settings, ThreadPool& pool )
+{
+	const TileMap& tiles = course.getTiles();
+	int totalTiles = tiles.getTotalTiles();
+	int shotsPerStart = settings.angles * settings.powers;
+
+	//Every cell center is a start, plus the tee at the end
+	std::vector<StartOutcome> outcomes( totalTiles + 1 );
+	int tee = totalTiles;
+
+	//Each worker reuses its own batch and only reads the shared course
+	std::vector<BallBatch> batches( pool.getThreadCount() );
+	pool.parallelFor( totalTiles + 1, [ & ]( int start, int worker )
+	{
+		if( start == tee )
+		{
+			solveStart( course, settings, makeTeeBall( course ), batches[ worker ], outcomes[ start ] );
+		}
+		else if( tiles.getType( start ) == TILE_GREEN )
+		{
+			Rect box = tiles.getBox( start );
+			solveStart( course, settings, makeBall( box.x + box.w / 2, box.y + box.h / 2 ), batches[ worker ], outcomes[ start ] );
+		}
+		else
+		{
+			//Balls never rest on walls and are done on the hole
+			outcomes[ start ].holed = 0;
+		}
+	} );
+
+	//Work out strokes from the cells a shot can reach, one stroke more each pass
+	std::vector<int> strokes( totalTiles + 1, -1 );
+	for( int i = 0; i <= totalTiles; ++i )
+	{
+		if( outcomes[ i ].holed > 0 )
+		{
+			strokes[ i ] = 1;
+		}
+	}
+	for( int stroke = 2; stroke <= settings.maxStrokes; ++stroke )
+	{
+		bool changed = false;
+		for( int i = 0; i <= totalTiles; ++i )
+		{
+			if( strokes[ i ] != -1 )
+			{
+				continue;
+			}
+
+			const std::vector<int>& restCells = outcomes[ i ].restCells;
+			for( size_t j = 0; j < restCells.size(); ++j )
+			{
+				if( strokes[ restCells[ j ] ] == stroke - 1 )
+				{
+					strokes[ i ] = stroke;
+					changed = true;
+					break;
+				}
+			}
+		}
+
+		if( !changed )
+		{
+			break;
+		}
+	}
+
+	//Collect the results
+	SolverResult result;
+	result.par = strokes[ tee ];
+	result.teeHoleChance = (float)outcomes[ tee ].holed / shotsPerStart;
+	result.shots = 0;
+	result.cells.resize( totalTiles );
+	for( int i = 0; i < totalTiles; ++i )
+	{
+		result.cells[ i ].strokes = strokes[ i ];
+		result.cells[ i ].holeChance = (float)outcomes[ i ].holed / shotsPerStart;
+
+		if( tiles.getType( i ) == TILE_GREEN )
+		{
+			result.shots += shotsPerStart;
+		}
+	}
+	result.shots += shotsPerStart;
+
+	return result;
+}
+
+ParResult solvePar( const Course& course, const SolverSettings& settings, ParSearch& search )
+{
+	const TileMap& tiles = course.getTiles();
+	int shotsPerStart = settings.angles * settings.powers;
+
+	ParResult result;
+	result.par = -1;
+	result.teeHoleChance = 0;
+	result.shots = 0;
+
+	//The outcome borrows the search's rest cells so nothing is allocated once the buffers have grown
+	StartOutcome outcome;
+	outcome.restCells.swap( search.restCells );
+
+	//Each pass solves every start first reached with one stroke more, the tee being the only one at first
+	search.strokes.assign( tiles.getTotalTiles(), -1 );
+	search.frontier.clear();
+	search.frontier.push_back( -1 );
+	for( int stroke = 1; stroke <= settings.maxStrokes && !search.frontier.empty(); ++stroke )
+	{
+		search.next.clear();
+		for( size_t i = 0; i < search.frontier.size(); ++i )
+		{
+			int start = search.frontier[ i ];
+			BallState ball = makeTeeBall( course );
+			if( start >= 0 )
+			{
+				Rect box = tiles.getBox( start );
+				ball = makeBall( box.x + box.w / 2, box.y + box.h / 2 );
+			}
+			solveStart( course, settings, ball, search.batch, outcome );
+			result.shots += shotsPerStart;
+
+			if( start < 0 )
+			{
+				result.teeHoleChance = (float)outcome.holed / shotsPerStart;
+			}
+
+			//The first start that drops in settles par, the rest of the pass can't beat it
+			if( outcome.holed > 0 )
+			{
+				result.par = stroke;
+				outcome.restCells.swap( search.restCells );
+				return result;
+			}
+
+			//Balls only rest on fairway, the same as the full solve
+			for( size_t j = 0; j < outcome.restCells.size(); ++j )
+			{
+				int cell = outcome.restCells[ j ];
+				if( tiles.getType( cell ) == TILE_GREEN && search.strokes[ cell ] == -1 )
+				{
+					search.strokes[ cell ] = stroke;
+					search.next.push_back( cell );
+				}
+			}
+		}
+		search.frontier.swap( search.next );
+	}
+
+	outcome.restCells.swap( search.restCells );
+	return result;
+}
@@ -0,0 +1,89 @@
+//Brute force shot solver, usable without SDL
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <vector>
+#include "physics.h"
+#include "threadpool.h"
+#include "ballbatch.h"
+
+//How the shot space is sampled
+struct SolverSettings
+{
+	//Drag directions tried from every start
+	int angles;
+
+	//Drag lengths tried in every direction, up to maxDrag pixels
+	int powers;
+	float maxDrag;
+
+	//Most strokes searched for
+	int maxStrokes;
+};
+
+//What the solver found for one grid cell
+struct CellOutcome
+{
+	//Fewest strokes to sink the ball from the cell center, or -1 if it can't be done
+	int strokes;
+
+	//Fraction of sampled shots from the cell center that drop in
+	float holeChance;
+};
+
+//What the solver found for a course
+struct SolverResult
+{
+	//Fewest strokes from the tee, or -1 if the hole can't be reached
+	int par;
+
+	//Fraction of sampled tee shots that drop in
+	float teeHoleChance;
+
+	//One outcome per tile, row major
+	std::vector<CellOutcome> cells;
+
+	//Shots simulated in total
+	long long shots;
+};
+
+//What the solver found searching out from the tee alone
+struct ParResult
+{
+	//Fewest strokes from the tee, or -1 if the hole can't be reached within the most strokes searched for
+	int par;
+
+	//Fraction of sampled tee shots that drop in
+	float teeHoleChance;
+
+	//Shots simulated in total
+	long long shots;
+};
+
+//Buffers a par search reuses from course to course, one per thread
+struct ParSearch
+{
+	//The sampled shots from the start being solved
+	BallBatch batch;
+
+	//Strokes to reach each tile from the tee, -1 until a shot rests there
+	std::vector<int> strokes;
+
+	//The starts one stroke out, and the ones after them
+	std::vector<int> frontier;
+	std::vector<int> next;
+
+	//Where one start's shots came to rest
+	std::vector<int> restCells;
+};
+
+//Gets the default sampling of the shot space
+SolverSettings getDefaultSolverSettings();
+
+//Simulates every sampled shot from the tee and every open cell center across the pool
+SolverResult solveCourse( const Course& course, const SolverSettings& settings, ThreadPool& pool );
+
+//Works out par on the calling thread, only simulating from the cells the tee's shots can reach in fewer strokes
+ParResult solvePar( const Course& course, const SolverSettings& settings, ParSearch& search );
+
+#endif
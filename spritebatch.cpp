@@ -0,0 +1,193 @@
+//Sprites collected over a frame and drawn in as few render calls as possible
+#include "spritebatch.h"
+#include <stdio.h>
+#include <cmath>
+#include <algorithm>
+
+//Degrees to radians for turned quads
+static const double DEGREES_TO_RADIANS = 3.14159265358979 / 180.0;
+
+SpriteBatch::SpriteBatch()
+{
+	//Initialize
+	mGeometry = true;
+	mCalls = 0;
+	mQuads.reserve( SPRITE_BATCH_RESERVED );
+	mTextures.reserve( 8 );
+	mVertices.reserve( SPRITE_BATCH_RESERVED * 4 );
+	mIndices.reserve( SPRITE_BATCH_RESERVED * 6 );
+}
+
+void SpriteBatch::draw( SDL_Texture* texture, const SDL_Rect& source, const SDL_Rect& destination )
+{
+	draw( texture, source, destination, 0.0, SDL_FLIP_NONE );
+}
+
+void SpriteBatch::draw( SDL_Texture* texture, const SDL_Rect& source, const SDL_Rect& destination, double angle, SDL_RendererFlip flip )
+{
+	if( texture == NULL )
+	{
+		return;
+	}
+
+	//Frames only use a handful of textures so a scan finds this one quickly
+	int index = 0;
+	while( index < (int)mTextures.size() && mTextures[ index ] != texture )
+	{
+		++index;
+	}
+	if( index == (int)mTextures.size() )
+	{
+		mTextures.push_back( texture );
+	}
+
+	Quad quad = { index, source, destination, angle, flip };
+	mQuads.push_back( quad );
+}
+
+void SpriteBatch::flush( SDL_Renderer* renderer )
+{
+	mCalls = 0;
+
+	//Each texture's quads go in one call, keeping the order they were queued in
+	for( int i = 0; i < (int)mTextures.size(); ++i )
+	{
+		if( !mGeometry || !submitGeometry( renderer, i ) )
+		{
+			submitCopies( renderer, i );
+		}
+	}
+
+	clear();
+}
+
+void SpriteBatch::clear()
+{
+	mQuads.clear();
+	mTextures.clear();
+}
+
+int SpriteBatch::getQuadCount() const
+{
+	return mQuads.size();
+}
+
+int SpriteBatch::getCallCount() const
+{
+	return mCalls;
+}
+
+bool SpriteBatch::submitGeometry( SDL_Renderer* renderer, int texture )
+{
+	#if SDL_VERSION_ATLEAST( 2, 0, 18 )
+	//Texture coordinates are fractions of the whole texture
+	int textureWidth = 0, textureHeight = 0;
+	if( SDL_QueryTexture( mTextures[ texture ], NULL, NULL, &textureWidth, &textureHeight ) < 0 || textureWidth <= 0 || textureHeight <= 0 )
+	{
+		return false;
+	}
+	float scaleU = 1.f / textureWidth;
+	float scaleV = 1.f / textureHeight;
+
+	mVertices.clear();
+	mIndices.clear();
+	for( size_t i = 0; i < mQuads.size(); ++i )
+	{
+		const Quad& quad = mQuads[ i ];
+		if( quad.texture != texture )
+		{
+			continue;
+		}
+
+		//Flips swap which edge of the source each corner samples
+		float u0 = quad.source.x * scaleU;
+		float v0 = quad.source.y * scaleV;
+		float u1 = ( quad.source.x + quad.source.w ) * scaleU;
+		float v1 = ( quad.source.y + quad.source.h ) * scaleV;
+		if( quad.flip & SDL_FLIP_HORIZONTAL )
+		{
+			std::swap( u0, u1 );
+		}
+		if( quad.flip & SDL_FLIP_VERTICAL )
+		{
+			std::swap( v0, v1 );
+		}
+
+		//Corners relative to the center, clockwise from the top left
+		float halfW = quad.destination.w * 0.5f;
+		float halfH = quad.destination.h * 0.5f;
+		float centerX = quad.destination.x + halfW;
+		float centerY = quad.destination.y + halfH;
+		float cornersX[ 4 ] = { -halfW, halfW, halfW, -halfW };
+		float cornersY[ 4 ] = { -halfH, -halfH, halfH, halfH };
+		float cornersU[ 4 ] = { u0, u1, u1, u0 };
+		float cornersV[ 4 ] = { v0, v0, v1, v1 };
+
+		//Unturned quads land on the same pixels a copy would
+		float cosine = 1, sine = 0;
+		if( quad.angle != 0.0 )
+		{
+			double radians = quad.angle * DEGREES_TO_RADIANS;
+			cosine = (float)cos( radians );
+			sine = (float)sin( radians );
+		}
+
+		int first = mVertices.size();
+		for( int c = 0; c < 4; ++c )
+		{
+			SDL_Vertex vertex;
+			vertex.position.x = centerX + cornersX[ c ] * cosine - cornersY[ c ] * sine;
+			vertex.position.y = centerY + cornersX[ c ] * sine + cornersY[ c ] * cosine;
+			vertex.color.r = 0xFF;
+			vertex.color.g = 0xFF;
+			vertex.color.b = 0xFF;
+			vertex.color.a = 0xFF;
+			vertex.tex_coord.x = cornersU[ c ];
+			vertex.tex_coord.y = cornersV[ c ];
+			mVertices.push_back( vertex );
+		}
+
+		//Two triangles per quad
+		int indices[ 6 ] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+		mIndices.insert( mIndices.end(), indices, indices + 6 );
+	}
+
+	//Renderers without geometry support fail here, after which every frame uses copies
+	if( SDL_RenderGeometry( renderer, mTextures[ texture ], &mVertices[ 0 ], mVertices.size(), &mIndices[ 0 ], mIndices.size() ) < 0 )
+	{
+		printf( "Unable to render sprite batch, falling back to copies! SDL Error: %s\n", SDL_GetError() );
+		mGeometry = false;
+		return false;
+	}
+
+	++mCalls;
+	return true;
+	#else
+	//Older SDL has no geometry call
+	mGeometry = false;
+	return false;
+	#endif
+}
+
+void SpriteBatch::submitCopies( SDL_Renderer* renderer, int texture )
+{
+	for( size_t i = 0; i < mQuads.size(); ++i )
+	{
+		const Quad& quad = mQuads[ i ];
+		if( quad.texture != texture )
+		{
+			continue;
+		}
+
+		//Plain copies for sprites that aren't turned
+		if( quad.angle == 0.0 && quad.flip == SDL_FLIP_NONE )
+		{
+			SDL_RenderCopy( renderer, mTextures[ texture ], &quad.source, &quad.destination );
+		}
+		else
+		{
+			SDL_RenderCopyEx( renderer, mTextures[ texture ], &quad.source, &quad.destination, quad.angle, NULL, quad.flip );
+		}
+		++mCalls;
+	}
+}
@@ -0,0 +1,75 @@
+//Sprites collected over a frame and drawn in as few render calls as possible
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <SDL.h>
+#include <vector>
+
+//Quads the batch makes room for up front so frames don't allocate
+const int SPRITE_BATCH_RESERVED = 1024;
+
+//Queues textured quads and draws each texture's quads with one geometry call
+class SpriteBatch
+{
+	public:
+		//Initializes variables
+		SpriteBatch();
+
+		//Queues part of a texture to be drawn to a rectangle, like SDL_RenderCopy
+		void draw( SDL_Texture* texture, const SDL_Rect& source, const SDL_Rect& destination );
+
+		//Queues a quad turned clockwise by degrees about its center or flipped, like SDL_RenderCopyEx
+		void draw( SDL_Texture* texture, const SDL_Rect& source, const SDL_Rect& destination, double angle, SDL_RendererFlip flip );
+
+		//Draws everything queued, one texture at a time in the order each was first queued
+		void flush( SDL_Renderer* renderer );
+
+		//Drops everything queued without drawing it
+		void clear();
+
+		//Gets the quads waiting to be drawn
+		int getQuadCount() const;
+
+		//Gets the render calls the last flush took
+		int getCallCount() const;
+
+	private:
+		//A queued sprite
+		struct Quad
+		{
+			//The texture index in draw order
+			int texture;
+
+			//Where the sprite comes from and goes
+			SDL_Rect source;
+			SDL_Rect destination;
+
+			//How the sprite is turned
+			double angle;
+			SDL_RendererFlip flip;
+		};
+
+		//Draws one texture's quads as triangles, false if the renderer can't
+		bool submitGeometry( SDL_Renderer* renderer, int texture );
+
+		//Draws one texture's quads with a copy each
+		void submitCopies( SDL_Renderer* renderer, int texture );
+
+		//The sprites in the order they were queued
+		std::vector<Quad> mQuads;
+
+		//The textures in the order they were first queued
+		std::vector<SDL_Texture*> mTextures;
+
+		//The triangles one texture is drawn with
+		std::vector<SDL_Vertex> mVertices;
+		std::vector<int> mIndices;
+
+		//Cleared once the renderer fails to draw geometry
+		bool mGeometry;
+
+		//Render calls the last flush took
+		int mCalls;
+};
+
+#endif
@@ -0,0 +1,119 @@
+//The bounce loop and sweep helpers every course steps balls through, usable without SDL
+#ifndef STEPPING_H
+#define STEPPING_H
+
+#include "physics.h"
+
+//Keeps the earlier of two hits
+inline void takeEarlier( SweepHit& best, bool& found, float time, float normalX, float normalY )
+{
+	if( !found || time < best.time )
+	{
+		best.time = time < 0 ? 0 : time;
+		best.normalX = normalX;
+		best.normalY = normalY;
+		found = true;
+	}
+}
+
+//Keeps the earliest of the level edges a circle moving by dx, dy hits, the level bounds keep the whole ball inside
+inline void sweepBounds( const Circle& circle, float dx, float dy, float width, float height, SweepHit& hit, bool& found )
+{
+	float left = circle.r, right = width - circle.r;
+	float top = circle.r, bottom = height - circle.r;
+	if( dx < 0 && circle.x + dx < left ) takeEarlier( hit, found, ( left - circle.x ) / dx, 1, 0 );
+	if( dx > 0 && circle.x + dx > right ) takeEarlier( hit, found, ( right - circle.x ) / dx, -1, 0 );
+	if( dy < 0 && circle.y + dy < top ) takeEarlier( hit, found, ( top - circle.y ) / dy, 0, 1 );
+	if( dy > 0 && circle.y + dy > bottom ) takeEarlier( hit, found, ( bottom - circle.y ) / dy, 0, -1 );
+}
+
+//Gives a loaded course the sweep interface FixedCourse has, whichever collision backend it uses
+class LoadedCourse
+{
+	public:
+		//Wraps a course that has to outlive this
+		explicit LoadedCourse( const Course& course ) : mCourse( course ) {}
+
+		//Finds the first wall or edge a circle moving by dx, dy hits
+		bool sweepWalls( const Circle& circle, float dx, float dy, SweepHit& hit ) const { return ::sweepWalls( circle, dx, dy, mCourse, hit ); }
+
+		//Checks if a circle moving by dx, dy starts over or crosses into the hole
+		bool sweepsHole( const Circle& circle, float dx, float dy ) const { return ::sweepsHole( circle, dx, dy, mCourse ); }
+
+	private:
+		//The wrapped course
+		const Course& mCourse;
+};
+
+//Moves the ball through anything with sweepWalls and sweepsHole, gets the number of walls bounced off
+template<class Sweeper>
+int stepThrough( BallState& ball, const Sweeper& course, float timeStep )
+{
+	//Move through the whole step, bouncing off whatever is hit first
+	float timeLeft = timeStep;
+	int bounces = 0;
+	for( int bounce = 0; bounce <= MAX_STEP_BOUNCES && timeLeft > 0; ++bounce )
+	{
+		Circle circle = { ball.posX, ball.posY, BALL_WIDTH / 2 };
+		float dx = ball.velX * timeLeft;
+		float dy = ball.velY * timeLeft;
+
+		//Stop the movement at the first impact
+		SweepHit hit = { 1, 0, 0 };
+		bool hitWall = course.sweepWalls( circle, dx, dy, hit );
+		float travelled = hitWall ? hit.time : 1;
+
+		if( course.sweepsHole( circle, dx * travelled, dy * travelled ) )
+		{
+			ball.touchingHole = true;
+		}
+
+		ball.posX += dx * travelled;
+		ball.posY += dy * travelled;
+
+		if( !hitWall )
+		{
+			break;
+		}
+
+		//Reflect the velocity about the surface normal
+		float along = ball.velX * hit.normalX + ball.velY * hit.normalY;
+		ball.velX -= 2 * along * hit.normalX;
+		ball.velY -= 2 * along * hit.normalY;
+
+		timeLeft *= 1 - travelled;
+		++bounces;
+	}
+
+	dampBall( ball, timeStep );
+	return bounces;
+}
+
+//Hits the ball from start and steps it through anything with sweepWalls and sweepsHole until it rests or drops in
+template<class Sweeper>
+ShotResult simulateShotThrough( const Sweeper& course, const BallState& start, float velX, float velY, int maxSteps )
+{
+	ShotResult result;
+	result.ball = start;
+	result.steps = 0;
+
+	//Hit the ball
+	result.ball.velX += velX;
+	result.ball.velY += velY;
+
+	//Step until the ball stops or drops in
+	while( result.steps < maxSteps )
+	{
+		stepThrough( result.ball, course, PHYSICS_TIMESTEP );
+		++result.steps;
+
+		if( result.ball.touchingHole || isAtRest( result.ball ) )
+		{
+			break;
+		}
+	}
+
+	return result;
+}
+
+#endif
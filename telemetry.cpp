@@ -0,0 +1,311 @@
+//Low overhead counters and histograms exported in the background
+#include "telemetry.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <chrono>
+
+//Hands every instance its own id so stale shard caches are noticed
+static std::atomic<uint32_t> gNextTelemetryId( 1 );
+
+//Exported names, the counters get _total appended
+static const char* COUNTER_NAMES[ TOTAL_TELEMETRY_COUNTERS ] = { "golf_frames", "golf_shots", "golf_wall_bounces", "golf_holes" };
+static const char* COUNTER_HELP[ TOTAL_TELEMETRY_COUNTERS ] = { "Frames run.", "Strokes played.", "Walls bounced off by the ball.", "Holes finished." };
+static const char* HISTOGRAM_NAMES[ TOTAL_TELEMETRY_HISTOGRAMS ] = { "golf_frame_time_microseconds", "golf_settle_time_milliseconds", "golf_hole_strokes" };
+static const char* HISTOGRAM_HELP[ TOTAL_TELEMETRY_HISTOGRAMS ] = { "Time between frames.", "Time from a stroke until the ball rests or drops in.", "Strokes taken to finish a hole." };
+
+//Gets the bucket a value falls in
+static int getBucket( uint64_t value )
+{
+	if( value <= 1 )
+	{
+		return 0;
+	}
+
+	int bits = 64 - __builtin_clzll( value - 1 );
+	return bits < TELEMETRY_BUCKETS - 1 ? bits : TELEMETRY_BUCKETS - 1;
+}
+
+//Appends formatted text to an export, false once it no longer fits
+static bool appendText( char* buffer, int& length, const char* format, ... )
+{
+	va_list arguments;
+	va_start( arguments, format );
+	int written = vsnprintf( buffer + length, TELEMETRY_BUFFER - length, format, arguments );
+	va_end( arguments );
+
+	if( written < 0 || written >= TELEMETRY_BUFFER - length )
+	{
+		return false;
+	}
+	length += written;
+	return true;
+}
+
+const char* getCounterName( int counter )
+{
+	return COUNTER_NAMES[ counter ];
+}
+
+const char* getHistogramName( int histogram )
+{
+	return HISTOGRAM_NAMES[ histogram ];
+}
+
+uint64_t getBucketBound( int bucket )
+{
+	return (uint64_t)1 << bucket;
+}
+
+Telemetry::Telemetry() : mEnabled( false ), mShardCount( 0 )
+{
+	//Initialize
+	mId = gNextTelemetryId.fetch_add( 1 );
+	for( int i = 0; i < TELEMETRY_MAX_THREADS; ++i )
+	{
+		mShards[ i ] = NULL;
+	}
+	mInterval = TELEMETRY_DEFAULT_INTERVAL_MS;
+	mQuit = false;
+}
+
+Telemetry::~Telemetry()
+{
+	//Deallocate
+	stop();
+	for( int i = 0; i < TELEMETRY_MAX_THREADS; ++i )
+	{
+		delete mShards[ i ];
+	}
+}
+
+bool Telemetry::start( const std::string& path, int intervalMs )
+{
+	//Get rid of preexisting export
+	stop();
+
+	//The totals are written next to the file and moved over it, so a scrape never sees half an export
+	mPath = path;
+	mTempPath = path + ".tmp";
+	mInterval = intervalMs > 0 ? intervalMs : TELEMETRY_DEFAULT_INTERVAL_MS;
+
+	//Check the file can be written before anything else relies on it
+	mEnabled.store( true );
+	if( !flush() )
+	{
+		mEnabled.store( false );
+		return false;
+	}
+
+	//The calling thread gets its shard now rather than on its first record
+	getShard();
+
+	mQuit = false;
+	mThread = std::thread( &Telemetry::flushLoop, this );
+	return true;
+}
+
+void Telemetry::stop()
+{
+	if( !mThread.joinable() )
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard( mLock );
+		mQuit = true;
+	}
+	mWake.notify_one();
+	mThread.join();
+
+	//Whatever came in since the last interval still gets out
+	flush();
+	mEnabled.store( false );
+}
+
+bool Telemetry::isEnabled() const
+{
+	return mEnabled.load( std::memory_order_relaxed );
+}
+
+void Telemetry::count( TelemetryCounter counter, uint64_t amount )
+{
+	if( !mEnabled.load( std::memory_order_relaxed ) )
+	{
+		return;
+	}
+
+	getShard()->counters[ counter ].fetch_add( amount, std::memory_order_relaxed );
+}
+
+void Telemetry::observe( TelemetryHistogram histogram, uint64_t value )
+{
+	if( !mEnabled.load( std::memory_order_relaxed ) )
+	{
+		return;
+	}
+
+	Shard* shard = getShard();
+	shard->buckets[ histogram ][ getBucket( value ) ].fetch_add( 1, std::memory_order_relaxed );
+	shard->sums[ histogram ].fetch_add( value, std::memory_order_relaxed );
+}
+
+uint64_t Telemetry::getCount( TelemetryCounter counter ) const
+{
+	uint64_t total = 0;
+	int shards = mShardCount.load( std::memory_order_acquire );
+	for( int i = 0; i < shards; ++i )
+	{
+		total += mShards[ i ]->counters[ counter ].load( std::memory_order_relaxed );
+	}
+	return total;
+}
+
+Telemetry::Shard* Telemetry::getShard()
+{
+	//Each thread remembers its shard, so only its first record takes the lock
+	static thread_local uint32_t cachedId = 0;
+	static thread_local Shard* cachedShard = NULL;
+	if( cachedId == mId )
+	{
+		return cachedShard;
+	}
+
+	std::lock_guard<std::mutex> guard( mShardLock );
+	int shards = mShardCount.load( std::memory_order_relaxed );
+	if( shards < TELEMETRY_MAX_THREADS )
+	{
+		//Zeroed before it's published to the export
+		Shard* shard = new Shard;
+		for( int i = 0; i < TOTAL_TELEMETRY_COUNTERS; ++i )
+		{
+			shard->counters[ i ].store( 0, std::memory_order_relaxed );
+		}
+		for( int i = 0; i < TOTAL_TELEMETRY_HISTOGRAMS; ++i )
+		{
+			for( int bucket = 0; bucket < TELEMETRY_BUCKETS; ++bucket )
+			{
+				shard->buckets[ i ][ bucket ].store( 0, std::memory_order_relaxed );
+			}
+			shard->sums[ i ].store( 0, std::memory_order_relaxed );
+		}
+		mShards[ shards ] = shard;
+		mShardCount.store( shards + 1, std::memory_order_release );
+		cachedShard = shard;
+	}
+	else
+	{
+		//Adds are atomic so a shared shard is only slower, never wrong
+		cachedShard = mShards[ TELEMETRY_MAX_THREADS - 1 ];
+	}
+
+	cachedId = mId;
+	return cachedShard;
+}
+
+bool Telemetry::flush()
+{
+	if( !mEnabled.load() )
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard( mFlushLock );
+
+	//Sum the shards, which keep counting meanwhile so the totals are a moment's rather than exact
+	uint64_t counters[ TOTAL_TELEMETRY_COUNTERS ] = { 0 };
+	uint64_t buckets[ TOTAL_TELEMETRY_HISTOGRAMS ][ TELEMETRY_BUCKETS ] = { { 0 } };
+	uint64_t sums[ TOTAL_TELEMETRY_HISTOGRAMS ] = { 0 };
+	int shards = mShardCount.load( std::memory_order_acquire );
+	for( int i = 0; i < shards; ++i )
+	{
+		const Shard* shard = mShards[ i ];
+		for( int counter = 0; counter < TOTAL_TELEMETRY_COUNTERS; ++counter )
+		{
+			counters[ counter ] += shard->counters[ counter ].load( std::memory_order_relaxed );
+		}
+		for( int histogram = 0; histogram < TOTAL_TELEMETRY_HISTOGRAMS; ++histogram )
+		{
+			for( int bucket = 0; bucket < TELEMETRY_BUCKETS; ++bucket )
+			{
+				buckets[ histogram ][ bucket ] += shard->buckets[ histogram ][ bucket ].load( std::memory_order_relaxed );
+			}
+			sums[ histogram ] += shard->sums[ histogram ].load( std::memory_order_relaxed );
+		}
+	}
+
+	//Counters are running totals, histograms list how many samples fell at or under each bound
+	int length = 0;
+	bool fits = true;
+	for( int counter = 0; counter < TOTAL_TELEMETRY_COUNTERS; ++counter )
+	{
+		fits = fits && appendText( mBuffer, length, "# TYPE %s counter\n# HELP %s %s\n%s_total %llu\n",
+			COUNTER_NAMES[ counter ], COUNTER_NAMES[ counter ], COUNTER_HELP[ counter ], COUNTER_NAMES[ counter ], (unsigned long long)counters[ counter ] );
+	}
+	for( int histogram = 0; histogram < TOTAL_TELEMETRY_HISTOGRAMS; ++histogram )
+	{
+		const char* name = HISTOGRAM_NAMES[ histogram ];
+		fits = fits && appendText( mBuffer, length, "# TYPE %s histogram\n# HELP %s %s\n", name, name, HISTOGRAM_HELP[ histogram ] );
+
+		uint64_t samples = 0;
+		for( int bucket = 0; bucket < TELEMETRY_BUCKETS; ++bucket )
+		{
+			samples += buckets[ histogram ][ bucket ];
+			if( bucket < TELEMETRY_BUCKETS - 1 )
+			{
+				fits = fits && appendText( mBuffer, length, "%s_bucket{le=\"%llu\"} %llu\n", name, (unsigned long long)getBucketBound( bucket ), (unsigned long long)samples );
+			}
+		}
+		fits = fits && appendText( mBuffer, length, "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %llu\n%s_count %llu\n",
+			name, (unsigned long long)samples, name, (unsigned long long)sums[ histogram ], name, (unsigned long long)samples );
+	}
+	fits = fits && appendText( mBuffer, length, "# EOF\n" );
+	if( !fits )
+	{
+		printf( "Telemetry export doesn't fit in %d bytes!\n", TELEMETRY_BUFFER );
+		return false;
+	}
+
+	FILE* file = fopen( mTempPath.c_str(), "wb" );
+	if( file == NULL )
+	{
+		printf( "Unable to write telemetry to %s!\n", mTempPath.c_str() );
+		return false;
+	}
+	bool written = fwrite( mBuffer, 1, length, file ) == (size_t)length;
+	if( fclose( file ) != 0 || !written )
+	{
+		printf( "Unable to write telemetry to %s!\n", mTempPath.c_str() );
+		return false;
+	}
+
+	//Windows won't rename over an existing file
+	#if defined( _WIN32 )
+	remove( mPath.c_str() );
+	#endif
+	if( rename( mTempPath.c_str(), mPath.c_str() ) != 0 )
+	{
+		printf( "Unable to write telemetry to %s!\n", mPath.c_str() );
+		return false;
+	}
+
+	return true;
+}
+
+void Telemetry::flushLoop()
+{
+	std::unique_lock<std::mutex> guard( mLock );
+	for( ;; )
+	{
+		mWake.wait_for( guard, std::chrono::milliseconds( mInterval ), [ this ]{ return mQuit; } );
+		if( mQuit )
+		{
+			return;
+		}
+
+		//Recording never waits on the export, only stop does
+		guard.unlock();
+		flush();
+		guard.lock();
+	}
+}
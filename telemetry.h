@@ -0,0 +1,128 @@
+//Low overhead counters and histograms exported in the background, usable without SDL
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+//What is counted
+enum TelemetryCounter
+{
+	TELEMETRY_FRAMES,
+	TELEMETRY_SHOTS,
+	TELEMETRY_WALL_BOUNCES,
+	TELEMETRY_HOLES,
+	TOTAL_TELEMETRY_COUNTERS
+};
+
+//What is measured
+enum TelemetryHistogram
+{
+	TELEMETRY_FRAME_TIME,
+	TELEMETRY_SETTLE_TIME,
+	TELEMETRY_HOLE_STROKES,
+	TOTAL_TELEMETRY_HISTOGRAMS
+};
+
+//Histogram buckets, each one holding values up to twice the last, the final one catching the rest
+const int TELEMETRY_BUCKETS = 24;
+
+//Threads that get a shard of their own, any past these share the last one
+const int TELEMETRY_MAX_THREADS = 64;
+
+//How often the background thread writes the totals out
+const int TELEMETRY_DEFAULT_INTERVAL_MS = 10000;
+
+//Space for one export of every metric
+const int TELEMETRY_BUFFER = 16384;
+
+//Gets the name a counter or histogram is exported under
+const char* getCounterName( int counter );
+const char* getHistogramName( int histogram );
+
+//Gets the largest value a histogram bucket holds
+uint64_t getBucketBound( int bucket );
+
+//Counts and measures on any thread without locks, a background thread exports the totals as OpenMetrics text
+class Telemetry
+{
+	public:
+		//Initializes variables
+		Telemetry();
+
+		//Stops the export after writing the final totals
+		~Telemetry();
+
+		//Starts recording and exporting to a file every interval, such as one a textfile collector scrapes
+		bool start( const std::string& path, int intervalMs = TELEMETRY_DEFAULT_INTERVAL_MS );
+
+		//Writes the final totals and stops the export, recording stops with it
+		void stop();
+
+		//Checks if metrics are being recorded
+		bool isEnabled() const;
+
+		//Adds to a counter on the calling thread's shard
+		void count( TelemetryCounter counter, uint64_t amount = 1 );
+
+		//Adds a sample to a histogram on the calling thread's shard
+		void observe( TelemetryHistogram histogram, uint64_t value );
+
+		//Gets a counter summed over every thread
+		uint64_t getCount( TelemetryCounter counter ) const;
+
+		//Writes the current totals out now
+		bool flush();
+
+	private:
+		//Telemetry can't be copied since it owns the export thread
+		Telemetry( const Telemetry& );
+		Telemetry& operator=( const Telemetry& );
+
+		//One thread's metrics, padded so threads never write the same cache line
+		struct Shard
+		{
+			std::atomic<uint64_t> counters[ TOTAL_TELEMETRY_COUNTERS ];
+			std::atomic<uint64_t> buckets[ TOTAL_TELEMETRY_HISTOGRAMS ][ TELEMETRY_BUCKETS ];
+			std::atomic<uint64_t> sums[ TOTAL_TELEMETRY_HISTOGRAMS ];
+			char padding[ 64 ];
+		};
+
+		//Gets the calling thread's shard, handing it one the first time
+		Shard* getShard();
+
+		//Exports every interval until stopped
+		void flushLoop();
+
+		//Whether recording is on, checked before anything else so disabled telemetry costs one load
+		std::atomic<bool> mEnabled;
+
+		//Told apart from other instances by the shard cache every thread keeps
+		uint32_t mId;
+
+		//The shards handed out so far
+		Shard* mShards[ TELEMETRY_MAX_THREADS ];
+		std::atomic<int> mShardCount;
+		std::mutex mShardLock;
+
+		//The export file and how often it's written
+		std::string mPath;
+		std::string mTempPath;
+		int mInterval;
+
+		//The export thread
+		std::thread mThread;
+		std::mutex mLock;
+		std::condition_variable mWake;
+		bool mQuit;
+
+		//Exports are formatted here so the export thread never touches the heap
+		char mBuffer[ TELEMETRY_BUFFER ];
+		std::mutex mFlushLock;
+};
+
+#endif
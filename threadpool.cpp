@@ -0,0 +1,165 @@
+//Work stealing thread pool
+#include "threadpool.h"
+
+ThreadPool::ThreadPool( int threads )
+{
+	//Initialize
+	if( threads <= 0 )
+	{
+		threads = std::thread::hardware_concurrency();
+	}
+	if( threads <= 0 )
+	{
+		threads = 1;
+	}
+
+	mTask = NULL;
+	mRemaining = 0;
+	mBusy = 0;
+	mGeneration = 0;
+	mQuit = false;
+
+	for( int i = 0; i < threads; ++i )
+	{
+		mQueues.push_back( new WorkQueue );
+	}
+
+	//The calling thread does its share as worker 0
+	for( int i = 1; i < threads; ++i )
+	{
+		mThreads.push_back( std::thread( &ThreadPool::workerLoop, this, i ) );
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	//Wake the workers up to quit
+	{
+		std::lock_guard<std::mutex> guard( mLock );
+		mQuit = true;
+	}
+	mStart.notify_all();
+
+	for( size_t i = 0; i < mThreads.size(); ++i )
+	{
+		mThreads[ i ].join();
+	}
+
+	for( size_t i = 0; i < mQueues.size(); ++i )
+	{
+		delete mQueues[ i ];
+	}
+}
+
+int ThreadPool::getThreadCount() const
+{
+	return (int)mQueues.size();
+}
+
+void ThreadPool::parallelFor( int count, const std::function<void( int, int )>& task )
+{
+	if( count <= 0 )
+	{
+		return;
+	}
+
+	int threads = getThreadCount();
+
+	//Deal out contiguous runs of tasks so neighbours stay on one worker
+	for( int worker = 0; worker < threads; ++worker )
+	{
+		int first = (int)( (long long)count * worker / threads );
+		int last = (int)( (long long)count * ( worker + 1 ) / threads );
+
+		std::lock_guard<std::mutex> guard( mQueues[ worker ]->lock );
+		for( int i = first; i < last; ++i )
+		{
+			mQueues[ worker ]->tasks.push_back( i );
+		}
+	}
+
+	//Start the job
+	{
+		std::lock_guard<std::mutex> guard( mLock );
+		mTask = &task;
+		mRemaining = count;
+		mBusy = threads;
+		++mGeneration;
+	}
+	mStart.notify_all();
+
+	drain( 0 );
+
+	//Wait until every worker let go of the task
+	std::unique_lock<std::mutex> guard( mLock );
+	mDone.wait( guard, [ this ]() { return mBusy == 0; } );
+	mTask = NULL;
+}
+
+void ThreadPool::workerLoop( int worker )
+{
+	unsigned int seen = 0;
+	while( true )
+	{
+		//Wait for the next job
+		{
+			std::unique_lock<std::mutex> guard( mLock );
+			mStart.wait( guard, [ this, seen ]() { return mQuit || mGeneration != seen; } );
+			if( mQuit )
+			{
+				return;
+			}
+			seen = mGeneration;
+		}
+
+		drain( worker );
+	}
+}
+
+void ThreadPool::drain( int worker )
+{
+	int task;
+	while( mRemaining > 0 && takeTask( worker, task ) )
+	{
+		( *mTask )( task, worker );
+		--mRemaining;
+	}
+
+	//Let parallelFor return once the last worker is done
+	std::lock_guard<std::mutex> guard( mLock );
+	if( --mBusy == 0 )
+	{
+		mDone.notify_all();
+	}
+}
+
+bool ThreadPool::takeTask( int worker, int& task )
+{
+	//Work from the back of our own queue
+	{
+		WorkQueue* own = mQueues[ worker ];
+		std::lock_guard<std::mutex> guard( own->lock );
+		if( !own->tasks.empty() )
+		{
+			task = own->tasks.back();
+			own->tasks.pop_back();
+			return true;
+		}
+	}
+
+	//Steal from the front of the others' queues
+	int threads = getThreadCount();
+	for( int i = 1; i < threads; ++i )
+	{
+		WorkQueue* victim = mQueues[ ( worker + i ) % threads ];
+		std::lock_guard<std::mutex> guard( victim->lock );
+		if( !victim->tasks.empty() )
+		{
+			task = victim->tasks.front();
+			victim->tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
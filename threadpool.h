@@ -0,0 +1,69 @@
+//Work stealing thread pool, usable without SDL
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//A fixed set of workers that steal tasks from each other's queues
+class ThreadPool
+{
+	public:
+		//Starts the workers, one per hardware thread when threads is 0
+		ThreadPool( int threads = 0 );
+
+		//Stops the workers
+		~ThreadPool();
+
+		//Gets the number of workers, counting the calling thread
+		int getThreadCount() const;
+
+		//Runs task( index, worker ) for every index below count and waits for all of them
+		void parallelFor( int count, const std::function<void( int, int )>& task );
+
+	private:
+		//Thread pools can't be copied
+		ThreadPool( const ThreadPool& );
+		ThreadPool& operator=( const ThreadPool& );
+
+		//The task indices queued for one worker
+		struct WorkQueue
+		{
+			std::mutex lock;
+			std::deque<int> tasks;
+		};
+
+		//Waits for jobs and works on them
+		void workerLoop( int worker );
+
+		//Runs tasks from the worker's own queue, then from the others', until none are left
+		void drain( int worker );
+
+		//Takes a task from the worker's own queue or steals one
+		bool takeTask( int worker, int& task );
+
+		//The spawned threads, the calling thread is worker 0
+		std::vector<std::thread> mThreads;
+
+		//One queue per worker
+		std::vector<WorkQueue*> mQueues;
+
+		//The current job
+		const std::function<void( int, int )>* mTask;
+		std::atomic<int> mRemaining;
+		std::atomic<int> mBusy;
+
+		//Job signalling
+		std::mutex mLock;
+		std::condition_variable mStart;
+		std::condition_variable mDone;
+		unsigned int mGeneration;
+		bool mQuit;
+};
+
+#endif
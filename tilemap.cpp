@@ -0,0 +1,523 @@
+//Packed tile storage
+#include "tilemap.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+//Skips whitespace and reads one unsigned integer from map text
+static bool readNumber( const char*& cursor, const char* end, int& number )
+{
+	//Skip separators
+	while( cursor < end && ( *cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n' ) )
+	{
+		++cursor;
+	}
+
+	//If there are no digits left
+	if( cursor == end || *cursor < '0' || *cursor > '9' )
+	{
+		return false;
+	}
+
+	//Accumulate digits, saturating so huge values stay invalid
+	int value = 0;
+	while( cursor < end && *cursor >= '0' && *cursor <= '9' )
+	{
+		if( value < MAX_MAP_TILES )
+		{
+			value = value * 10 + ( *cursor - '0' );
+		}
+		++cursor;
+	}
+
+	number = value;
+	return true;
+}
+
+//Reads a little endian 32 bit value
+static uint32_t readUint32( const uint8_t* bytes )
+{
+	return (uint32_t)bytes[ 0 ] | ( (uint32_t)bytes[ 1 ] << 8 ) | ( (uint32_t)bytes[ 2 ] << 16 ) | ( (uint32_t)bytes[ 3 ] << 24 );
+}
+
+//Writes a little endian 32 bit value
+static void writeUint32( uint8_t* bytes, uint32_t value )
+{
+	bytes[ 0 ] = value & 0xFF;
+	bytes[ 1 ] = ( value >> 8 ) & 0xFF;
+	bytes[ 2 ] = ( value >> 16 ) & 0xFF;
+	bytes[ 3 ] = ( value >> 24 ) & 0xFF;
+}
+
+//Hands out revisions, maps load on more than one thread
+static uint32_t getNextRevision()
+{
+	static std::atomic<uint32_t> revisions( 0 );
+	return ++revisions;
+}
+
+//Rounds a compiled map offset up to 8 bytes
+static size_t alignOffset( size_t offset )
+{
+	return ( offset + 7 ) & ~(size_t)7;
+}
+
+size_t getMaskSize( int totalTiles )
+{
+	return ( totalTiles + 7 ) / 8;
+}
+
+TileMap::TileMap()
+{
+	//Initialize
+	mTypes = NULL;
+	mWallMask = NULL;
+	mHoleMask = NULL;
+	mColumns = 0;
+	mRows = 0;
+	mRevision = getNextRevision();
+}
+
+bool TileMap::loadFromFile( const std::string& path )
+{
+	//Success flag
+	bool tilesLoaded = true;
+
+	//Get rid of preexisting tiles
+	free();
+
+	//Map the file
+	if( !mFile.open( path ) )
+	{
+		printf( "Unable to load map file!\n" );
+		tilesLoaded = false;
+	}
+	//Compiled maps are used straight from the mapping
+	else if( mFile.getSize() >= sizeof( MapHeader ) && memcmp( mFile.getData(), MAP_MAGIC, sizeof( MAP_MAGIC ) ) == 0 )
+	{
+		tilesLoaded = loadCompiled();
+	}
+	//Text maps are parsed out of the mapping
+	else
+	{
+		tilesLoaded = parseText( (const char*)mFile.getData(), mFile.getSize() );
+		mFile.close();
+	}
+
+	return tilesLoaded;
+}
+
+bool TileMap::loadCompiled()
+{
+	const uint8_t* data = mFile.getData();
+	size_t size = mFile.getSize();
+
+	//Read the header
+	uint32_t version = readUint32( data + 4 );
+	uint32_t columns = readUint32( data + 8 );
+	uint32_t rows = readUint32( data + 12 );
+	uint32_t typesOffset = readUint32( data + 16 );
+	uint32_t wallMaskOffset = readUint32( data + 20 );
+	uint32_t holeMaskOffset = readUint32( data + 24 );
+
+	if( version != MAP_VERSION )
+	{
+		printf( "Error loading map: Unsupported compiled map version %u!\n", version );
+		free();
+		return false;
+	}
+
+	if( columns == 0 || rows == 0 || columns >= (uint32_t)MAX_MAP_TILES || rows >= (uint32_t)MAX_MAP_TILES || (long long)columns * rows > MAX_TOTAL_TILES )
+	{
+		printf( "Error loading map: Invalid map dimensions %ux%u!\n", columns, rows );
+		free();
+		return false;
+	}
+
+	//Make sure every section lies inside the file
+	int totalTiles = columns * rows;
+	size_t maskSize = getMaskSize( totalTiles );
+	if( typesOffset > size || size - typesOffset < (size_t)totalTiles ||
+		wallMaskOffset > size || size - wallMaskOffset < maskSize ||
+		holeMaskOffset > size || size - holeMaskOffset < maskSize )
+	{
+		printf( "Error loading map: Compiled map is truncated!\n" );
+		free();
+		return false;
+	}
+
+	//Tile types index the sprite clips so they have to be in range, and collision trusts the masks to agree with them
+	const uint8_t* types = data + typesOffset;
+	const uint8_t* wallMask = data + wallMaskOffset;
+	const uint8_t* holeMask = data + holeMaskOffset;
+	for( int i = 0; i < totalTiles; ++i )
+	{
+		if( types[ i ] >= TOTAL_TILE_SPRITES )
+		{
+			printf( "Error loading map: Invalid tile type at %d!\n", i );
+			free();
+			return false;
+		}
+
+		bool wall = ( wallMask[ i >> 3 ] >> ( i & 7 ) ) & 1;
+		bool hole = ( holeMask[ i >> 3 ] >> ( i & 7 ) ) & 1;
+		if( wall != ( types[ i ] == TILE_BLACK ) || hole != ( types[ i ] == TILE_YELLOW ) )
+		{
+			printf( "Error loading map: Collision masks disagree with the tile type at %d!\n", i );
+			free();
+			return false;
+		}
+	}
+
+	mTypes = types;
+	mWallMask = wallMask;
+	mHoleMask = holeMask;
+	mColumns = columns;
+	mRows = rows;
+	mRevision = getNextRevision();
+
+	return true;
+}
+
+bool TileMap::saveCompiled( const std::string& path ) const
+{
+	//Lay out the header, types and masks
+	int totalTiles = getTotalTiles();
+	size_t maskSize = getMaskSize( totalTiles );
+	size_t typesOffset = sizeof( MapHeader );
+	size_t wallMaskOffset = alignOffset( typesOffset + totalTiles );
+	size_t holeMaskOffset = alignOffset( wallMaskOffset + maskSize );
+
+	uint8_t header[ sizeof( MapHeader ) ] = { 0 };
+	memcpy( header, MAP_MAGIC, sizeof( MAP_MAGIC ) );
+	writeUint32( header + 4, MAP_VERSION );
+	writeUint32( header + 8, mColumns );
+	writeUint32( header + 12, mRows );
+	writeUint32( header + 16, typesOffset );
+	writeUint32( header + 20, wallMaskOffset );
+	writeUint32( header + 24, holeMaskOffset );
+
+	FILE* file = fopen( path.c_str(), "wb" );
+	if( file == NULL )
+	{
+		printf( "Unable to write compiled map %s!\n", path.c_str() );
+		return false;
+	}
+
+	//Write each section, padding up to the next offset
+	static const uint8_t padding[ 8 ] = { 0 };
+	bool written = fwrite( header, 1, sizeof( header ), file ) == sizeof( header );
+	written = written && fwrite( mTypes, 1, totalTiles, file ) == (size_t)totalTiles;
+	written = written && fwrite( padding, 1, wallMaskOffset - typesOffset - totalTiles, file ) == wallMaskOffset - typesOffset - totalTiles;
+	written = written && fwrite( mWallMask, 1, maskSize, file ) == maskSize;
+	written = written && fwrite( padding, 1, holeMaskOffset - wallMaskOffset - maskSize, file ) == holeMaskOffset - wallMaskOffset - maskSize;
+	written = written && fwrite( mHoleMask, 1, maskSize, file ) == maskSize;
+
+	if( fclose( file ) != 0 || !written )
+	{
+		printf( "Unable to write compiled map %s!\n", path.c_str() );
+		return false;
+	}
+
+	return true;
+}
+
+void TileMap::allocate( int columns, int rows )
+{
+	//Types followed by the wall and hole masks
+	int totalTiles = columns * rows;
+	size_t maskSize = getMaskSize( totalTiles );
+	uint8_t* storage = mStorage.allocate<uint8_t>( totalTiles + maskSize * 2 );
+	memset( storage, 0, totalTiles + maskSize * 2 );
+
+	mTypes = storage;
+	mWallMask = mTypes + totalTiles;
+	mHoleMask = mWallMask + maskSize;
+	mColumns = columns;
+	mRows = rows;
+	mRevision = getNextRevision();
+}
+
+bool TileMap::loadFromText( const char* text, size_t length )
+{
+	//Get rid of preexisting tiles
+	free();
+
+	return parseText( text, length );
+}
+
+bool TileMap::loadFromTypes( int columns, int rows, const uint8_t* types )
+{
+	//Get rid of preexisting tiles
+	free();
+
+	if( columns <= 0 || rows <= 0 || columns >= MAX_MAP_TILES || rows >= MAX_MAP_TILES || (long long)columns * rows > MAX_TOTAL_TILES )
+	{
+		printf( "Error loading map: Invalid map dimensions %dx%d!\n", columns, rows );
+		return false;
+	}
+
+	allocate( columns, rows );
+	int totalTiles = columns * rows;
+	uint8_t* storedTypes = (uint8_t*)mTypes;
+	uint8_t* wallMask = storedTypes + totalTiles;
+	uint8_t* holeMask = wallMask + getMaskSize( totalTiles );
+	for( int i = 0; i < totalTiles; ++i )
+	{
+		if( types[ i ] >= TOTAL_TILE_SPRITES )
+		{
+			printf( "Error loading map: Invalid tile type at %d!\n", i );
+			free();
+			return false;
+		}
+
+		//Precompute the collision masks
+		storedTypes[ i ] = types[ i ];
+		if( types[ i ] == TILE_BLACK )
+		{
+			wallMask[ i >> 3 ] |= 1 << ( i & 7 );
+		}
+		else if( types[ i ] == TILE_YELLOW )
+		{
+			holeMask[ i >> 3 ] |= 1 << ( i & 7 );
+		}
+	}
+
+	return true;
+}
+
+bool TileMap::parseText( const char* text, size_t length )
+{
+	//Success flag
+	bool tilesLoaded = true;
+
+	const char* cursor = text;
+	const char* end = text + length;
+
+	//Read the map dimensions
+	int columns = 0, rows = 0;
+	if( !readNumber( cursor, end, columns ) || !readNumber( cursor, end, rows ) )
+	{
+		printf( "Error loading map: Missing map dimensions!\n" );
+		tilesLoaded = false;
+	}
+	else if( columns <= 0 || rows <= 0 || columns >= MAX_MAP_TILES || rows >= MAX_MAP_TILES || (long long)columns * rows > MAX_TOTAL_TILES )
+	{
+		printf( "Error loading map: Invalid map dimensions %dx%d!\n", columns, rows );
+		tilesLoaded = false;
+	}
+	else
+	{
+		//Allocate all the tiles at once
+		allocate( columns, rows );
+		int totalTiles = columns * rows;
+		uint8_t* types = (uint8_t*)mTypes;
+		uint8_t* wallMask = types + totalTiles;
+		uint8_t* holeMask = wallMask + getMaskSize( totalTiles );
+
+		//Initialize the tiles
+		for( int i = 0; i < totalTiles; ++i )
+		{
+			//Determines what kind of tile will be made
+			int tileType = -1;
+
+			//If the was a problem in reading the map
+			if( !readNumber( cursor, end, tileType ) )
+			{
+				//Stop loading map
+				printf( "Error loading map: Unexpected end of file!\n" );
+				tilesLoaded = false;
+				break;
+			}
+
+			//If the number is a valid tile number
+			if( ( tileType >= 0 ) && ( tileType < TOTAL_TILE_SPRITES ) )
+			{
+				types[ i ] = (uint8_t)tileType;
+
+				//Precompute the collision masks
+				if( tileType == TILE_BLACK )
+				{
+					wallMask[ i >> 3 ] |= 1 << ( i & 7 );
+				}
+				else if( tileType == TILE_YELLOW )
+				{
+					holeMask[ i >> 3 ] |= 1 << ( i & 7 );
+				}
+			}
+			//If we don't recognize the tile type
+			else
+			{
+				//Stop loading map
+				printf( "Error loading map: Invalid tile type at %d!\n", i );
+				tilesLoaded = false;
+				break;
+			}
+		}
+	}
+
+	//Don't keep a partial map around
+	if( !tilesLoaded )
+	{
+		free();
+	}
+
+	return tilesLoaded;
+}
+
+void TileMap::free()
+{
+	mFile.close();
+	mStorage.reset();
+	mTypes = NULL;
+	mWallMask = NULL;
+	mHoleMask = NULL;
+	mColumns = 0;
+	mRows = 0;
+	mRevision = getNextRevision();
+}
+
+int TileMap::getTotalTiles() const
+{
+	return mColumns * mRows;
+}
+
+int TileMap::getColumns() const
+{
+	return mColumns;
+}
+
+int TileMap::getRows() const
+{
+	return mRows;
+}
+
+int TileMap::getWidth() const
+{
+	return mColumns * TILE_WIDTH;
+}
+
+int TileMap::getHeight() const
+{
+	return mRows * TILE_HEIGHT;
+}
+
+int TileMap::getType( int i ) const
+{
+	return mTypes[ i ];
+}
+
+Rect TileMap::getBox( int i ) const
+{
+	//Tiles are laid out row major across the level
+	Rect box = { ( i % mColumns ) * TILE_WIDTH, ( i / mColumns ) * TILE_HEIGHT, TILE_WIDTH, TILE_HEIGHT };
+	return box;
+}
+
+bool TileMap::isWall( int i ) const
+{
+	return ( mWallMask[ i >> 3 ] >> ( i & 7 ) ) & 1;
+}
+
+bool TileMap::isHole( int i ) const
+{
+	return ( mHoleMask[ i >> 3 ] >> ( i & 7 ) ) & 1;
+}
+
+const uint8_t* TileMap::getTypes() const
+{
+	return mTypes;
+}
+
+const uint8_t* TileMap::getWallMask() const
+{
+	return mWallMask;
+}
+
+const uint8_t* TileMap::getHoleMask() const
+{
+	return mHoleMask;
+}
+
+bool TileMap::isMapped() const
+{
+	return mTypes != NULL && mStorage.getUsed() == 0;
+}
+
+uint32_t TileMap::getRevision() const
+{
+	return mRevision;
+}
+
+void TileMap::swap( TileMap& other )
+{
+	//Parsed tiles point into storage whose blocks move with the arena
+	mFile.swap( other.mFile );
+	mStorage.swap( other.mStorage );
+	std::swap( mTypes, other.mTypes );
+	std::swap( mWallMask, other.mWallMask );
+	std::swap( mHoleMask, other.mHoleMask );
+	std::swap( mColumns, other.mColumns );
+	std::swap( mRows, other.mRows );
+	std::swap( mRevision, other.mRevision );
+}
+
+bool TileMap::diff( const TileMap& other, std::vector<int>& changed ) const
+{
+	changed.clear();
+	if( mColumns != other.mColumns || mRows != other.mRows )
+	{
+		return false;
+	}
+
+	//Edits are usually a few tiles so whole words are compared before single tiles
+	int totalTiles = getTotalTiles();
+	int i = 0;
+	for( ; i + 8 <= totalTiles; i += 8 )
+	{
+		if( memcmp( mTypes + i, other.mTypes + i, 8 ) == 0 )
+		{
+			continue;
+		}
+		for( int j = i; j < i + 8; ++j )
+		{
+			if( mTypes[ j ] != other.mTypes[ j ] )
+			{
+				changed.push_back( j );
+			}
+		}
+	}
+	for( ; i < totalTiles; ++i )
+	{
+		if( mTypes[ i ] != other.mTypes[ i ] )
+		{
+			changed.push_back( i );
+		}
+	}
+
+	return true;
+}
+
+bool TileMap::setType( int i, int type )
+{
+	//Mapped tiles are read only and unknown types have no sprite
+	if( isMapped() || i < 0 || i >= getTotalTiles() || type < 0 || type >= TOTAL_TILE_SPRITES )
+	{
+		return false;
+	}
+
+	uint8_t* types = (uint8_t*)mTypes;
+	uint8_t* wallMask = (uint8_t*)mWallMask;
+	uint8_t* holeMask = (uint8_t*)mHoleMask;
+	types[ i ] = (uint8_t)type;
+
+	//Keep the collision masks in step
+	uint8_t bit = 1 << ( i & 7 );
+	wallMask[ i >> 3 ] = type == TILE_BLACK ? wallMask[ i >> 3 ] | bit : wallMask[ i >> 3 ] & ~bit;
+	holeMask[ i >> 3 ] = type == TILE_YELLOW ? holeMask[ i >> 3 ] | bit : holeMask[ i >> 3 ] & ~bit;
+
+	//Anything cached from the old tiles has to notice
+	mRevision = getNextRevision();
+	return true;
+}
@@ -0,0 +1,157 @@
+//Packed tile storage, usable without SDL
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+#include "arena.h"
+
+//Tile constants
+const int TILE_WIDTH = 80;
+const int TILE_HEIGHT = 80;
+const int TOTAL_TILE_SPRITES = 3;
+
+//Largest map dimension in tiles
+const int MAX_MAP_TILES = 65536;
+
+//Largest number of tiles in a map
+const int MAX_TOTAL_TILES = 1 << 26;
+
+//The different tile sprite
+const int TILE_BLACK = 0;
+const int TILE_GREEN = 1;
+const int TILE_YELLOW = 2;
+
+//Compiled map file identification
+const char MAP_MAGIC[ 4 ] = { 'G', 'M', 'A', 'P' };
+const uint32_t MAP_VERSION = 1;
+
+//The fixed size header at the start of a compiled map, stored little endian
+struct MapHeader
+{
+	char magic[ 4 ];
+	uint32_t version;
+
+	//The grid dimensions
+	uint32_t columns;
+	uint32_t rows;
+
+	//Byte offsets of the tile types and the one bit per tile masks
+	uint32_t typesOffset;
+	uint32_t wallMaskOffset;
+	uint32_t holeMaskOffset;
+	uint32_t reserved;
+};
+
+//An integer box laid out like SDL_Rect
+struct Rect
+{
+	int x, y;
+	int w, h;
+};
+
+//A grid of tiles stored as one byte per tile
+class TileMap
+{
+	public:
+		//Initializes variables
+		TileMap();
+
+		//Loads a text or compiled map file
+		bool loadFromFile( const std::string& path );
+
+		//Parses tile types from map text
+		bool loadFromText( const char* text, size_t length );
+
+		//Copies tile types laid out row major, such as a generated map's
+		bool loadFromTypes( int columns, int rows, const uint8_t* types );
+
+		//Writes the map in compiled form
+		bool saveCompiled( const std::string& path ) const;
+
+		//Deallocates tiles
+		void free();
+
+		//Gets the number of tiles
+		int getTotalTiles() const;
+
+		//Gets the grid dimensions in tiles
+		int getColumns() const;
+		int getRows() const;
+
+		//Gets the map dimensions in pixels
+		int getWidth() const;
+		int getHeight() const;
+
+		//Get the tile type
+		int getType( int i ) const;
+
+		//Get the collision box
+		Rect getBox( int i ) const;
+
+		//Checks the precomputed masks
+		bool isWall( int i ) const;
+		bool isHole( int i ) const;
+
+		//Gets the packed tile types in row major order
+		const uint8_t* getTypes() const;
+
+		//Gets the one bit per tile masks, lowest bit first
+		const uint8_t* getWallMask() const;
+		const uint8_t* getHoleMask() const;
+
+		//Checks if the tiles point straight into a mapped compiled file
+		bool isMapped() const;
+
+		//Gets a number that changes whenever the tiles do, so caches built from them can tell they're stale
+		uint32_t getRevision() const;
+
+		//Exchanges tiles with another map
+		void swap( TileMap& other );
+
+		//Lists the tiles whose type differs in another map of the same size, false if the sizes differ
+		bool diff( const TileMap& other, std::vector<int>& changed ) const;
+
+		//Changes one parsed tile along with its masks, false for mapped tiles or unknown types
+		bool setType( int i, int type );
+
+	private:
+		//Maps can't be copied since they may point into a mapping
+		TileMap( const TileMap& );
+		TileMap& operator=( const TileMap& );
+
+		//Uses a mapped compiled map in place
+		bool loadCompiled();
+
+		//Parses map text into storage
+		bool parseText( const char* text, size_t length );
+
+		//Allocates storage for parsed tiles and their masks in one block
+		void allocate( int columns, int rows );
+
+		//The mapping backing compiled maps
+		MappedFile mFile;
+
+		//The storage backing parsed maps, reset rather than freed between levels
+		Arena mStorage;
+
+		//The tile types and masks, in the mapping or in storage
+		const uint8_t* mTypes;
+		const uint8_t* mWallMask;
+		const uint8_t* mHoleMask;
+
+		//The grid dimensions
+		int mColumns;
+		int mRows;
+
+		//Unique to the current tiles
+		uint32_t mRevision;
+};
+
+//Gets the size in bytes of a one bit per tile mask
+size_t getMaskSize( int totalTiles );
+
+#endif
@@ -0,0 +1,279 @@
+//Shot paths predicted on a worker thread while the player aims
+#include "trajectory.h"
+#include <cmath>
+#include <algorithm>
+
+//The flag set on the handed over path until the render side takes it
+static const int PATH_FRESH = 4;
+static const int PATH_INDEX = 3;
+
+//Velocities this close to parallel count as a ball still rolling free
+static const float FREE_ROLL_TOLERANCE = 1e-4f;
+
+TrajectoryPredictor::TrajectoryPredictor() : mLatest( 0 ), mReady( 1 )
+{
+	//Initialize
+	mCourse = NULL;
+	mPending = false;
+	mQuit = false;
+	mCancelled = 0;
+	mBack = 0;
+	mFront = 2;
+	for( int i = 0; i < 3; ++i )
+	{
+		mPaths[ i ].request = 0;
+		mPaths[ i ].count = 0;
+		mPaths[ i ].holed = false;
+		mPaths[ i ].reused = 0;
+	}
+	mRequest.id = 0;
+	mRequest.start = makeBall( 0, 0 );
+	mRequest.velX = 0;
+	mRequest.velY = 0;
+	mLast = mRequest;
+	mFreePoints = 0;
+}
+
+TrajectoryPredictor::~TrajectoryPredictor()
+{
+	//Deallocate
+	stop();
+}
+
+void TrajectoryPredictor::start( const Course& course )
+{
+	stop();
+
+	//Nothing predicted on another course carries over
+	mCourse = &course;
+	mQuit = false;
+	mPending = false;
+	mLast.id = 0;
+	mFreePoints = 0;
+	mThread = std::thread( &TrajectoryPredictor::workerLoop, this );
+}
+
+void TrajectoryPredictor::stop()
+{
+	if( !mThread.joinable() )
+	{
+		return;
+	}
+
+	//A newer request makes the worker give up on the one it's on
+	{
+		std::lock_guard<std::mutex> guard( mLock );
+		mQuit = true;
+		mPending = false;
+		mLatest.store( mLatest.load() + 1 );
+	}
+	mWake.notify_one();
+	mThread.join();
+
+	//Paths from the old course are hidden
+	mCancelled = mLatest.load();
+}
+
+void TrajectoryPredictor::request( const BallState& start, float velX, float velY )
+{
+	{
+		std::lock_guard<std::mutex> guard( mLock );
+
+		//The same shot again keeps the path that's shown or being worked on
+		if( mRequest.id > mCancelled && mRequest.id == mLatest.load() && mRequest.start.posX == start.posX && mRequest.start.posY == start.posY &&
+			mRequest.velX == velX && mRequest.velY == velY )
+		{
+			return;
+		}
+
+		mRequest.id = mLatest.load() + 1;
+		mRequest.start = start;
+		mRequest.velX = velX;
+		mRequest.velY = velY;
+		mLatest.store( mRequest.id );
+		mPending = true;
+	}
+	mWake.notify_one();
+}
+
+void TrajectoryPredictor::cancel()
+{
+	if( mCancelled == mLatest.load() )
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard( mLock );
+	mCancelled = mLatest.load() + 1;
+	mLatest.store( mCancelled );
+	mPending = false;
+}
+
+const PredictedPath* TrajectoryPredictor::getPath()
+{
+	//Take the newest path if the worker handed one over, giving it back the one read before
+	if( mReady.load() & PATH_FRESH )
+	{
+		mFront = mReady.exchange( mFront ) & PATH_INDEX;
+	}
+
+	const PredictedPath& path = mPaths[ mFront ];
+	if( path.request == 0 || path.request <= mCancelled )
+	{
+		return NULL;
+	}
+	return &path;
+}
+
+bool TrajectoryPredictor::isPredicting() const
+{
+	//A handed over path is there to be taken, so only an empty hand off with an older path in front is still waiting
+	uint32_t latest = mLatest.load();
+	return latest != mCancelled && ( mReady.load() & PATH_FRESH ) == 0 && mPaths[ mFront ].request != latest;
+}
+
+void TrajectoryPredictor::workerLoop()
+{
+	for( ;; )
+	{
+		//Sleep until there's a shot to predict
+		Request request;
+		{
+			std::unique_lock<std::mutex> guard( mLock );
+			mWake.wait( guard, [ this ]{ return mQuit || mPending; } );
+			if( mQuit )
+			{
+				return;
+			}
+			request = mRequest;
+			mPending = false;
+		}
+
+		if( predict( request, mPaths[ mBack ] ) )
+		{
+			publish();
+		}
+	}
+}
+
+int TrajectoryPredictor::getReusablePoints( const Request& request ) const
+{
+	//Only a shot from the same spot can follow the last one's path
+	if( mLast.id == 0 || mLast.start.posX != request.start.posX || mLast.start.posY != request.start.posY )
+	{
+		return 1;
+	}
+
+	float hitX = request.start.velX + request.velX;
+	float hitY = request.start.velY + request.velY;
+	float changeX = hitX - ( mLast.start.velX + mLast.velX );
+	float changeY = hitY - ( mLast.start.velY + mLast.velY );
+	float change = sqrt( changeX * changeX + changeY * changeY );
+
+	for( int point = 1; point < mFreePoints; ++point )
+	{
+		//A softer shot may come to rest sooner
+		float velX = hitX * mDecay[ point ];
+		float velY = hitY * mDecay[ point ];
+		if( velX < BALL_REST_VEL && velX > -BALL_REST_VEL && velY < BALL_REST_VEL && velY > -BALL_REST_VEL )
+		{
+			return point;
+		}
+
+		//The two paths part further the longer they roll
+		if( change * mTravel[ point ] > PREDICT_REUSE_ERROR )
+		{
+			return point;
+		}
+	}
+
+	return std::max( mFreePoints, 1 );
+}
+
+bool TrajectoryPredictor::predict( const Request& request, PredictedPath& path )
+{
+	BallState ball = request.start;
+	ball.velX += request.velX;
+	ball.velY += request.velY;
+	float hitX = ball.velX;
+	float hitY = ball.velY;
+	float hitSpeed = hitX * hitX + hitY * hitY;
+
+	path.request = request.id;
+	path.holed = false;
+	path.points[ 0 ].x = ball.posX;
+	path.points[ 0 ].y = ball.posY;
+
+	//Until the first bounce a rolling ball's offset and velocity are the hit scaled by amounts that don't depend on it,
+	//so that much of the last path is rebuilt rather than simulated
+	int reused = hitSpeed > 0 ? getReusablePoints( request ) : 1;
+	for( int point = 1; point < reused; ++point )
+	{
+		path.points[ point ].x = request.start.posX + hitX * mTravel[ point ];
+		path.points[ point ].y = request.start.posY + hitY * mTravel[ point ];
+	}
+	if( reused > 1 )
+	{
+		ball.posX = path.points[ reused - 1 ].x;
+		ball.posY = path.points[ reused - 1 ].y;
+		ball.velX = hitX * mDecay[ reused - 1 ];
+		ball.velY = hitY * mDecay[ reused - 1 ];
+	}
+	path.count = reused;
+	path.reused = reused;
+
+	//The scaling stays right for the reused points whatever is simulated next
+	mLast = request;
+	mFreePoints = reused;
+	mTravel[ 0 ] = 0;
+	mDecay[ 0 ] = 1;
+	bool rolling = hitSpeed > 0;
+
+	int steps = ( reused - 1 ) * PREDICT_SAMPLE_STEPS;
+	while( hitSpeed > 0 && steps < PREDICT_MAX_STEPS )
+	{
+		step( ball, *mCourse );
+		++steps;
+
+		//Any bounce, drop or stop ends the free roll
+		bool over = ball.touchingHole || isAtRest( ball );
+		if( rolling )
+		{
+			float along = ball.velX * hitX + ball.velY * hitY;
+			float across = ball.velX * hitY - ball.velY * hitX;
+			rolling = !over && along > 0 && fabs( across ) <= FREE_ROLL_TOLERANCE * hitSpeed;
+		}
+
+		if( steps % PREDICT_SAMPLE_STEPS == 0 || over )
+		{
+			PathPoint point = { ball.posX, ball.posY };
+			path.points[ path.count ] = point;
+			if( rolling && steps % PREDICT_SAMPLE_STEPS == 0 )
+			{
+				mTravel[ path.count ] = ( ( ball.posX - request.start.posX ) * hitX + ( ball.posY - request.start.posY ) * hitY ) / hitSpeed;
+				mDecay[ path.count ] = ( ball.velX * hitX + ball.velY * hitY ) / hitSpeed;
+				mFreePoints = path.count + 1;
+			}
+			++path.count;
+		}
+		if( over )
+		{
+			break;
+		}
+
+		//Give up as soon as the player aims somewhere else
+		if( steps % PREDICT_CANCEL_STEPS == 0 && mLatest.load() != request.id )
+		{
+			return false;
+		}
+	}
+
+	path.holed = ball.touchingHole;
+	return true;
+}
+
+void TrajectoryPredictor::publish()
+{
+	//Swap the written path in and take back whichever one was waiting
+	mBack = mReady.exchange( mBack | PATH_FRESH ) & PATH_INDEX;
+}
@@ -0,0 +1,135 @@
+//Shot paths predicted on a worker thread while the player aims, usable without SDL
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "physics.h"
+
+//Physics steps between the points of a predicted path
+const int PREDICT_SAMPLE_STEPS = 4;
+
+//Longest stretch of a shot that's predicted
+const int PREDICT_MAX_STEPS = PHYSICS_TICK_RATE * 8;
+
+//Points a path can hold, the start and end included
+const int PREDICT_MAX_POINTS = PREDICT_MAX_STEPS / PREDICT_SAMPLE_STEPS + 2;
+
+//Steps simulated between checks for a newer request
+const int PREDICT_CANCEL_STEPS = 64;
+
+//How far in pixels a reused point may stray from where the new shot goes
+const float PREDICT_REUSE_ERROR = 0.5f;
+
+//A point along a predicted path
+struct PathPoint
+{
+	float x, y;
+};
+
+//Where a shot is predicted to go
+struct PredictedPath
+{
+	//The request this answers
+	uint32_t request;
+
+	//The ball's center every few steps from the start
+	PathPoint points[ PREDICT_MAX_POINTS ];
+	int count;
+
+	//Whether the shot ends in the hole
+	bool holed;
+
+	//Points taken from the previous path rather than simulated
+	int reused;
+};
+
+//Predicts the path of the shot being aimed without ever holding up the caller
+class TrajectoryPredictor
+{
+	public:
+		//Initializes variables
+		TrajectoryPredictor();
+
+		//Stops the worker
+		~TrajectoryPredictor();
+
+		//Starts predicting on a course, which must not change until stop is called
+		void start( const Course& course );
+
+		//Waits for the worker to finish, before the course changes or goes away
+		void stop();
+
+		//Asks for the path of a ball hit with a velocity, dropping older requests
+		void request( const BallState& start, float velX, float velY );
+
+		//Drops any request and hides the path
+		void cancel();
+
+		//Gets the newest path, which stays valid until the next call, NULL if there's none to show
+		const PredictedPath* getPath();
+
+		//Checks if the newest request's path is still being worked on
+		bool isPredicting() const;
+
+	private:
+		//Predictors can't be copied since they own a thread
+		TrajectoryPredictor( const TrajectoryPredictor& );
+		TrajectoryPredictor& operator=( const TrajectoryPredictor& );
+
+		//A shot to predict
+		struct Request
+		{
+			uint32_t id;
+			BallState start;
+			float velX, velY;
+		};
+
+		//Takes requests until stopped
+		void workerLoop();
+
+		//Fills a path for a request, false if a newer one came in first
+		bool predict( const Request& request, PredictedPath& path );
+
+		//Gets the points of the last path a request can take over
+		int getReusablePoints( const Request& request ) const;
+
+		//Hands the written path to the render side
+		void publish();
+
+		//The course being played
+		const Course* mCourse;
+
+		//The worker and the request waiting for it
+		std::thread mThread;
+		std::mutex mLock;
+		std::condition_variable mWake;
+		Request mRequest;
+		bool mPending;
+		bool mQuit;
+
+		//The newest request, which the worker checks to give up on older ones
+		std::atomic<uint32_t> mLatest;
+
+		//The render side's last cancel, paths up to it are hidden
+		uint32_t mCancelled;
+
+		//Three paths, the worker writes one while the render side reads another
+		PredictedPath mPaths[ 3 ];
+		int mBack;
+		int mFront;
+
+		//The path handed over last, with a flag set until the render side takes it
+		std::atomic<int> mReady;
+
+		//The last request predicted and how its free rolling start scales with the hit
+		Request mLast;
+		int mFreePoints;
+		float mTravel[ PREDICT_MAX_POINTS ];
+		float mDecay[ PREDICT_MAX_POINTS ];
+};
+
+#endif